@@ -16,18 +16,37 @@ packagesExist(qt5-boostable) {
     warning("qt5-boostable not available; startup times will be slower")
 }
 
+packagesExist(liburing) {
+    DEFINES += HAS_LIBURING
+    PKGCONFIG += liburing
+} else {
+    warning("liburing not available; files will be copied and deleted by threads only")
+}
+
 system(qdbusxml2cpp -c FileOperationsAdaptor -a fileoperationsadaptor.h:fileoperationsadaptor.cpp ../../dbus/org.nemomobile.FileOperations.xml)
 
 HEADERS =\
+    copypipeline.h \
+    directoryreader.h \
     fileoperationsadaptor.h \
     fileoperationsservice.h \
-    fileoperations.h
+    fileoperations.h \
+    trash.h \
+    treeremover.h \
+    treescanner.h \
+    uringengine.h
 
 SOURCES =\
+    copypipeline.cpp \
+    directoryreader.cpp \
     fileoperationsadaptor.cpp \
     fileoperationsservice.cpp \
     fileoperations.cpp \
-    main.cpp
+    main.cpp \
+    trash.cpp \
+    treeremover.cpp \
+    treescanner.cpp \
+    uringengine.cpp
 
 INCLUDEPATH += ../plugin ../shared
 VPATH += ../shared
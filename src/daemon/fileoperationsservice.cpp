@@ -33,6 +33,7 @@
 #include "fileoperationsservice.h"
 #include "fileoperationsadaptor.h"
 #include "fileoperations.h"
+#include "trash.h"
 
 namespace {
 
@@ -44,13 +45,14 @@ const int LingerTimeMs = 2 * 60 * 1000;
 
 struct OperationRequest
 {
-    enum Type { Copy, Move, Delete, Mkdir, Rename, SetPermissions };
+    enum Type { Copy, Move, Delete, Restore, Mkdir, Rename, SetPermissions };
 
     unsigned id;
     Type type;
     QStringList paths;
     QString destination;
     unsigned mask;
+    FileEngine::DeletePolicy policy;
 };
 
 struct OperationResponse
@@ -106,6 +108,9 @@ FileOperationsService::FileOperationsService()
 
     connect(this, &FileOperationsService::requestCompleted, this, &FileOperationsService::requestFinished, Qt::QueuedConnection);
 
+    qRegisterMetaType<FileOperations::Progress>();
+    connect(this, &FileOperationsService::progressReported, this, &FileOperationsService::reportProgress, Qt::QueuedConnection);
+
     // Create worker threads to perform the file opertaions
     for (int i = 0, n = QThread::idealThreadCount() * 2; i < n; ++i) {
         WorkerThread *thread = new WorkerThread(this);
@@ -141,6 +146,28 @@ unsigned FileOperationsService::Delete(const QStringList &paths)
 
     request.type = OperationRequest::Delete;
     request.paths = paths;
+    request.policy = FileEngine::DeletePermanently;
+
+    return enqueueRequest(request);
+}
+
+unsigned FileOperationsService::DeleteWithPolicy(const QStringList &paths, unsigned policy)
+{
+    OperationRequest request;
+
+    request.type = OperationRequest::Delete;
+    request.paths = paths;
+    request.policy = static_cast<FileEngine::DeletePolicy>(policy);
+
+    return enqueueRequest(request, policy <= FileEngine::MoveToTrash);
+}
+
+unsigned FileOperationsService::Restore(const QStringList &paths)
+{
+    OperationRequest request;
+
+    request.type = OperationRequest::Restore;
+    request.paths = paths;
 
     return enqueueRequest(request);
 }
@@ -288,6 +315,14 @@ void FileOperationsService::requestFinished(unsigned id)
     }
 }
 
+void FileOperationsService::reportProgress(unsigned id, const FileOperations::Progress &progress)
+{
+    emit adaptor->Progress(id, progress.bytesDone, progress.bytesTotal,
+                           progress.filesDone, progress.filesTotal,
+                           progress.currentPath, progress.bytesPerSecond,
+                           progress.secondsRemaining);
+}
+
 void FileOperationsService::processRequests()
 {
     while (true) {
@@ -336,18 +371,26 @@ void FileOperationsService::processOperation(OperationRequest *request, Operatio
             response->failedPaths.append(path);
         }
     };
+    const unsigned id = request->id;
+    FileOperations::ProgressFunc progressFn = [this, id](const FileOperations::Progress &progress) {
+        emit progressReported(id, progress);
+    };
 
     switch (request->type) {
     case OperationRequest::Copy:
-        response->error = FileOperations::copyFiles(request->paths, request->destination, pathResultFn, continueFn);
+        response->error = FileOperations::copyFiles(request->paths, request->destination, pathResultFn, continueFn, progressFn);
         break;
 
     case OperationRequest::Move:
-        response->error = FileOperations::moveFiles(request->paths, request->destination, pathResultFn, continueFn);
+        response->error = FileOperations::moveFiles(request->paths, request->destination, pathResultFn, continueFn, progressFn);
         break;
 
     case OperationRequest::Delete:
-        response->error = FileOperations::deleteFiles(request->paths, pathResultFn, continueFn);
+        response->error = FileOperations::deleteFiles(request->paths, pathResultFn, continueFn, progressFn, request->policy);
+        break;
+
+    case OperationRequest::Restore:
+        response->error = FileOperations::restoreFiles(request->paths, pathResultFn);
         break;
 
     case OperationRequest::Mkdir:
@@ -369,6 +412,12 @@ void FileOperationsService::timerEvent(QTimerEvent *event)
     if (event->timerId() == timer.timerId()) {
         timer.stop();
 
+        if (Trash::isPurging()) {
+            // deleted files are still being removed in the background
+            timer.start(LingerTimeMs, this);
+            return;
+        }
+
         qWarning() << "FileOperationsService expired after linger period";
 
         {
@@ -41,6 +41,7 @@
 #include <QStringList>
 #include <QWaitCondition>
 
+#include "fileoperations.h"
 
 class FileOperationsAdaptor;
 
@@ -55,12 +56,15 @@ public:
 
 signals:
     void requestCompleted(unsigned id);
+    void progressReported(unsigned id, const FileOperations::Progress &progress);
     void serviceExpired();
 
 public slots:
     unsigned Copy(const QStringList &paths, const QString &destination);
     unsigned Move(const QStringList &paths, const QString &destination);
     unsigned Delete(const QStringList &paths);
+    unsigned DeleteWithPolicy(const QStringList &paths, unsigned policy);
+    unsigned Restore(const QStringList &paths);
     unsigned Mkdir(const QString &path, const QString &destination);
     unsigned Rename(const QString &oldPath, const QString &newPath);
     unsigned SetPermissions(const QString &path, unsigned mask);
@@ -69,6 +73,7 @@ public slots:
 
 private slots:
     void requestFinished(unsigned id);
+    void reportProgress(unsigned id, const FileOperations::Progress &progress);
 
 private:
     friend class WorkerThread;
@@ -65,28 +65,10 @@ void ArchiveInfoPrivate::updateInfo(const QString &name)
     QMimeType mt = mimeDatabase.mimeTypeForFile(name);
     qCDebug(lcArchiveInfoLog) << "Archive name:" << name << "mime/type:" << mt.name() << "inherits:" << "parent mime/types:" << mt.parentMimeTypes() ;
 
-    QString mimeType = mt.name();
-    QStringList parentTypes = mt.parentMimeTypes();
-
-    supported = true;
-
-    if (mimeType == QLatin1String("application/x-7z-compressed")) {
-        format = ArchiveInfo::SevenZip;
-    } else if (mimeType == QLatin1String("application/zip")
-               || parentTypes.contains(QLatin1String("application/zip"))) {
-        format = ArchiveInfo::Zip;
-    } else if (mimeType == QLatin1String("application/x-tar") ||
-               parentTypes.contains(QLatin1String("application/x-xz")) ||
-               parentTypes.contains(QLatin1String("application/gzip")) ||
-               parentTypes.contains(QLatin1String("application/x-gzip")) ||
-               parentTypes.contains(QLatin1String("application/x-bzip")) ||
-               parentTypes.contains(QLatin1String("application/x-bzip2"))) {
-        format = ArchiveInfo::Tar;
-    } else {
-        qCDebug(lcArchiveInfoLog) << "Unsupported archive format mimeType:" << mimeType << "parent types:" << parentTypes;
-        format = ArchiveInfo::Unknown;
-        supported = false;
-    }
+    format = ArchiveInfo::format(mt);
+    supported = format != ArchiveInfo::Unknown;
+    if (!supported)
+        qCDebug(lcArchiveInfoLog) << "Unsupported archive format mimeType:" << mt.name() << "parent types:" << mt.parentMimeTypes();
 
     if (supported) {
         info.setFile(name);;
@@ -211,4 +193,26 @@ bool ArchiveInfo::supported(const QString &archiveName)
     return a.supported();
 }
 
+ArchiveInfo::Format ArchiveInfo::format(const QMimeType &mimeType)
+{
+    QString name = mimeType.name();
+    QStringList parentTypes = mimeType.parentMimeTypes();
+
+    if (name == QLatin1String("application/x-7z-compressed")) {
+        return ArchiveInfo::SevenZip;
+    } else if (name == QLatin1String("application/zip")
+               || parentTypes.contains(QLatin1String("application/zip"))) {
+        return ArchiveInfo::Zip;
+    } else if (name == QLatin1String("application/x-tar") ||
+               parentTypes.contains(QLatin1String("application/x-xz")) ||
+               parentTypes.contains(QLatin1String("application/gzip")) ||
+               parentTypes.contains(QLatin1String("application/x-gzip")) ||
+               parentTypes.contains(QLatin1String("application/x-bzip")) ||
+               parentTypes.contains(QLatin1String("application/x-bzip2"))) {
+        return ArchiveInfo::Tar;
+    }
+
+    return ArchiveInfo::Unknown;
+}
+
 }
@@ -36,6 +36,8 @@
 #include <QObject>
 #include <QString>
 
+class QMimeType;
+
 namespace Sailfish {
 
 class ArchiveInfoPrivate;
@@ -80,6 +82,7 @@ public:
 
     static bool exists(const QString &archiveName);
     static bool supported(const QString &archiveName);
+    static Format format(const QMimeType &mimeType);
 
 signals:
     void fileChanged();
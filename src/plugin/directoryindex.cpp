@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "directoryindex.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QMimeDatabase>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+#include <limits>
+
+#include <string.h>
+#include <sys/stat.h>
+
+namespace {
+
+const quint32 IndexMagic = 0x49444d46; // "FMDI"
+const quint32 IndexVersion = 1;
+
+struct IndexHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint64 device;
+    quint64 inode;
+    qint64 modified;
+    quint32 entryCount;
+    quint32 mimeTypeCount;
+    quint32 keyOffset;
+    quint32 keyLength;
+    quint32 stringsSize;
+    quint32 reserved;
+};
+
+struct IndexString
+{
+    quint32 offset;
+    quint32 length;
+};
+
+struct IndexEntry
+{
+    quint32 linkMode;
+    quint32 mode;
+    qint64 size;
+    qint64 modified; // in nanoseconds
+    quint64 inode;
+    quint32 mimeType;
+    IndexString name;
+    quint32 reserved;
+};
+
+static_assert(sizeof(IndexHeader) == 56, "Unexpected index header size");
+static_assert(sizeof(IndexEntry) == 48, "Unexpected index entry size");
+
+qint64 toNanoseconds(const struct timespec &time)
+{
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+struct timespec fromNanoseconds(qint64 time)
+{
+    struct timespec rv;
+    rv.tv_sec = time / 1000000000;
+    rv.tv_nsec = time % 1000000000;
+    return rv;
+}
+
+QString listingKey(const QDir &dir)
+{
+    QString key = dir.absolutePath();
+    key += QLatin1Char('\n');
+    key += QString::number(int(dir.filter()));
+    key += QLatin1Char('\n');
+    key += QString::number(int(dir.sorting()));
+    key += QLatin1Char('\n');
+    key += dir.nameFilters().join(QLatin1Char('/'));
+    return key;
+}
+
+QString indexDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/directoryindex");
+}
+
+QString indexFileName(const QString &key)
+{
+    const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+    return indexDirectory() + QLatin1Char('/') + QString::fromLatin1(hash.toHex()) + QStringLiteral(".idx");
+}
+
+// the digests of the indexes this process has read or written, so that a listing that hasn't
+// changed isn't written again on every refresh
+class IndexDigests
+{
+public:
+    // records the digest, returns false if it was recorded already
+    bool update(const QString &fileName, const QByteArray &digest)
+    {
+        QMutexLocker locker(&m_mutex);
+        QByteArray &recorded = m_digests[fileName];
+        if (recorded == digest)
+            return false;
+        recorded = digest;
+        return true;
+    }
+
+    void remove(const QString &fileName)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_digests.remove(fileName);
+    }
+
+private:
+    QMutex m_mutex;
+    QHash<QString, QByteArray> m_digests;
+};
+
+Q_GLOBAL_STATIC(IndexDigests, indexDigests)
+
+QByteArray digest(const QByteArray &data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+void removeIndex(const QString &fileName)
+{
+    indexDigests()->remove(fileName);
+    QFile::remove(fileName);
+}
+
+bool writeIndex(const QString &fileName, const QByteArray &data)
+{
+    QDir().mkpath(indexDirectory());
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)
+            || file.write(data) != data.size()
+            || !file.commit()) {
+        qWarning() << "Failed to write directory index" << fileName << file.errorString();
+        indexDigests()->remove(fileName);
+        return false;
+    }
+    return true;
+}
+
+// the indexes are touched when they are loaded, the oldest ones have been used the least recently
+void trimIndexes()
+{
+    const QFileInfoList indexes = QDir(indexDirectory()).entryInfoList(
+                QStringList() << QStringLiteral("*.idx"), QDir::Files, QDir::Time);
+    for (int i = DirectoryIndex::MaximumIndexes; i < indexes.count(); ++i)
+        removeIndex(indexes.at(i).absoluteFilePath());
+}
+
+class StringTable
+{
+public:
+    IndexString append(const QString &string)
+    {
+        const QByteArray utf8 = string.toUtf8();
+        IndexString rv;
+        rv.offset = m_data.size();
+        rv.length = utf8.size();
+        m_data.append(utf8);
+        return rv;
+    }
+
+    const QByteArray &data() const { return m_data; }
+
+private:
+    QByteArray m_data;
+};
+
+}
+
+DirectoryIndex::Stamp DirectoryIndex::stamp(const QString &path)
+{
+    Stamp rv;
+
+    struct stat64 st;
+    if (::stat64(QFile::encodeName(path).constData(), &st) == 0) {
+        rv.device = st.st_dev;
+        rv.inode = st.st_ino;
+        rv.modified = toNanoseconds(st.st_mtim);
+    }
+
+    return rv;
+}
+
+bool DirectoryIndex::load(const QDir &dir, QVector<StatFileInfo> *entries)
+{
+    const Stamp current = stamp(dir.absolutePath());
+    if (!current.isValid())
+        return false;
+
+    QFile file(indexFileName(listingKey(dir)));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = file.size();
+    const uchar *data = size >= qint64(sizeof(IndexHeader)) && size <= std::numeric_limits<int>::max()
+            ? file.map(0, size) : nullptr;
+
+    // the entries are copied out of the mapping, so it doesn't need to outlive the call
+    const QByteArray buffer = data
+            ? QByteArray::fromRawData(reinterpret_cast<const char *>(data), size) : QByteArray();
+    if (!deserialize(buffer, dir, current, entries)) {
+        // of an earlier state of the directory, or damaged, it is of no use any more
+        file.close();
+        removeIndex(file.fileName());
+        return false;
+    }
+
+    // recently used, for trimming the indexes
+    futimens(file.handle(), nullptr);
+
+    indexDigests()->update(file.fileName(), digest(buffer));
+    return true;
+}
+
+bool DirectoryIndex::deserialize(const QByteArray &buffer, const QDir &dir, const Stamp &stamp,
+                                 QVector<StatFileInfo> *entries)
+{
+    const qint64 size = buffer.size();
+    if (size < qint64(sizeof(IndexHeader)))
+        return false;
+
+    const uchar *data = reinterpret_cast<const uchar *>(buffer.constData());
+    const QString key = listingKey(dir);
+
+    IndexHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != IndexMagic || header.version != IndexVersion)
+        return false;
+
+    if (stamp.isValid()
+            && (header.device != stamp.device
+                || header.inode != stamp.inode
+                || header.modified != stamp.modified)) {
+        return false;
+    }
+
+    const qint64 tableOffset = sizeof(IndexHeader);
+    const qint64 entryOffset = tableOffset + qint64(header.mimeTypeCount) * sizeof(IndexString);
+    const qint64 stringOffset = entryOffset + qint64(header.entryCount) * sizeof(IndexEntry);
+    if (stringOffset + header.stringsSize != size)
+        return false;
+
+    const char *strings = reinterpret_cast<const char *>(data + stringOffset);
+    auto validString = [&header](const IndexString &string) {
+        return string.offset <= header.stringsSize && string.length <= header.stringsSize - string.offset;
+    };
+
+    IndexString keyString;
+    keyString.offset = header.keyOffset;
+    keyString.length = header.keyLength;
+    if (!validString(keyString)
+            || QString::fromUtf8(strings + keyString.offset, keyString.length) != key) {
+        return false;
+    }
+
+    QMimeDatabase mimeDatabase;
+    QVector<QMimeType> mimeTypes;
+    mimeTypes.reserve(header.mimeTypeCount);
+    for (quint32 i = 0; i < header.mimeTypeCount; ++i) {
+        IndexString name;
+        memcpy(&name, data + tableOffset + i * sizeof(IndexString), sizeof(name));
+        if (!validString(name))
+            return false;
+        mimeTypes.append(mimeDatabase.mimeTypeForName(QString::fromUtf8(strings + name.offset, name.length)));
+    }
+
+    QString prefix = dir.absolutePath();
+    if (!prefix.endsWith(QLatin1Char('/')))
+        prefix += QLatin1Char('/');
+
+    QVector<StatFileInfo> rv;
+    rv.reserve(header.entryCount);
+
+    for (quint32 i = 0; i < header.entryCount; ++i) {
+        IndexEntry entry;
+        memcpy(&entry, data + entryOffset + i * sizeof(IndexEntry), sizeof(entry));
+        if (!validString(entry.name) || entry.mimeType >= header.mimeTypeCount)
+            return false;
+
+        struct stat64 st;
+        memset(&st, 0, sizeof(st));
+        st.st_dev = header.device;
+        st.st_ino = entry.inode;
+        st.st_mode = entry.mode;
+        st.st_size = entry.size;
+        st.st_mtim = fromNanoseconds(entry.modified);
+
+        struct stat64 lst = st;
+        if (entry.linkMode != entry.mode) {
+            // a symlink, its own size and times are not recorded
+            memset(&lst, 0, sizeof(lst));
+            lst.st_dev = header.device;
+            lst.st_mode = entry.linkMode;
+        }
+
+        const QString fileName = QString::fromUtf8(strings + entry.name.offset, entry.name.length);
+        rv.append(StatFileInfo(prefix + fileName, lst, st, mimeTypes.at(entry.mimeType)));
+    }
+
+    *entries = rv;
+    return true;
+}
+
+QFuture<bool> DirectoryIndex::save(const QDir &dir, const Stamp &stamp, const QVector<StatFileInfo> &entries)
+{
+    // the key is taken here, QDir is not to be shared between threads
+    return QtConcurrent::run(&DirectoryIndex::saveIndex, listingKey(dir), stamp, entries);
+}
+
+bool DirectoryIndex::saveIndex(const QString &key, const Stamp &stamp, const QVector<StatFileInfo> &entries)
+{
+    if (!stamp.isValid())
+        return false;
+
+    const QString fileName = indexFileName(key);
+
+    if (entries.count() < MinimumEntries) {
+        // the directory has shrunk, don't keep an outdated index around
+        if (QFile::exists(fileName))
+            removeIndex(fileName);
+        return false;
+    }
+
+    // the same stamp and entries serialize to the same data, unless the file has gone meanwhile
+    const QByteArray data = serializeListing(key, stamp, entries);
+    if (!indexDigests()->update(fileName, digest(data)) && QFile::exists(fileName))
+        return false;
+
+    if (!writeIndex(fileName, data))
+        return false;
+    trimIndexes();
+    return true;
+}
+
+QByteArray DirectoryIndex::serialize(const QDir &dir, const Stamp &stamp, const QVector<StatFileInfo> &entries)
+{
+    return serializeListing(listingKey(dir), stamp, entries);
+}
+
+QByteArray DirectoryIndex::serializeListing(const QString &key, const Stamp &stamp,
+                                            const QVector<StatFileInfo> &entries)
+{
+    StringTable strings;
+    QHash<QString, quint32> mimeTypeIds;
+    QVector<IndexString> mimeTypes;
+    QVector<IndexEntry> records;
+    records.reserve(entries.count());
+
+    for (const StatFileInfo &info : entries) {
+        const QString mimeType = info.mimeType();
+        QHash<QString, quint32>::const_iterator it = mimeTypeIds.constFind(mimeType);
+        if (it == mimeTypeIds.constEnd()) {
+            it = mimeTypeIds.insert(mimeType, mimeTypes.count());
+            mimeTypes.append(strings.append(mimeType));
+        }
+
+        IndexEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.linkMode = info.lstatData().st_mode;
+        entry.mode = info.statData().st_mode;
+        entry.size = info.statData().st_size;
+        entry.modified = toNanoseconds(info.statData().st_mtim);
+        entry.inode = info.statData().st_ino;
+        entry.mimeType = it.value();
+        entry.name = strings.append(info.fileName());
+        records.append(entry);
+    }
+
+    const IndexString keyString = strings.append(key);
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = IndexMagic;
+    header.version = IndexVersion;
+    header.device = stamp.device;
+    header.inode = stamp.inode;
+    header.modified = stamp.modified;
+    header.entryCount = records.count();
+    header.mimeTypeCount = mimeTypes.count();
+    header.keyOffset = keyString.offset;
+    header.keyLength = keyString.length;
+    header.stringsSize = strings.data().size();
+
+    QByteArray data;
+    data.reserve(sizeof(header) + mimeTypes.count() * sizeof(IndexString)
+                 + records.count() * sizeof(IndexEntry) + strings.data().size());
+    data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    data.append(reinterpret_cast<const char *>(mimeTypes.constData()), mimeTypes.count() * sizeof(IndexString));
+    data.append(reinterpret_cast<const char *>(records.constData()), records.count() * sizeof(IndexEntry));
+    data.append(strings.data());
+
+    return data;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef DIRECTORYINDEX_H
+#define DIRECTORYINDEX_H
+
+#include "statfileinfo.h"
+
+#include <QDir>
+#include <QFuture>
+#include <QVector>
+
+/**
+ * @brief The DirectoryIndex class persists directory listings in a compact binary file, so that
+ * large directories can be shown right away on the next launch without listing the directory
+ * and sniffing the mime type of every file again.
+ * An index is stored per directory and listing settings (filters, sorting and name filters), and
+ * it is only used while the modification time of the directory itself matches the one recorded
+ * when the listing was read. Changes to the files inside the directory don't show up in the
+ * directory modification time, so the loaded listing should still be reconciled against the disk.
+ * An index that no longer matches its directory is removed when it is loaded, and beyond a number
+ * of indexes the least recently used ones are removed, e.g. those of removed directories.
+ */
+class DirectoryIndex
+{
+public:
+    struct Stamp
+    {
+        Stamp() : device(0), inode(0), modified(0) {}
+
+        bool isValid() const { return inode != 0; }
+
+        quint64 device;
+        quint64 inode;
+        qint64 modified; // in nanoseconds
+    };
+
+    // listings shorter than this are cheap enough to read and are not indexed
+    static const int MinimumEntries = 100;
+    // the number of indexes kept
+    static const int MaximumIndexes = 64;
+
+    // the identity of a directory, should be taken before its entries are read
+    static Stamp stamp(const QString &path);
+
+    // reads the index for the listing of dir, returns false if there is no valid index
+    static bool load(const QDir &dir, QVector<StatFileInfo> *entries);
+
+    // writes the index for the listing of dir in the background, the result is false if the
+    // index already holds the same listing, or the listing is not worth indexing
+    static QFuture<bool> save(const QDir &dir, const Stamp &stamp, const QVector<StatFileInfo> &entries);
+
+    // the index format in memory, restoring ignores the directory stamp if stamp is not valid
+    static QByteArray serialize(const QDir &dir, const Stamp &stamp, const QVector<StatFileInfo> &entries);
+    static bool deserialize(const QByteArray &data, const QDir &dir, const Stamp &stamp,
+                            QVector<StatFileInfo> *entries);
+
+private:
+    static QByteArray serializeListing(const QString &key, const Stamp &stamp, const QVector<StatFileInfo> &entries);
+    static bool saveIndex(const QString &key, const Stamp &stamp, const QVector<StatFileInfo> &entries);
+};
+
+#endif // DIRECTORYINDEX_H
@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "directorypoller.h"
+#include "directoryreader.h"
+#include "inotifywatcher.h"
+#include "trash.h"
+
+#include <QFile>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMutex>
+#include <QTimerEvent>
+#include <QtConcurrent>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+namespace {
+
+const int MinimumInterval = 1000;
+const int MaximumInterval = 30000;
+
+// how long the canary waits for its own event
+const int CanaryTimeout = 200;
+
+// file systems that are changed behind the kernel's back, so inotify only sees the local changes
+bool isRemoteFileSystem(quint32 type)
+{
+    switch (type) {
+    case 0x65735546: // FUSE, e.g. MTP devices and SSHFS
+    case 0x517b: // SMB
+    case 0xfe534d42: // SMB2
+    case 0xff534d42: // CIFS
+    case 0x6969: // NFS
+    case 0x01021997: // 9P
+        return true;
+    default:
+        return false;
+    }
+}
+
+// file systems where inotify is known to work, removable media included; they are only changed
+// through the kernel while mounted
+bool isLocalFileSystem(quint32 type)
+{
+    switch (type) {
+    case 0x4d44: // vfat
+    case 0x2011bab0: // exFAT
+    case 0x7366746e: // NTFS
+    case 0x9660: // ISO 9660
+    case 0x15013346: // UDF
+    case 0xef53: // ext2, ext3 and ext4
+    case 0x9123683e: // btrfs
+    case 0x58465342: // XFS
+    case 0xf2f52010: // F2FS
+    case 0x24051905: // UBIFS
+    case 0x01021994: // tmpfs
+    case 0x858458f6: // ramfs
+        return true;
+    default:
+        return false;
+    }
+}
+
+// creates and removes a file in a directory of the user on the same file system, the trash,
+// rather than in the listed directory, and checks that inotify reports it. Nothing is set up
+// on the file system only for listing it, without a trash there the answer is no.
+bool canaryNotifies(const QString &directory)
+{
+    const QByteArray path = QFile::encodeName(Trash::existingLocation(directory));
+    if (path.isEmpty())
+        return false;
+
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    bool rv = false;
+    if (inotify_add_watch(fd, path.constData(), IN_CREATE | IN_ONLYDIR) >= 0) {
+        const QByteArray canary = path + "/.filemanager-canary-" + QByteArray::number(getpid());
+        const int file = open(canary.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (file >= 0) {
+            close(file);
+            unlink(canary.constData());
+
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            rv = poll(&pfd, 1, CanaryTimeout) > 0;
+        }
+    }
+
+    close(fd);
+    return rv;
+}
+
+quint64 nameHash(const char *name)
+{
+    // FNV-1a
+    quint64 rv = Q_UINT64_C(14695981039346656037);
+    for (; *name; ++name) {
+        rv ^= quint8(*name);
+        rv *= Q_UINT64_C(1099511628211);
+    }
+    return rv;
+}
+
+// the modification time and the names of the entries, zero is left for not known
+quint64 directorySignature(const QString &path)
+{
+    DirectoryReader reader(path);
+    struct stat64 st;
+    if (!reader.isValid() || fstat64(reader.fd(), &st) != 0)
+        return 1;
+
+    quint64 rv = quint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    while (const struct dirent64 *entry = reader.next()) {
+        // order independent, the file system may return the entries in any order
+        rv += nameHash(entry->d_name);
+    }
+    return rv > 1 ? rv : 2;
+}
+
+}
+
+DirectoryPoller::DirectoryPoller(QObject *parent)
+    : QObject(parent)
+    , m_signature(0)
+    , m_interval(MinimumInterval)
+    , m_active(false)
+    , m_running(false)
+    , m_polling(false)
+{
+    connect(InotifyWatcher::instance(), &InotifyWatcher::suspendedChanged, this, &DirectoryPoller::updateRunning);
+}
+
+DirectoryPoller::~DirectoryPoller()
+{
+}
+
+bool DirectoryPoller::needsPolling(const QString &path)
+{
+    const QByteArray fileName = QFile::encodeName(path);
+
+    struct statfs64 fs;
+    struct stat64 st;
+    if (statfs64(fileName.constData(), &fs) != 0 || stat64(fileName.constData(), &st) != 0)
+        return false;
+
+    const quint32 type = quint32(fs.f_type);
+    if (isRemoteFileSystem(type))
+        return true;
+    if (isLocalFileSystem(type))
+        return false;
+
+    // others are tested once per mounted file system
+    static QMutex mutex;
+    static QHash<quint64, bool> tested;
+    QMutexLocker locker(&mutex);
+    QHash<quint64, bool>::const_iterator it = tested.constFind(st.st_dev);
+    if (it != tested.constEnd())
+        return it.value();
+
+    const bool rv = !canaryNotifies(path);
+    tested.insert(st.st_dev, rv);
+    return rv;
+}
+
+void DirectoryPoller::setPath(const QString &path)
+{
+    if (m_path == path)
+        return;
+
+    m_path = path;
+    m_signature = 0;
+    m_interval = MinimumInterval;
+
+    // take the first signature right away
+    m_timer.stop();
+    if (m_running)
+        poll();
+}
+
+void DirectoryPoller::setActive(bool active)
+{
+    if (m_active != active) {
+        m_active = active;
+        updateRunning();
+    }
+}
+
+void DirectoryPoller::updateRunning()
+{
+    const bool running = m_active && !InotifyWatcher::instance()->isSuspended();
+    if (m_running == running)
+        return;
+
+    m_running = running;
+    if (m_running) {
+        // catch up with the changes made while paused
+        m_interval = MinimumInterval;
+        poll();
+    } else {
+        m_timer.stop();
+    }
+}
+
+void DirectoryPoller::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_timer.timerId()) {
+        m_timer.stop();
+        InotifyWatcher::instance()->recordWakeup();
+        poll();
+    } else {
+        QObject::timerEvent(event);
+    }
+}
+
+void DirectoryPoller::poll()
+{
+    if (m_polling || m_path.isEmpty())
+        return;
+
+    m_polling = true;
+    const QString path = m_path;
+
+    QFutureWatcher<quint64> *watcher = new QFutureWatcher<quint64>(this);
+    connect(watcher, &QFutureWatcher<quint64>::finished, this, [this, watcher, path]() {
+        watcher->deleteLater();
+        m_polling = false;
+        setSignature(path, watcher->result());
+    });
+    watcher->setFuture(QtConcurrent::run(directorySignature, path));
+}
+
+void DirectoryPoller::setSignature(const QString &path, quint64 signature)
+{
+    if (path == m_path) {
+        if (m_signature != 0 && m_signature != signature) {
+            m_interval = MinimumInterval;
+            emit directoryChanged(m_path);
+        } else {
+            // back off while nothing changes
+            m_interval = qMin(m_interval * 2, MaximumInterval);
+        }
+        m_signature = signature;
+    } else {
+        // the path changed meanwhile, start over
+        m_signature = 0;
+        if (m_running) {
+            poll();
+            return;
+        }
+    }
+
+    schedule();
+}
+
+void DirectoryPoller::schedule()
+{
+    if (m_running && !m_path.isEmpty() && !m_polling) {
+        m_timer.start(m_interval, this);
+    } else {
+        m_timer.stop();
+    }
+}
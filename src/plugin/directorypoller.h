@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef DIRECTORYPOLLER_H
+#define DIRECTORYPOLLER_H
+
+#include <QBasicTimer>
+#include <QObject>
+#include <QString>
+
+/**
+ * @brief The DirectoryPoller class detects changes in a directory on file systems where inotify
+ * does not report them, e.g. FUSE mounts of MTP devices and network shares changed by other
+ * clients. The modification time and a hash of the entry names are compared on a timer, which
+ * backs off while nothing changes and is paused while the poller is inactive or the watchers
+ * are suspended.
+ */
+class DirectoryPoller : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DirectoryPoller(QObject *parent = 0);
+    ~DirectoryPoller();
+
+    // whether the directory needs polling, decided by the file system type, or for unknown ones
+    // by a test that is run once per file system. Blocks on slow file systems, e.g. network
+    // shares that take their time to answer, so should be asked from a worker thread.
+    static bool needsPolling(const QString &path);
+
+    QString path() const { return m_path; }
+    // an empty path stops polling
+    void setPath(const QString &path);
+
+    bool isActive() const { return m_active; }
+    void setActive(bool active);
+
+    // the current polling interval in milliseconds
+    int interval() const { return m_interval; }
+
+signals:
+    void directoryChanged(const QString &path);
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    void poll();
+    void setSignature(const QString &path, quint64 signature);
+    void schedule();
+    void updateRunning();
+
+    QString m_path;
+    QBasicTimer m_timer;
+    quint64 m_signature; // zero when not yet known
+    int m_interval;
+    bool m_active;
+    bool m_running; // active and not suspended
+    bool m_polling;
+};
+
+#endif // DIRECTORYPOLLER_H
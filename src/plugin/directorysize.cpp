@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "directorysize.h"
+#include "directoryreader.h"
+#include "treeremover.h"
+#include "treewatcher.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QPair>
+#include <QRunnable>
+#include <QSet>
+#include <QStringList>
+
+#include <fcntl.h>
+
+namespace {
+
+// the number of cached directories, beyond which the cache is dropped
+const int MaximumEntries = 512;
+
+class DirectorySizeWalker : public QRunnable
+{
+public:
+    DirectorySizeWalker(DirectorySize *target, const QString &path, int generation)
+        : m_target(target), m_path(path), m_generation(generation), m_size(0) {}
+
+    void run() override
+    {
+        // the threads of the pool only walk, they can stay at idle priority
+        TreeRemover::setIdlePriority();
+
+        int childCount = -1;
+        DirectoryReader reader(m_path);
+        if (reader.isValid()) {
+            struct stat64 st;
+            if (fstat64(reader.fd(), &st) == 0) {
+                childCount = walk(reader, st.st_dev);
+            }
+        }
+
+        QMetaObject::invokeMethod(m_target, "setResult", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_path),
+                                  Q_ARG(int, m_generation),
+                                  Q_ARG(qint64, childCount >= 0 ? m_size : 0),
+                                  Q_ARG(int, qMax(childCount, 0)));
+    }
+
+private:
+    // returns the number of entries in the directory, and accumulates the size of the tree
+    int walk(DirectoryReader &reader, dev_t device)
+    {
+        int count = 0;
+
+        while (const struct dirent64 *entry = reader.next()) {
+            ++count;
+
+            struct stat64 st;
+            if (fstatat64(reader.fd(), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                continue;
+            }
+
+            if (S_ISDIR(st.st_mode)) {
+                // Like du -x, don't descend into other file systems
+                if (st.st_dev != device) {
+                    continue;
+                }
+                DirectoryReader child(reader.fd(), entry->d_name);
+                if (child.isValid()) {
+                    walk(child, device);
+                }
+            } else if (S_ISREG(st.st_mode)) {
+                if (st.st_nlink > 1) {
+                    // count hard linked files only once
+                    const QPair<quint64, quint64> id(st.st_dev, st.st_ino);
+                    if (m_hardLinks.contains(id)) {
+                        continue;
+                    }
+                    m_hardLinks.insert(id);
+                }
+                m_size += st.st_size;
+            }
+        }
+
+        return count;
+    }
+
+    DirectorySize *m_target;
+    QString m_path;
+    int m_generation;
+    qint64 m_size;
+    QSet<QPair<quint64, quint64> > m_hardLinks;
+};
+
+}
+
+DirectorySize::DirectorySize(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new TreeWatcher(this))
+{
+    m_pool.setMaxThreadCount(2);
+    // the sizes change when the files are written, not only when entries come and go
+    m_watcher->setEvents(InotifyWatcher::ChangeEvents);
+    connect(m_watcher, &TreeWatcher::directoryChanged, this, &DirectorySize::directoryChanged);
+}
+
+DirectorySize *DirectorySize::instance()
+{
+    static DirectorySize *instance = new DirectorySize(QCoreApplication::instance());
+    return instance;
+}
+
+DirectorySize::Result DirectorySize::lookup(const QString &path)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(path);
+    if (it == m_entries.end()) {
+        prune();
+        it = m_entries.insert(path, Entry());
+        m_watcher->addPath(path);
+        calculate(path, &it.value());
+    }
+    return it->result;
+}
+
+void DirectorySize::invalidate(const QString &path)
+{
+    QString directory = path;
+    while (!directory.isEmpty()) {
+        QHash<QString, Entry>::iterator it = m_entries.find(directory);
+        if (it != m_entries.end()) {
+            ++it->generation;
+            calculate(directory, &it.value());
+        }
+
+        const int index = directory.lastIndexOf(QLatin1Char('/'));
+        if (index <= 0)
+            break;
+        directory.truncate(index);
+    }
+}
+
+void DirectorySize::setResult(const QString &path, int generation, qint64 size, int childCount)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(path);
+    if (it == m_entries.end())
+        return;
+
+    it->pending = false;
+    if (it->generation != generation) {
+        // The directory changed during the calculation
+        calculate(path, &it.value());
+        return;
+    }
+
+    if (it->result.size == size && it->result.childCount == childCount)
+        return;
+
+    it->result.size = size;
+    it->result.childCount = childCount;
+    emit resultReady(path);
+}
+
+void DirectorySize::directoryChanged(const QString &path)
+{
+    invalidate(path);
+}
+
+void DirectorySize::calculate(const QString &path, Entry *entry)
+{
+    // A calculation in progress is restarted once it finishes, see setResult()
+    if (entry->pending)
+        return;
+
+    entry->pending = true;
+    m_pool.start(new DirectorySizeWalker(this, path, entry->generation));
+}
+
+void DirectorySize::prune()
+{
+    if (m_entries.count() < MaximumEntries)
+        return;
+
+    // Results are cheap to calculate again compared to tracking their use
+    m_watcher->clear();
+    m_entries.clear();
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef DIRECTORYSIZE_H
+#define DIRECTORYSIZE_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+class TreeWatcher;
+
+/**
+ * @brief The DirectorySize class calculates the recursive size and the number of direct children
+ * of directories on a low priority thread pool, and caches the results for all models.
+ * A cached result is recalculated when anything in the directory tree is changed, and the stale
+ * value is reported until the new one is available.
+ */
+class DirectorySize : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Result
+    {
+        Result() : size(-1), childCount(-1) {}
+
+        bool isValid() const { return size >= 0; }
+
+        qint64 size;
+        int childCount;
+    };
+
+    static DirectorySize *instance();
+
+    // returns the cached result for the directory, and schedules a calculation if there is none
+    Result lookup(const QString &path);
+
+    // schedules the directory and its cached parents to be calculated again
+    void invalidate(const QString &path);
+
+signals:
+    void resultReady(const QString &path);
+
+private slots:
+    void setResult(const QString &path, int generation, qint64 size, int childCount);
+    void directoryChanged(const QString &path);
+
+private:
+    explicit DirectorySize(QObject *parent = 0);
+
+    struct Entry
+    {
+        Entry() : generation(0), pending(false) {}
+
+        Result result;
+        int generation;
+        bool pending;
+    };
+
+    void calculate(const QString &path, Entry *entry);
+    void prune();
+
+    QHash<QString, Entry> m_entries;
+    QThreadPool m_pool;
+    TreeWatcher *m_watcher;
+};
+
+#endif // DIRECTORYSIZE_H
@@ -31,7 +31,9 @@
  */
 
 #include "fileengine.h"
+#include "fileinfobatch.h"
 #include "fileworker.h"
+#include "inotifywatcher.h"
 #include "statfileinfo.h"
 #include <QDateTime>
 #include <QDebug>
@@ -44,8 +46,11 @@
 FileEngine::FileEngine(QObject *parent) :
     QObject(parent),
     m_clipboardContainsCopy(false),
+    m_deletePolicy(DeletePermanently),
     m_fileWorker(nullptr)
 {
+    connect(InotifyWatcher::instance(), &InotifyWatcher::suspendedChanged,
+            this, &FileEngine::watchersSuspendedChanged);
 }
 
 FileEngine::~FileEngine()
@@ -67,10 +72,76 @@ bool FileEngine::busy() const
     return m_fileWorker && m_fileWorker->isRunning();
 }
 
+qint64 FileEngine::bytesDone() const
+{
+    return m_fileWorker ? m_fileWorker->progress().bytesDone : 0;
+}
+
+qint64 FileEngine::bytesTotal() const
+{
+    return m_fileWorker ? m_fileWorker->progress().bytesTotal : 0;
+}
+
+int FileEngine::filesDone() const
+{
+    return m_fileWorker ? m_fileWorker->progress().filesDone : 0;
+}
+
+int FileEngine::filesTotal() const
+{
+    return m_fileWorker ? m_fileWorker->progress().filesTotal : 0;
+}
+
+QString FileEngine::currentPath() const
+{
+    return m_fileWorker ? m_fileWorker->progress().currentPath : QString();
+}
+
+qint64 FileEngine::throughput() const
+{
+    return m_fileWorker ? m_fileWorker->progress().bytesPerSecond : 0;
+}
+
+qint64 FileEngine::secondsRemaining() const
+{
+    return m_fileWorker ? m_fileWorker->progress().secondsRemaining : -1;
+}
+
+qreal FileEngine::progress() const
+{
+    if (!m_fileWorker)
+        return 0;
+
+    const FileOperations::Progress progress = m_fileWorker->progress();
+    if (progress.bytesTotal > 0)
+        return qreal(progress.bytesDone) / progress.bytesTotal;
+    if (progress.filesTotal > 0)
+        return qreal(progress.filesDone) / progress.filesTotal;
+    return 0;
+}
+
+bool FileEngine::watchersSuspended() const
+{
+    return InotifyWatcher::instance()->isSuspended();
+}
+
+void FileEngine::setWatchersSuspended(bool suspended)
+{
+    InotifyWatcher::instance()->setSuspended(suspended);
+}
+
+void FileEngine::setDeletePolicy(DeletePolicy policy)
+{
+    if (m_deletePolicy != policy) {
+        m_deletePolicy = policy;
+        emit deletePolicyChanged();
+    }
+}
+
 void FileEngine::deleteFiles(QStringList fileNames, bool nonprivileged)
 {
     ensureWorker();
-    m_fileWorker->startDeleteFiles(fileNames, nonprivileged);
+    m_fileWorker->startDeleteFiles(fileNames, nonprivileged, m_deletePolicy);
 }
 
 void FileEngine::cutFiles(QStringList fileNames)
@@ -84,13 +155,12 @@ void FileEngine::cutFiles(QStringList fileNames)
 
 void FileEngine::copyFiles(QStringList fileNames)
 {
-    // don't copy special files (chr/blk/fifo/sock)
-    QMutableStringListIterator i(fileNames);
-    while (i.hasNext()) {
-        QString fileName = i.next();
-        StatFileInfo info(fileName);
-        if (info.isSystem())
-            i.remove();
+    // don't copy special files (chr/blk/fifo/sock), checked on the disk as the files may have
+    // been replaced just now
+    const QVector<StatFileInfo> infos = FileInfoBatch::read(fileNames, FileInfoBatch::NoReadFlags);
+    for (int i = infos.count() - 1; i >= 0; --i) {
+        if (infos.at(i).isSystem())
+            fileNames.removeAt(i);
     }
 
     if (!fileNames.isEmpty()) {
@@ -117,15 +187,23 @@ void FileEngine::pasteFiles(QString destDirectory, bool nonprivileged)
         return;
     }
 
-    foreach (QString fileName, files) {
-        if (!exists(fileName)) {
+    QStringList newNames;
+    foreach (const QString &fileName, files) {
+        newNames.append(dest.absoluteFilePath(QFileInfo(fileName).fileName()));
+    }
+
+    // check the sources and the destinations in one pass, bypassing caches and mime type sniffing
+    const QVector<StatFileInfo> infos = FileInfoBatch::read(files + newNames, FileInfoBatch::NoReadFlags);
+
+    for (int i = 0; i < files.count(); ++i) {
+        const QString &fileName = files.at(i);
+        const QString &newName = newNames.at(i);
+
+        if (fileName.isEmpty() || !infos.at(i).exists()) {
             emit error(ErrorCopyFailed, fileName);
             return;
         }
 
-        QFileInfo fileInfo(fileName);
-        QString newName = dest.absoluteFilePath(fileInfo.fileName());
-
         // source and dest fileNames are the same?
         if (fileName == newName) {
             emit error(ErrorCannotCopyIntoItself, fileName);
@@ -138,7 +216,7 @@ void FileEngine::pasteFiles(QString destDirectory, bool nonprivileged)
             return;
         }
 
-        if (QFile::exists(newName)) {
+        if (infos.at(files.count() + i).exists()) {
             emit error(ErrorCopyFailed, fileName);
             return;
         }
@@ -199,6 +277,18 @@ bool FileEngine::rename(QString fullOldFileName, QString newName, bool nonprivil
     return true;
 }
 
+bool FileEngine::restoreFiles(QStringList fileNames, bool nonprivileged)
+{
+    ensureWorker();
+
+    QString failedPath;
+    if (!m_fileWorker->restoreFiles(fileNames, nonprivileged, &failedPath)) {
+        emit error(ErrorRestoreFailed, failedPath);
+        return false;
+    }
+    return true;
+}
+
 bool FileEngine::chmod(QString path,
                       bool ownerRead, bool ownerWrite, bool ownerExecute,
                       bool groupRead, bool groupWrite, bool groupExecute,
@@ -250,6 +340,7 @@ void FileEngine::ensureWorker()
         connect(m_fileWorker, &FileWorker::started, this, &FileEngine::busyChanged);
         connect(m_fileWorker, &FileWorker::finished, this, &FileEngine::busyChanged);
         connect(m_fileWorker, &FileWorker::modeChanged, this, &FileEngine::modeChanged);
+        connect(m_fileWorker, &FileWorker::progressChanged, this, &FileEngine::progressChanged);
 
         connect(m_fileWorker, &FileWorker::fileDeleted, this, &FileEngine::fileDeleted);
     }
@@ -50,9 +50,20 @@ class FileEngine : public QObject
     Q_PROPERTY(bool clipboardContainsCopy READ clipboardContainsCopy NOTIFY clipboardContainsCopyChanged)
     Q_PROPERTY(bool busy READ busy NOTIFY busyChanged)
     Q_PROPERTY(Mode mode READ mode NOTIFY modeChanged)
+    Q_PROPERTY(qint64 bytesDone READ bytesDone NOTIFY progressChanged)
+    Q_PROPERTY(qint64 bytesTotal READ bytesTotal NOTIFY progressChanged)
+    Q_PROPERTY(int filesDone READ filesDone NOTIFY progressChanged)
+    Q_PROPERTY(int filesTotal READ filesTotal NOTIFY progressChanged)
+    Q_PROPERTY(QString currentPath READ currentPath NOTIFY progressChanged)
+    Q_PROPERTY(qint64 throughput READ throughput NOTIFY progressChanged)
+    Q_PROPERTY(qint64 secondsRemaining READ secondsRemaining NOTIFY progressChanged)
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(bool watchersSuspended READ watchersSuspended WRITE setWatchersSuspended NOTIFY watchersSuspendedChanged)
+    Q_PROPERTY(DeletePolicy deletePolicy READ deletePolicy WRITE setDeletePolicy NOTIFY deletePolicyChanged)
 
     Q_ENUMS(Error)
     Q_ENUMS(Mode)
+    Q_ENUMS(DeletePolicy)
 public:
     explicit FileEngine(QObject *parent = 0);
     ~FileEngine();
@@ -70,6 +81,8 @@ public:
         ErrorFolderCopyFailed,
         ErrorFolderCreationFailed,
         ErrorChmodFailed,
+        ErrorNotEnoughSpace,
+        ErrorRestoreFailed,
     };
 
     enum Mode {
@@ -79,6 +92,13 @@ public:
         MoveMode
     };
 
+    enum DeletePolicy {
+        DeletePermanently,
+        // moved to the trash of their file system at once and removed from there in the background
+        DeleteInBackground,
+        MoveToTrash
+    };
+
     // properties
     // deprecated - use clipboardFiles length
     int clipboardCount() const { return m_clipboardFiles.count(); }
@@ -87,6 +107,28 @@ public:
     bool busy() const;
     Mode mode() const;
 
+    // the progress of the current or the last operation, updated a few times a second
+    qint64 bytesDone() const;
+    qint64 bytesTotal() const;
+    int filesDone() const;
+    int filesTotal() const;
+    QString currentPath() const;
+    // bytes per second
+    qint64 throughput() const;
+    // -1 while not known
+    qint64 secondsRemaining() const;
+    // from 0 to 1
+    qreal progress() const;
+
+    // stops waking up for file changes, e.g. while the application is in the background,
+    // the models and watchers catch up once the watchers are resumed
+    bool watchersSuspended() const;
+    void setWatchersSuspended(bool suspended);
+
+    // how deleteFiles() gets rid of the files, DeletePermanently by default
+    DeletePolicy deletePolicy() const { return m_deletePolicy; }
+    void setDeletePolicy(DeletePolicy policy);
+
     // methods accessible from QML
 
     // asynch methods send signals when done or error occurs
@@ -102,6 +144,8 @@ public:
     Q_INVOKABLE bool exists(QString fileName);
     Q_INVOKABLE bool mkdir(QString path, QString name, bool nonprivileged = false);
     Q_INVOKABLE bool rename(QString fullOldFileName, QString newName, bool nonprivileged = false);
+    // moves files deleted with the MoveToTrash policy back, fileNames are the paths they had
+    Q_INVOKABLE bool restoreFiles(QStringList fileNames, bool nonprivileged = false);
     Q_INVOKABLE bool chmod(QString path,
                               bool ownerRead, bool ownerWrite, bool ownerExecute,
                               bool groupRead, bool groupWrite, bool groupExecute,
@@ -122,12 +166,16 @@ signals:
     void cancelled();
     void busyChanged();
     void modeChanged();
+    void progressChanged();
+    void watchersSuspendedChanged();
+    void deletePolicyChanged();
 
 private:
     void ensureWorker();
 
     QStringList m_clipboardFiles;
     bool m_clipboardContainsCopy;
+    DeletePolicy m_deletePolicy;
     FileWorker *m_fileWorker;
 };
 
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "fileinfobatch.h"
+#include "statcache.h"
+
+#include <QFile>
+#include <QFutureWatcher>
+#include <QJSEngine>
+#include <QMimeDatabase>
+#include <QQmlInfo>
+#include <QVariantMap>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace {
+
+struct BatchItem
+{
+    QString directory;
+    QString name;
+    int index;
+
+    bool operator<(const BatchItem &other) const
+    {
+        const int rv = directory.compare(other.directory);
+        return rv != 0 ? rv < 0 : name < other.name;
+    }
+};
+
+QMimeType detectMimeType(const QMimeDatabase &mimeDatabase, int dirFd, const BatchItem &item,
+                         const QString &path, const struct stat64 &st)
+{
+    if (st.st_mode == 0) {
+        return mimeDatabase.mimeTypeForFile(path, QMimeDatabase::MatchExtension);
+    } else if (S_ISDIR(st.st_mode)) {
+        return mimeDatabase.mimeTypeForName(QStringLiteral("inode/directory"));
+    } else if (!S_ISREG(st.st_mode)) {
+        return mimeDatabase.mimeTypeForFile(QFileInfo(path));
+    }
+
+    const int fd = openat(dirFd, QFile::encodeName(item.name).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return mimeDatabase.mimeTypeForFile(path, QMimeDatabase::MatchExtension);
+    }
+
+    QFile file;
+    if (!file.open(fd, QIODevice::ReadOnly, QFileDevice::AutoCloseHandle)) {
+        close(fd);
+        return mimeDatabase.mimeTypeForFile(path, QMimeDatabase::MatchExtension);
+    }
+    return mimeDatabase.mimeTypeForFileNameAndData(path, &file);
+}
+
+QVariantMap toVariantMap(const StatFileInfo &info)
+{
+    QVariantMap rv;
+    rv.insert(QStringLiteral("path"), info.file());
+    rv.insert(QStringLiteral("fileName"), info.fileName());
+    rv.insert(QStringLiteral("exists"), info.exists());
+    rv.insert(QStringLiteral("size"), info.size());
+    rv.insert(QStringLiteral("lastModified"), info.lastModified());
+    rv.insert(QStringLiteral("mimeType"), info.mimeType());
+    rv.insert(QStringLiteral("isDir"), info.isDirAtEnd());
+    rv.insert(QStringLiteral("isLink"), info.isSymLink());
+    return rv;
+}
+
+QVariantList queryFiles(const QStringList &paths)
+{
+    QVariantList rv;
+    foreach (const StatFileInfo &info, FileInfoBatch::read(paths)) {
+        rv.append(toVariantMap(info));
+    }
+    return rv;
+}
+
+}
+
+FileInfoBatch::FileInfoBatch(QObject *parent)
+    : QObject(parent)
+    , m_pending(0)
+{
+}
+
+FileInfoBatch::~FileInfoBatch()
+{
+}
+
+QVector<StatFileInfo> FileInfoBatch::read(const QStringList &paths, ReadFlags flags)
+{
+    const bool detectMimeTypes = flags & DetectMimeTypes;
+    StatCache *cache = (flags & UseStatCache) ? StatCache::instance() : nullptr;
+
+    QVector<StatFileInfo> rv(paths.count());
+    QVector<BatchItem> items;
+    items.reserve(paths.count());
+
+    for (int i = 0; i < paths.count(); ++i) {
+        const QString &path = paths.at(i);
+        if (cache && cache->lookup(path, detectMimeTypes, &rv[i]))
+            continue;
+        const int index = path.lastIndexOf(QLatin1Char('/'));
+
+        BatchItem item;
+        if (index < 0) {
+            item.directory = QStringLiteral(".");
+            item.name = path;
+        } else {
+            item.directory = index > 0 ? path.left(index) : QStringLiteral("/");
+            item.name = path.mid(index + 1);
+        }
+        if (item.name.isEmpty()) {
+            // a path with a trailing slash, inspect it as a whole
+            item.directory = QStringLiteral(".");
+            item.name = path;
+        }
+        item.index = i;
+        items.append(item);
+    }
+
+    std::sort(items.begin(), items.end());
+
+    QMimeDatabase mimeDatabase;
+    QString directory;
+    int dirFd = -1;
+    bool cached = false;
+    quint64 generation = 0;
+
+    foreach (const BatchItem &item, items) {
+        if (dirFd < 0 || item.directory != directory) {
+            if (dirFd >= 0)
+                close(dirFd);
+            directory = item.directory;
+            // only what is read after the directory is watched can be cached
+            cached = cache && cache->watch(directory, &generation);
+            dirFd = open(QFile::encodeName(directory).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        }
+
+        const QString &path = paths.at(item.index);
+        const QByteArray name = QFile::encodeName(item.name);
+
+        StatFileInfo::StatData data;
+        if (dirFd >= 0) {
+            StatFileInfo::readStatData(dirFd, name.constData(), &data);
+        } else {
+            memset(&data.lstat, 0, sizeof(data.lstat));
+            memset(&data.stat, 0, sizeof(data.stat));
+            data.birthTime = -1;
+            data.fields = StatFileInfo::BasicStats | StatFileInfo::FullStats;
+        }
+
+        const QMimeType mimeType = detectMimeTypes
+                ? detectMimeType(mimeDatabase, dirFd, item, path, data.stat)
+                : QMimeType();
+        rv[item.index] = StatFileInfo(path, data, mimeType);
+
+        if (cached)
+            cache->insert(rv.at(item.index), generation, detectMimeTypes);
+    }
+
+    if (dirFd >= 0)
+        close(dirFd);
+
+    return rv;
+}
+
+void FileInfoBatch::query(const QStringList &paths, QJSValue callback)
+{
+    ++m_pending;
+    if (m_pending == 1)
+        emit workingChanged();
+
+    QFutureWatcher<QVariantList> *watcher = new QFutureWatcher<QVariantList>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, callback]() mutable {
+        watcher->deleteLater();
+
+        if (callback.isCallable()) {
+            QJSValue result = callback.call(QJSValueList() << callback.engine()->toScriptValue(watcher->result()));
+            if (result.isError()) {
+                qmlInfo(this) << "Error on file info batch callback " << result.toString();
+            }
+        }
+
+        --m_pending;
+        if (m_pending == 0)
+            emit workingChanged();
+    });
+    watcher->setFuture(QtConcurrent::run(queryFiles, paths));
+}
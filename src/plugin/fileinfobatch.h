@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef FILEINFOBATCH_H
+#define FILEINFOBATCH_H
+
+#include "statfileinfo.h"
+
+#include <QJSValue>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief The FileInfoBatch class reads the information of many files at once.
+ * The files are visited directory by directory, and each directory is opened only once so that
+ * the files can be inspected relative to it without resolving the full path again.
+ */
+class FileInfoBatch : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool working READ working NOTIFY workingChanged)
+
+public:
+    enum ReadFlag {
+        NoReadFlags = 0x0,
+        DetectMimeTypes = 0x1,
+        // use and update the shared StatCache
+        UseStatCache = 0x2
+    };
+    Q_DECLARE_FLAGS(ReadFlags, ReadFlag)
+
+    explicit FileInfoBatch(QObject *parent = nullptr);
+    ~FileInfoBatch() override;
+
+    // reads the given files on the calling thread, the results are in the order of paths
+    static QVector<StatFileInfo> read(const QStringList &paths,
+                                      ReadFlags flags = ReadFlags(DetectMimeTypes | UseStatCache));
+
+    // Reads the given files on a worker thread, then calls callback with an array of objects
+    // with path, fileName, exists, size, lastModified, mimeType, isDir and isLink properties
+    Q_INVOKABLE void query(const QStringList &paths, QJSValue callback);
+
+    bool working() const { return m_pending > 0; }
+
+signals:
+    void workingChanged();
+
+private:
+    int m_pending;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(FileInfoBatch::ReadFlags)
+
+#endif // FILEINFOBATCH_H
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "fileinforesolver.h"
+#include "fileinfobatch.h"
+
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QSet>
+#include <QTimerEvent>
+#include <QtConcurrent>
+
+namespace {
+
+QHash<QString, StatFileInfo> resolveFiles(const QStringList &paths)
+{
+    const QVector<StatFileInfo> infos = FileInfoBatch::read(paths);
+
+    QHash<QString, StatFileInfo> rv;
+    rv.reserve(paths.count());
+    for (int i = 0; i < paths.count(); ++i) {
+        rv.insert(paths.at(i), infos.at(i));
+    }
+    return rv;
+}
+
+}
+
+FileInfoResolver::FileInfoResolver(QObject *parent)
+    : QObject(parent)
+{
+}
+
+FileInfoResolver *FileInfoResolver::instance()
+{
+    static FileInfoResolver *instance = new FileInfoResolver(QCoreApplication::instance());
+    return instance;
+}
+
+void FileInfoResolver::request(FileInfo *info, const QString &path, quint64 serial)
+{
+    Request request;
+    request.target = info;
+    request.path = path;
+    request.serial = serial;
+    m_requests.append(request);
+
+    // collect the requests made before returning to the event loop
+    if (!m_timer.isActive())
+        m_timer.start(0, this);
+}
+
+void FileInfoResolver::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() != m_timer.timerId()) {
+        QObject::timerEvent(event);
+        return;
+    }
+
+    m_timer.stop();
+
+    const QVector<Request> requests = m_requests;
+    m_requests.clear();
+
+    QSet<QString> uniquePaths;
+    foreach (const Request &request, requests) {
+        if (request.target)
+            uniquePaths.insert(request.path);
+    }
+    const QStringList paths = uniquePaths.toList();
+    if (paths.isEmpty())
+        return;
+
+    QFutureWatcher<QHash<QString, StatFileInfo> > *watcher = new QFutureWatcher<QHash<QString, StatFileInfo> >(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [watcher, requests]() {
+        watcher->deleteLater();
+
+        const QHash<QString, StatFileInfo> results = watcher->result();
+        foreach (const Request &request, requests) {
+            if (request.target)
+                request.target->setResolved(results.value(request.path), request.serial);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(resolveFiles, paths));
+}
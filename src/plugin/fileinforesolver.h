@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef FILEINFORESOLVER_H
+#define FILEINFORESOLVER_H
+
+#include "statfileinfo.h"
+
+#include <QBasicTimer>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+/**
+ * @brief The FileInfoResolver class reads the information of asynchronous FileInfo items on a
+ * worker thread. Requests made during one event loop iteration are collected and resolved
+ * together with FileInfoBatch, so that a page creating many items does a single pass over the files.
+ */
+class FileInfoResolver : public QObject
+{
+    Q_OBJECT
+
+public:
+    static FileInfoResolver *instance();
+
+    // resolves path for info, the result is delivered with FileInfo::setResolved()
+    void request(FileInfo *info, const QString &path, quint64 serial);
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    explicit FileInfoResolver(QObject *parent = 0);
+
+    struct Request
+    {
+        QPointer<FileInfo> target;
+        QString path;
+        quint64 serial;
+    };
+
+    QVector<Request> m_requests;
+    QBasicTimer m_timer;
+};
+
+#endif // FILEINFORESOLVER_H
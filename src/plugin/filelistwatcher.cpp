@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "filelistwatcher.h"
+#include "fileinfobatch.h"
+
+#include <QFileInfo>
+#include <QSet>
+#include <QTimerEvent>
+
+#include <sys/inotify.h>
+
+namespace {
+
+// how often the files whose directories are missing are tried again
+const int RetryInterval = 5000;
+
+QString pathKey(const QString &directory, const QString &name)
+{
+    return directory + QLatin1Char('/') + name;
+}
+
+}
+
+FileListWatcher::FileListWatcher(QObject *parent)
+    : QObject(parent)
+{
+}
+
+FileListWatcher::~FileListWatcher()
+{
+    foreach (const QString &fileName, m_fileNames)
+        removeFile(fileName);
+}
+
+QStringList FileListWatcher::fileNames() const
+{
+    return m_fileNames;
+}
+
+void FileListWatcher::setFileNames(const QStringList &fileNames)
+{
+    QStringList uniqueFileNames = fileNames;
+    uniqueFileNames.removeAll(QString());
+    uniqueFileNames.removeDuplicates();
+    if (m_fileNames == uniqueFileNames)
+        return;
+
+    const QStringList existing = existingFiles();
+    const QSet<QString> newFileNames = uniqueFileNames.toSet();
+
+    foreach (const QString &fileName, m_fileNames) {
+        if (!newFileNames.contains(fileName))
+            removeFile(fileName);
+    }
+
+    QStringList added;
+    foreach (const QString &fileName, uniqueFileNames) {
+        if (!m_entries.contains(fileName))
+            added.append(fileName);
+    }
+
+    m_fileNames = uniqueFileNames;
+    addFiles(added);
+
+    emit fileNamesChanged();
+    if (existingFiles() != existing)
+        emit existingFilesChanged();
+}
+
+QStringList FileListWatcher::existingFiles() const
+{
+    QStringList rv;
+    foreach (const QString &fileName, m_fileNames) {
+        if (m_entries.value(fileName).exists)
+            rv.append(fileName);
+    }
+    return rv;
+}
+
+bool FileListWatcher::exists(const QString &fileName) const
+{
+    return m_entries.value(fileName).exists;
+}
+
+bool FileListWatcher::watch(const QString &directory, const QString &name)
+{
+    if (!InotifyWatcher::instance()->addWatch(directory, name, this)) {
+        if (!m_retryTimer.isActive())
+            m_retryTimer.start(RetryInterval, this);
+        return false;
+    }
+    m_watchedPaths.insert(pathKey(directory, name));
+    return true;
+}
+
+void FileListWatcher::watchFiles()
+{
+    QStringList watched;
+    QSet<QString> failed;
+    for (QHash<QString, Entry>::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        const QString key = pathKey(it->directory, it->name);
+        if (m_watchedPaths.contains(key) || failed.contains(key))
+            continue;
+        if (watch(it->directory, it->name)) {
+            watched += m_fileNamesByPath.values(key);
+        } else {
+            failed.insert(key);
+        }
+    }
+    if (failed.isEmpty())
+        m_retryTimer.stop();
+
+    // the changes made while they were not watched
+    testFilesExist(watched);
+}
+
+void FileListWatcher::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_retryTimer.timerId()) {
+        watchFiles();
+    } else {
+        QObject::timerEvent(event);
+    }
+}
+
+void FileListWatcher::addFiles(const QStringList &fileNames)
+{
+    // watch before reading, so that no change is missed
+    foreach (const QString &fileName, fileNames) {
+        const QFileInfo fileInfo(fileName);
+
+        Entry entry;
+        entry.directory = fileInfo.absolutePath();
+        entry.name = fileInfo.fileName();
+        entry.exists = false;
+        m_entries.insert(fileName, entry);
+
+        // several file names may refer to the same file, it is registered once
+        const QString key = pathKey(entry.directory, entry.name);
+        if (!m_fileNamesByPath.contains(key))
+            watch(entry.directory, entry.name);
+        m_fileNamesByPath.insert(key, fileName);
+    }
+
+    const QVector<StatFileInfo> infos = FileInfoBatch::read(fileNames, FileInfoBatch::NoReadFlags);
+    for (int i = 0; i < fileNames.count(); ++i)
+        m_entries[fileNames.at(i)].exists = infos.at(i).exists();
+}
+
+void FileListWatcher::removeFile(const QString &fileName)
+{
+    const Entry entry = m_entries.take(fileName);
+    const QString key = pathKey(entry.directory, entry.name);
+
+    m_fileNamesByPath.remove(key, fileName);
+    if (!m_fileNamesByPath.contains(key) && m_watchedPaths.remove(key))
+        InotifyWatcher::instance()->removeWatch(entry.directory, entry.name, this);
+}
+
+bool FileListWatcher::setExists(const QString &fileName, bool exists)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(fileName);
+    if (it == m_entries.end() || it->exists == exists)
+        return false;
+
+    it->exists = exists;
+    if (exists) {
+        emit fileAdded(fileName);
+    } else {
+        emit fileRemoved(fileName);
+    }
+    return true;
+}
+
+void FileListWatcher::testFilesExist(const QStringList &fileNames)
+{
+    if (fileNames.isEmpty())
+        return;
+
+    const QVector<StatFileInfo> infos = FileInfoBatch::read(fileNames, FileInfoBatch::NoReadFlags);
+    bool changed = false;
+    for (int i = 0; i < fileNames.count(); ++i)
+        changed |= setExists(fileNames.at(i), infos.at(i).exists());
+
+    if (changed)
+        emit existingFilesChanged();
+}
+
+void FileListWatcher::directoryEvent(const QString &directory, const InotifyWatcher::Event &event)
+{
+    if (event.mask & (IN_IGNORED | IN_MOVE_SELF)) {
+        // InotifyWatcher drops the watch once the event is handled, the files are watched again
+        // after that if there is a directory at the path by then, or once there is one
+        bool dropped = false;
+        for (QHash<QString, Entry>::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            if (it->directory == directory)
+                dropped |= m_watchedPaths.remove(pathKey(it->directory, it->name));
+        }
+        // delivered once for every name watched in the directory
+        if (!dropped)
+            return;
+        QMetaObject::invokeMethod(this, "watchFiles", Qt::QueuedConnection);
+    }
+
+    if (event.name.isEmpty()) {
+        // the directory itself changed or events were lost, check all its files again
+        QStringList fileNames;
+        for (QHash<QString, Entry>::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            if (it->directory == directory)
+                fileNames.append(it.key());
+        }
+        testFilesExist(fileNames);
+        return;
+    }
+
+    // paths that end with a slash are registered without a name and receive every event
+    testFilesExist(m_fileNamesByPath.values(pathKey(directory, QString())));
+
+    const QStringList fileNames = m_fileNamesByPath.values(pathKey(directory, event.name));
+    if (fileNames.isEmpty())
+        return;
+
+    bool exists;
+    if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+        exists = true;
+    } else if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+        exists = false;
+    } else {
+        testFilesExist(fileNames);
+        return;
+    }
+
+    bool changed = false;
+    foreach (const QString &fileName, fileNames)
+        changed |= setExists(fileName, exists);
+
+    if (changed)
+        emit existingFilesChanged();
+}
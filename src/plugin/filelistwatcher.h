@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef FILELISTWATCHER_H
+#define FILELISTWATCHER_H
+
+#include <QBasicTimer>
+#include <QHash>
+#include <QMultiHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+#include "inotifywatcher.h"
+
+/**
+ * @brief The FileListWatcher class tells which of a set of files exist.
+ * The files are watched through their parent directories, which are shared with all the other
+ * watchers, and the state is updated from the names in the change events rather than by checking
+ * every file again.
+ */
+class FileListWatcher : public QObject, private InotifyWatcher::Listener
+{
+    Q_OBJECT
+    Q_PROPERTY(QStringList fileNames READ fileNames WRITE setFileNames NOTIFY fileNamesChanged)
+    Q_PROPERTY(QStringList existingFiles READ existingFiles NOTIFY existingFilesChanged)
+
+public:
+    explicit FileListWatcher(QObject *parent = 0);
+    ~FileListWatcher();
+
+    QStringList fileNames() const;
+    void setFileNames(const QStringList &fileNames);
+
+    // the existing files in the order of fileNames
+    QStringList existingFiles() const;
+
+    Q_INVOKABLE bool exists(const QString &fileName) const;
+
+signals:
+    void fileNamesChanged();
+    void existingFilesChanged();
+    void fileAdded(const QString &fileName);
+    void fileRemoved(const QString &fileName);
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private slots:
+    void watchFiles();
+
+private:
+    struct Entry
+    {
+        QString directory;
+        QString name;
+        bool exists;
+    };
+
+    void directoryEvent(const QString &directory, const InotifyWatcher::Event &event) override;
+    bool watch(const QString &directory, const QString &name);
+    void addFiles(const QStringList &fileNames);
+    void removeFile(const QString &fileName);
+    bool setExists(const QString &fileName, bool exists);
+    void testFilesExist(const QStringList &fileNames);
+
+    QStringList m_fileNames;
+    QHash<QString, Entry> m_entries; // by file name
+    QMultiHash<QString, QString> m_fileNamesByPath; // by the watched directory and name
+    // the keys of m_fileNamesByPath registered with InotifyWatcher, the others are retried
+    // while their directories are missing
+    QSet<QString> m_watchedPaths;
+    QBasicTimer m_retryTimer;
+};
+
+#endif // FILELISTWATCHER_H
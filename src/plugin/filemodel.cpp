@@ -31,13 +31,19 @@
  */
 
 #include "filemodel.h"
+#include "directoryindex.h"
+#include "directorypoller.h"
+#include "directorysize.h"
+#include "statcache.h"
 
 #include <QDateTime>
 #include <QDebug>
+#include <QFutureWatcher>
 #include <QMimeType>
 #include <QQmlInfo>
 #include <QTimerEvent>
 #include <QUrl>
+#include <QtConcurrent>
 
 #ifndef DESKTOP
 #include "synchronizelists.h"
@@ -49,24 +55,6 @@
 
 namespace {
 
-enum {
-    FileNameRole = Qt::UserRole + 1,
-    MimeTypeRole,
-    SizeRole,
-    LastModifiedRole,
-    CreatedRole,
-    IsDirRole,
-    IsArchiveRole,
-    IsLinkRole,
-    SymLinkTargetRole,
-    IsSelectedRole,
-    ExtensionRole,
-    AbsolutePathRole,
-    LastAccessedRole,
-    BaseNameRole,
-    UrlRole
-};
-
 bool isDirAccessible(QString fileName)
 {
     QByteArray fab = fileName.toUtf8();
@@ -92,13 +80,31 @@ QVector<StatFileInfo> directoryEntries(const QDir &dir)
             continue;
         }
         QString fullpath = dir.absoluteFilePath(fileName);
-        StatFileInfo info(fullpath);
-        rv.append(info);
+        rv.append(StatCache::instance()->fileInfo(fullpath));
     }
 
     return rv;
 }
 
+struct DirectoryListing
+{
+    DirectoryIndex::Stamp stamp;
+    QVector<StatFileInfo> entries;
+};
+
+DirectoryListing readListing(const QDir &dir)
+{
+    DirectoryListing rv;
+    rv.stamp = DirectoryIndex::stamp(dir.absolutePath());
+    rv.entries = directoryEntries(dir);
+    return rv;
+}
+
+int maximumInactiveEntries = 10000;
+
+// inactive models from the most to the least recently used
+QList<FileModel *> inactiveModels;
+
 }
 
 FileModel::FileModel(QObject *parent)
@@ -116,15 +122,18 @@ FileModel::FileModel(QObject *parent)
     , m_active(false)
     , m_dirty(false)
     , m_populated(false)
+    , m_evicted(false)
+    , m_calculateDirectorySizes(false)
     , m_selectedCount(0)
+    , m_listingGeneration(0)
+    , m_poller(nullptr)
 {
-    m_watcher = new QFileSystemWatcher(this);
-    connect(m_watcher, SIGNAL(directoryChanged(const QString&)), this, SLOT(scheduleContentChange()));
-    connect(m_watcher, SIGNAL(fileChanged(const QString&)), this, SLOT(scheduleContentChange()));
 }
 
 FileModel::~FileModel()
 {
+    inactiveModels.removeOne(this);
+    unwatchDirectory();
 }
 
 int FileModel::rowCount(const QModelIndex &parent) const
@@ -139,80 +148,56 @@ QVariant FileModel::data(const QModelIndex &index, int role) const
         return QVariant();
 
     const StatFileInfo &info = m_files.at(index.row());
-    switch (role) {
-
-    case Qt::DisplayRole:
-    case FileNameRole:
-        return info.fileName();
-
-    case MimeTypeRole:
-        return info.mimeType();
-
-    case SizeRole:
-        return info.size();
-
-    case LastModifiedRole:
-        return info.lastModified();
 
-    case CreatedRole:
-        return info.created();
+    if (role == DirectorySizeRole || role == ChildCountRole)
+        return directorySizeData(info, role);
 
-    case IsDirRole:
-        return info.isDirAtEnd();
-
-    case IsArchiveRole:
-        return info.isArchive();
-
-    case IsLinkRole:
-        return info.isSymLink();
-
-    case SymLinkTargetRole:
-        return info.symLinkTarget();
+    return info.roleData(role);
+}
 
-    case IsSelectedRole:
-        return info.isSelected();
+QHash<int, QByteArray> FileModel::roleNames() const
+{
+    QHash<int, QByteArray> roles = QAbstractListModel::roleNames();
+    roles.unite(StatFileInfo::roleNames());
+    roles.insert(DirectorySizeRole, QByteArrayLiteral("directorySize"));
+    roles.insert(ChildCountRole, QByteArrayLiteral("childCount"));
+    return roles;
+}
 
-    case ExtensionRole:
-        return info.extension();
+QVariant FileModel::directorySizeData(const StatFileInfo &info, int role) const
+{
+    if (!m_calculateDirectorySizes || !info.isDirAtEnd() || info.fileName() == QLatin1String(".."))
+        return QVariant();
 
-    case AbsolutePathRole:
-        return info.absoluteFilePath();
+    // undefined until the calculation finishes, directorySizeReady() updates the row then
+    const DirectorySize::Result result = DirectorySize::instance()->lookup(info.absoluteFilePath());
+    if (!result.isValid())
+        return QVariant();
 
-    case LastAccessedRole:
-        return info.lastAccessed();
+    return role == DirectorySizeRole ? QVariant(result.size) : QVariant(result.childCount);
+}
 
-    case BaseNameRole:
-        return info.baseName();
+void FileModel::directorySizeReady(const QString &path)
+{
+    const int index = path.lastIndexOf(QLatin1Char('/'));
+    if (index < 0)
+        return;
 
-    case UrlRole:
-        return QUrl::fromLocalFile(info.absoluteFilePath()).toString();
+    // the root directory is the only one with a trailing slash
+    const QString parentPath = index > 0 ? path.left(index) : QStringLiteral("/");
+    if (parentPath != m_absolutePath)
+        return;
 
-    default:
-        return QVariant();
+    const QString fileName = path.mid(index + 1);
+    for (int row = 0; row < m_files.count(); ++row) {
+        if (m_files.at(row).fileName() == fileName) {
+            const QModelIndex modelIndex = createIndex(row, 0);
+            emit dataChanged(modelIndex, modelIndex, QVector<int>() << DirectorySizeRole << ChildCountRole);
+            break;
+        }
     }
 }
 
-QHash<int, QByteArray> FileModel::roleNames() const
-{
-    QHash<int, QByteArray> roles = QAbstractListModel::roleNames();
-    roles.insert(FileNameRole, QByteArray("fileName"));
-    roles.insert(MimeTypeRole, QByteArray("mimeType"));
-    roles.insert(SizeRole, QByteArray("size"));
-    roles.insert(LastModifiedRole, QByteArray("modified"));
-    roles.insert(CreatedRole, QByteArray("created"));
-    roles.insert(IsDirRole, QByteArray("isDir"));
-    roles.insert(IsArchiveRole, QByteArray("isArchive"));
-    roles.insert(IsLinkRole, QByteArray("isLink"));
-    roles.insert(SymLinkTargetRole, QByteArray("symLinkTarget"));
-    roles.insert(IsSelectedRole, QByteArray("isSelected"));
-    roles.insert(ExtensionRole, QByteArray("extension"));
-    roles.insert(AbsolutePathRole, QByteArray("absolutePath"));
-    roles.insert(LastAccessedRole, QByteArray("accessed"));
-    roles.insert(BaseNameRole, QByteArray("baseName"));
-    roles.insert(UrlRole, QByteArray("url"));
-    return roles;
-}
-
 int FileModel::count() const
 {
     return m_files.count();
@@ -223,30 +208,49 @@ void FileModel::setPath(QString path)
     if (m_path == path)
         return;
 
+    discardSnapshot();
+
     if (m_populated) {
         m_populated = false;
         emit populatedChanged();
     }
 
     // update watcher to watch the new directory
-    if (!m_path.isEmpty())
-        m_watcher->removePath(m_path);
+    unwatchDirectory();
 
-    if (!path.isEmpty()) {
-        if (QFile::exists(path)) {
-            m_watcher->addPath(path);
-        } else {
-            qWarning() << "Path of FileModel doesn't exist";
-        }
-    }
+    if (!path.isEmpty() && !QFile::exists(path))
+        qWarning() << "Path of FileModel doesn't exist";
 
     m_path = path;
     m_absolutePath = QString();
     m_directory = QString();
     m_parentPath = QString();
+    watchDirectory();
     scheduleUpdate(PathChanged);
 }
 
+void FileModel::setCalculateDirectorySizes(bool calculate)
+{
+    if (m_calculateDirectorySizes == calculate)
+        return;
+
+    m_calculateDirectorySizes = calculate;
+
+    if (calculate) {
+        connect(DirectorySize::instance(), &DirectorySize::resultReady,
+                this, &FileModel::directorySizeReady, Qt::UniqueConnection);
+    } else {
+        disconnect(DirectorySize::instance(), &DirectorySize::resultReady,
+                   this, &FileModel::directorySizeReady);
+    }
+
+    if (!m_files.isEmpty()) {
+        emit dataChanged(createIndex(0, 0), createIndex(m_files.count() - 1, 0),
+                         QVector<int>() << DirectorySizeRole << ChildCountRole);
+    }
+    emit calculateDirectorySizesChanged();
+}
+
 void FileModel::setSortBy(Sort sortBy)
 {
     if (m_sortBy == sortBy)
@@ -343,10 +347,149 @@ void FileModel::setActive(bool active)
         return;
 
     m_active = active;
+    if (m_poller)
+        m_poller->setActive(m_active);
+
+    inactiveModels.removeOne(this);
+    if (m_active) {
+        restore();
+    } else {
+        inactiveModels.prepend(this);
+    }
+
     scheduleUpdate(m_active ? (ActiveChanged | ContentChanged)
                             : ActiveChanged);
 }
 
+int FileModel::inactiveEntryLimit()
+{
+    return maximumInactiveEntries;
+}
+
+void FileModel::setInactiveEntryLimit(int limit)
+{
+    maximumInactiveEntries = limit;
+    trimInactiveModels();
+}
+
+void FileModel::trimInactiveModels()
+{
+    int entries = 0;
+    foreach (FileModel *model, inactiveModels) {
+        if (!model->m_evicted)
+            entries += model->m_files.count();
+    }
+
+    // evict the least recently used models first
+    for (int i = inactiveModels.count() - 1; i >= 0 && entries > maximumInactiveEntries; --i) {
+        FileModel *model = inactiveModels.at(i);
+        const int count = model->m_files.count();
+        model->evict();
+        if (model->m_evicted)
+            entries -= count;
+    }
+}
+
+void FileModel::evict()
+{
+    // keep models with a selection or with an update pending as they are
+    if (m_evicted || !m_populated || m_files.isEmpty() || m_selectedCount > 0 || m_timer.isActive())
+        return;
+
+    m_snapshot = DirectoryIndex::serialize(directory(), DirectoryIndex::Stamp(), m_files);
+    m_evicted = true;
+    ++m_listingGeneration;
+
+    // the directory is read again when activated, so there's no need to watch it meanwhile
+    unwatchDirectory();
+
+    clearModel();
+    m_files.squeeze();
+    emit countChanged();
+}
+
+void FileModel::restore()
+{
+    if (!m_evicted)
+        return;
+
+    QVector<StatFileInfo> files;
+    const bool restored = DirectoryIndex::deserialize(m_snapshot, directory(), DirectoryIndex::Stamp(), &files);
+    discardSnapshot();
+
+    if (!restored || files.isEmpty()) {
+        // read the directory from scratch
+        m_populated = false;
+        emit populatedChanged();
+        return;
+    }
+
+    // the following content update applies the changes since the eviction as a diff
+    beginInsertRows(QModelIndex(), 0, files.count() - 1);
+    m_files = files;
+    endInsertRows();
+    emit countChanged();
+}
+
+void FileModel::discardSnapshot()
+{
+    if (!m_evicted)
+        return;
+
+    m_snapshot.clear();
+    m_evicted = false;
+
+    watchDirectory();
+}
+
+void FileModel::watchDirectory()
+{
+    if (!m_watchedPath.isEmpty() || m_path.isEmpty())
+        return;
+
+    const QString path = QDir(m_path).absolutePath();
+    if (!InotifyWatcher::instance()->addWatch(path, QString(), this, InotifyWatcher::ChangeEvents)) {
+        pollDirectory(path);
+        return;
+    }
+    m_watchedPath = path;
+
+    // inotify misses the changes made elsewhere on some file systems, which may take a while to
+    // find out, e.g. on a network share that is slow to answer
+    QFutureWatcher<bool> *watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, path]() {
+        watcher->deleteLater();
+        if (watcher->result() && m_watchedPath == path)
+            pollDirectory(path);
+    });
+    watcher->setFuture(QtConcurrent::run(DirectoryPoller::needsPolling, path));
+}
+
+void FileModel::pollDirectory(const QString &path)
+{
+    if (!m_poller) {
+        m_poller = new DirectoryPoller(this);
+        connect(m_poller, &DirectoryPoller::directoryChanged, this, [this](const QString &directory) {
+            StatCache::instance()->invalidateDirectory(directory);
+            scheduleContentChange();
+        });
+    }
+    m_poller->setActive(m_active);
+    m_poller->setPath(path);
+}
+
+void FileModel::unwatchDirectory()
+{
+    if (m_poller)
+        m_poller->setPath(QString());
+
+    if (m_watchedPath.isEmpty())
+        return;
+
+    InotifyWatcher::instance()->removeWatch(m_watchedPath, QString(), this);
+    m_watchedPath.clear();
+}
+
 void FileModel::setErrorType(Error errorType)
 {
     if (m_errorType == errorType)
@@ -444,18 +587,20 @@ QStringList FileModel::selectedFiles() const
 
 void FileModel::refresh()
 {
-    if (m_watcher->directories().isEmpty() && m_watcher->files().isEmpty() && !m_path.isEmpty()) {
-        m_watcher->addPath(m_path);
-    }
+    watchDirectory();
+
+    if (!m_absolutePath.isEmpty())
+        StatCache::instance()->invalidateDirectory(m_absolutePath);
 
     scheduleContentChange();
 }
 
 void FileModel::refreshFull()
 {
-    if (m_watcher->directories().isEmpty() && m_watcher->files().isEmpty() && !m_path.isEmpty()) {
-        m_watcher->addPath(m_path);
-    }
+    watchDirectory();
+
+    if (!m_absolutePath.isEmpty())
+        StatCache::instance()->invalidateDirectory(m_absolutePath);
 
     if (!m_active) {
         m_dirty = true;
@@ -470,6 +615,41 @@ void FileModel::refreshFull()
     scheduleUpdate();
 }
 
+void FileModel::directoryEvent(const QString &directory, const InotifyWatcher::Event &event)
+{
+    if (event.mask & (IN_IGNORED | IN_MOVE_SELF)) {
+        // the watch has been dropped, it is added again on refresh
+        m_watchedPath.clear();
+    }
+
+    if (!event.name.isEmpty()) {
+        const QString fileName = InotifyWatcher::filePath(directory, event.name);
+        if (event.mask & IN_CREATE) {
+            emit fileCreated(fileName);
+        } else if (event.mask & IN_DELETE) {
+            emit fileDeleted(fileName);
+        } else if (event.mask & IN_MOVED_FROM) {
+            emit fileMoved(fileName, event.movedPath);
+        } else if (event.mask & IN_MOVED_TO) {
+            // a rename within the directory was reported with its first half
+            if (event.movedPath.isEmpty() || QFileInfo(event.movedPath).absolutePath() != directory)
+                emit fileMoved(event.movedPath, fileName);
+        } else if (event.mask & IN_CLOSE_WRITE) {
+            emit fileModified(fileName);
+        } else if (event.mask & IN_ATTRIB) {
+            emit fileAttributesChanged(fileName);
+        }
+    }
+
+    // the shared cache may not have seen the change yet
+    if (event.name.isEmpty()) {
+        StatCache::instance()->invalidateDirectory(directory);
+    } else {
+        StatCache::instance()->invalidate(InotifyWatcher::filePath(directory, event.name));
+    }
+    scheduleContentChange();
+}
+
 void FileModel::scheduleContentChange()
 {
     if (!m_active) {
@@ -486,6 +666,8 @@ void FileModel::readDirectory()
     beginResetModel();
 
     m_files.clear();
+    ++m_listingGeneration;
+    discardSnapshot();
     if (!m_path.isEmpty())
         readAllEntries();
 
@@ -529,12 +711,60 @@ void FileModel::readAllEntries()
     m_absolutePath = dir.absolutePath();
     m_directory = dir.isRoot() ? QStringLiteral("/") : dir.dirName();
     m_parentPath = dir.isRoot() ? QString() : QDir::cleanPath(dir.absoluteFilePath(QStringLiteral("..")));
-    m_files = directoryEntries(dir);
+
+    if (DirectoryIndex::load(dir, &m_files)) {
+        // Show the indexed listing right away and check it against the disk in the background
+        reconcileEntries(dir);
+        return;
+    }
+
+    const DirectoryListing listing = readListing(dir);
+    m_files = listing.entries;
+    DirectoryIndex::save(dir, listing.stamp, m_files);
+}
+
+void FileModel::reconcileEntries(const QDir &dir)
+{
+    const int generation = m_listingGeneration;
+
+    // so that the files read in the background can be cached
+    StatCache::instance()->watch(dir.absolutePath());
+
+    QFutureWatcher<DirectoryListing> *watcher = new QFutureWatcher<DirectoryListing>(this);
+    connect(watcher, &QFutureWatcher<DirectoryListing>::finished, this, [this, watcher, generation, dir]() {
+        watcher->deleteLater();
+
+        // The listing has been read again meanwhile
+        if (generation != m_listingGeneration)
+            return;
+
+        const DirectoryListing listing = watcher->result();
+        const int oldCount = m_files.count();
+
+#ifdef DESKTOP
+        beginResetModel();
+        m_files = listing.entries;
+        endResetModel();
+#else
+        ::synchronizeList(this, m_files, listing.entries);
+#endif
+
+        DirectoryIndex::save(dir, listing.stamp, listing.entries);
+
+        recountSelectedFiles();
+        if (m_files.count() != oldCount) {
+            m_changedFlags |= CountChanged;
+        }
+        scheduleUpdate();
+    });
+    watcher->setFuture(QtConcurrent::run(readListing, dir));
 }
 
 void FileModel::refreshEntries()
 {
     int oldCount = m_files.count();
+    ++m_listingGeneration;
+    discardSnapshot();
 
     if (m_path.isEmpty()) {
         clearModel();
@@ -555,12 +785,14 @@ void FileModel::refreshEntries()
         }
 
         // read all files
-        QVector<StatFileInfo> newFiles = directoryEntries(dir);
+        const DirectoryListing listing = readListing(dir);
+        QVector<StatFileInfo> newFiles = listing.entries;
 #ifdef DESKTOP
         m_files = newFiles;
 #else
         ::synchronizeList(this, m_files, newFiles);
 #endif
+        DirectoryIndex::save(dir, listing.stamp, listing.entries);
     }
 
     setErrorType(NoError);
@@ -731,6 +963,9 @@ void FileModel::update()
 
     m_changedFlags = 0;
     m_dirty = false;
+
+    if (!m_active)
+        trimInactiveModels();
 }
 
 void FileModel::timerEvent(QTimerEvent *event)
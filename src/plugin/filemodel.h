@@ -33,23 +33,26 @@
 #ifndef FILEMODEL_H
 #define FILEMODEL_H
 
+#include "inotifywatcher.h"
 #include "statfileinfo.h"
 
 #include <QAbstractListModel>
 #include <QBasicTimer>
 #include <QDir>
-#include <QFileSystemWatcher>
 #include <QVector>
 
+class DirectoryPoller;
+
 /**
  * @brief The FileModel class can be used as a model in a ListView to display a list of files
  * in the current directory. It has methods to change the current directory and to access
  * file info.
  * It also actively monitors the directory. If the directory changes, then the model is
  * updated automatically if active is true. If active is false, then the directory is
- * updated when active becomes true.
+ * updated when active becomes true. Inactive models beyond inactiveEntryLimit() release their
+ * entries and directory watch, and restore them from a snapshot when activated again.
  */
-class FileModel : public QAbstractListModel
+class FileModel : public QAbstractListModel, private InotifyWatcher::Listener
 {
     Q_OBJECT
     Q_PROPERTY(QString path READ path WRITE setPath NOTIFY pathChanged)
@@ -71,6 +74,7 @@ class FileModel : public QAbstractListModel
     Q_PROPERTY(int count READ count NOTIFY countChanged)
     Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
     Q_PROPERTY(int selectedCount READ selectedCount NOTIFY selectedCountChanged)
+    Q_PROPERTY(bool calculateDirectorySizes READ calculateDirectorySizes WRITE setCalculateDirectorySizes NOTIFY calculateDirectorySizesChanged)
 
     Q_ENUMS(Error)
     Q_ENUMS(Sort)
@@ -96,6 +100,12 @@ public:
         SortDirectoriesAfterFiles
     };
 
+    // in addition to the roles of StatFileInfo
+    enum Role {
+        DirectorySizeRole = StatFileInfo::UrlRole + 1,
+        ChildCountRole
+    };
+
     explicit FileModel(QObject *parent = 0);
     ~FileModel();
 
@@ -153,6 +163,9 @@ public:
 
     int selectedCount() const { return m_selectedCount; }
 
+    bool calculateDirectorySizes() const { return m_calculateDirectorySizes; }
+    void setCalculateDirectorySizes(bool calculate);
+
     // methods accessible from QML
     Q_INVOKABLE QString appendPath(QString pathName);
     Q_INVOKABLE QString parentPath();
@@ -164,6 +177,12 @@ public:
     Q_INVOKABLE void selectAllFiles();
     Q_INVOKABLE QStringList selectedFiles() const;
 
+    // the number of entries inactive models may keep in memory, beyond which the least
+    // recently used ones are evicted to a compact snapshot until they are activated again;
+    // not exposed to QML, the limit is meant to be tuned by the C++ side, e.g. on memory pressure
+    static int inactiveEntryLimit();
+    static void setInactiveEntryLimit(int limit);
+
     // For synchronizeList
     int insertRange(int index, int count, const QVector<StatFileInfo> &source, int sourceIndex);
     int removeRange(int index, int count);
@@ -191,10 +210,21 @@ signals:
     void activeChanged();
     void selectedCountChanged();
     void errorTypeChanged();
+    void calculateDirectorySizesChanged();
+
+    // typed changes of the entries in the directory, with absolute paths
+    void fileCreated(const QString &fileName);
+    void fileDeleted(const QString &fileName);
+    // the file was closed after writing
+    void fileModified(const QString &fileName);
+    void fileAttributesChanged(const QString &fileName);
+    // the path at the other end is empty if it is outside the watched directories
+    void fileMoved(const QString &from, const QString &to);
 
 private slots:
     void readDirectory();
     void scheduleContentChange();
+    void directorySizeReady(const QString &path);
 
 public:
     enum Changed {
@@ -220,10 +250,22 @@ public:
 private:
     void recountSelectedFiles();
     void readAllEntries();
+    void reconcileEntries(const QDir &dir);
     void refreshEntries();
     void clearModel();
 
+    void evict();
+    void restore();
+    void discardSnapshot();
+    static void trimInactiveModels();
+
+    void watchDirectory();
+    void pollDirectory(const QString &path);
+    void unwatchDirectory();
+    void directoryEvent(const QString &directory, const InotifyWatcher::Event &event) override;
+
     QDir directory() const;
+    QVariant directorySizeData(const StatFileInfo &info, int role) const;
 
     void scheduleUpdate(ChangedFlags flags = ChangedFlags());
     void update();
@@ -247,10 +289,15 @@ private:
     bool m_active;
     bool m_dirty;
     bool m_populated;
+    bool m_evicted;
+    bool m_calculateDirectorySizes;
     int m_selectedCount;
+    int m_listingGeneration;
     QStringList m_nameFilters;
     QVector<StatFileInfo> m_files;
-    QFileSystemWatcher *m_watcher;
+    QByteArray m_snapshot;
+    QString m_watchedPath; // as registered with InotifyWatcher
+    DirectoryPoller *m_poller;
     QBasicTimer m_timer;
     ChangedFlags m_changedFlags;
 };
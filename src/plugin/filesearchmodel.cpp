@@ -0,0 +1,636 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "filesearchmodel.h"
+#include "directoryreader.h"
+
+#include <QFile>
+#include <QMimeDatabase>
+#include <QMutex>
+#include <QQmlInfo>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimerEvent>
+#include <QWaitCondition>
+
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+class FileSearchState
+{
+public:
+    struct Directory {
+        // the parent is kept open until its subdirectories have been opened through it
+        QSharedPointer<DirectoryReader> parent;
+        // relative to the parent, or the full path of the searched directory
+        QByteArray name;
+        QString path;
+        int depth;
+    };
+
+    FileSearchState();
+
+    bool matchName(const QString &name) const;
+    void walk();
+    void cancel();
+
+    // search criteria, these are not modified after the walkers have been started
+    FileSearchModel::PatternSyntax syntax;
+    QString pattern;
+    QRegularExpression expression;
+    Qt::CaseSensitivity caseSensitivity;
+    int maximumDepth;
+    qint64 minimumSize;
+    qint64 maximumSize;
+    qint64 modifiedAfter;
+    qint64 modifiedBefore;
+    bool includeDirectories;
+    bool includeHiddenFiles;
+    bool sameFileSystem;
+    dev_t rootDevice;
+
+    QMutex mutex;
+    QWaitCondition directoryAvailable;
+    QVector<Directory> directories;
+    QVector<StatFileInfo> matches;
+    int busyWalkers;
+    int runningWalkers;
+    QAtomicInt cancelled;
+
+private:
+    bool takeDirectory(Directory *directory);
+    void processDirectory(Directory &directory);
+};
+
+namespace {
+
+const int CollectIntervalMs = 100;
+
+class SearchThreadPool : public QThreadPool
+{
+public:
+    SearchThreadPool() { setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 4)); }
+};
+
+QString wildcardToExpression(const QString &wildcard)
+{
+    QString rv(QLatin1Char('^'));
+    for (int i = 0; i < wildcard.length(); ++i) {
+        const QChar c = wildcard.at(i);
+        if (c == QLatin1Char('*')) {
+            rv += QLatin1String(".*");
+        } else if (c == QLatin1Char('?')) {
+            rv += QLatin1Char('.');
+        } else if (c == QLatin1Char('[')) {
+            const int end = wildcard.indexOf(QLatin1Char(']'), i + 1);
+            if (end < 0) {
+                rv += QLatin1String("\\[");
+                continue;
+            }
+            QString set = wildcard.mid(i + 1, end - i - 1);
+            if (set.startsWith(QLatin1Char('!'))) {
+                set[0] = QLatin1Char('^');
+            }
+            set.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+            rv += QLatin1Char('[');
+            rv += set;
+            rv += QLatin1Char(']');
+            i = end;
+        } else {
+            rv += QRegularExpression::escape(QString(c));
+        }
+    }
+    rv += QLatin1Char('$');
+    return rv;
+}
+
+qint64 toMSecs(const struct timespec &time)
+{
+    return qint64(time.tv_sec) * 1000 + time.tv_nsec / 1000000;
+}
+
+Q_GLOBAL_STATIC(SearchThreadPool, searchThreadPool)
+
+class FileSearchWalker : public QRunnable
+{
+public:
+    explicit FileSearchWalker(const QSharedPointer<FileSearchState> &state) : m_state(state) {}
+
+    void run() override
+    {
+        m_state->walk();
+
+        QMutexLocker locker(&m_state->mutex);
+        --m_state->runningWalkers;
+    }
+
+private:
+    QSharedPointer<FileSearchState> m_state;
+};
+
+}
+
+FileSearchState::FileSearchState()
+    : syntax(FileSearchModel::FixedString)
+    , caseSensitivity(Qt::CaseInsensitive)
+    , maximumDepth(-1)
+    , minimumSize(-1)
+    , maximumSize(-1)
+    , modifiedAfter(std::numeric_limits<qint64>::min())
+    , modifiedBefore(std::numeric_limits<qint64>::max())
+    , includeDirectories(true)
+    , includeHiddenFiles(false)
+    , sameFileSystem(false)
+    , rootDevice(0)
+    , busyWalkers(0)
+    , runningWalkers(0)
+{
+}
+
+bool FileSearchState::matchName(const QString &name) const
+{
+    if (syntax == FileSearchModel::FixedString) {
+        return name.contains(pattern, caseSensitivity);
+    }
+    return expression.match(name).hasMatch();
+}
+
+void FileSearchState::cancel()
+{
+    QMutexLocker locker(&mutex);
+    cancelled.storeRelease(1);
+    directoryAvailable.wakeAll();
+}
+
+void FileSearchState::walk()
+{
+    Directory directory;
+    while (takeDirectory(&directory)) {
+        processDirectory(directory);
+    }
+}
+
+bool FileSearchState::takeDirectory(Directory *directory)
+{
+    QMutexLocker locker(&mutex);
+
+    // Idle walkers wait for busy ones to discover more directories
+    while (directories.isEmpty() && busyWalkers > 0 && cancelled.loadAcquire() == 0) {
+        directoryAvailable.wait(&mutex);
+    }
+
+    if (cancelled.loadAcquire() != 0 || directories.isEmpty()) {
+        // The whole tree has been walked, release the other walkers as well
+        directoryAvailable.wakeAll();
+        return false;
+    }
+
+    // Depth first, so that the number of queued directories stays small
+    *directory = directories.takeLast();
+    ++busyWalkers;
+    return true;
+}
+
+void FileSearchState::processDirectory(Directory &directory)
+{
+    QVector<Directory> subdirectories;
+    QVector<StatFileInfo> found;
+
+    const QString prefix = directory.path.endsWith(QLatin1Char('/'))
+            ? directory.path : directory.path + QLatin1Char('/');
+    const int depth = directory.depth + 1;
+    const bool sizeLimited = minimumSize >= 0 || maximumSize >= 0;
+    QMimeDatabase mimeDatabase;
+
+    QSharedPointer<DirectoryReader> directoryReader(directory.parent
+                                                    ? new DirectoryReader(directory.parent->fd(), directory.name.constData())
+                                                    : new DirectoryReader(directory.path));
+    directory.parent.reset();
+    DirectoryReader &reader = *directoryReader;
+    while (const struct dirent64 *entry = reader.next()) {
+        if (cancelled.loadAcquire() != 0) {
+            break;
+        }
+
+        if (!includeHiddenFiles && entry->d_name[0] == '.') {
+            continue;
+        }
+
+        StatFileInfo::StatData data;
+        StatFileInfo::readStatData(reader.fd(), entry->d_name, &data);
+        const struct stat64 &st = data.lstat;
+        if (st.st_mode == 0) {
+            continue;
+        }
+
+        const QString name = QFile::decodeName(entry->d_name);
+        const bool isDir = S_ISDIR(st.st_mode);
+
+        if (isDir && (maximumDepth < 0 || depth < maximumDepth)
+                && (!sameFileSystem || st.st_dev == rootDevice)) {
+            Directory subdirectory = { directoryReader, QByteArray(entry->d_name), prefix + name, depth };
+            subdirectories.append(subdirectory);
+        }
+
+        if (isDir && !includeDirectories) {
+            continue;
+        }
+        if (sizeLimited && (!S_ISREG(st.st_mode)
+                            || (minimumSize >= 0 && st.st_size < minimumSize)
+                            || (maximumSize >= 0 && st.st_size > maximumSize))) {
+            continue;
+        }
+        const qint64 modified = toMSecs(st.st_mtim);
+        if (modified < modifiedAfter || modified > modifiedBefore) {
+            continue;
+        }
+        if (!matchName(name)) {
+            continue;
+        }
+
+        // by the name, the matches may be anywhere on slow storage and are not opened to sniff them
+        const QString path = prefix + name;
+        const QMimeType mimeType = S_ISDIR(data.stat.st_mode)
+                ? mimeDatabase.mimeTypeForName(QStringLiteral("inode/directory"))
+                : mimeDatabase.mimeTypeForFile(path, QMimeDatabase::MatchExtension);
+        found.append(StatFileInfo(path, data, mimeType));
+    }
+
+    QMutexLocker locker(&mutex);
+
+    directories += subdirectories;
+    matches += found;
+    --busyWalkers;
+
+    if (!subdirectories.isEmpty() || (busyWalkers == 0 && directories.isEmpty())) {
+        directoryAvailable.wakeAll();
+    }
+}
+
+FileSearchModel::FileSearchModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_patternSyntax(FixedString)
+    , m_caseSensitivity(Qt::CaseInsensitive)
+    , m_maximumDepth(-1)
+    , m_minimumSize(-1)
+    , m_maximumSize(-1)
+    , m_includeDirectories(true)
+    , m_includeHiddenFiles(false)
+    , m_sameFileSystem(false)
+    , m_active(false)
+    , m_dirty(false)
+    , m_searching(false)
+{
+}
+
+FileSearchModel::~FileSearchModel()
+{
+    if (m_state) {
+        m_state->cancel();
+    }
+}
+
+int FileSearchModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_files.count();
+}
+
+QVariant FileSearchModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() > m_files.size()-1)
+        return QVariant();
+
+    return m_files.at(index.row()).roleData(role);
+}
+
+QHash<int, QByteArray> FileSearchModel::roleNames() const
+{
+    QHash<int, QByteArray> roles = QAbstractListModel::roleNames();
+    roles.unite(StatFileInfo::roleNames());
+    return roles;
+}
+
+void FileSearchModel::setPath(const QString &path)
+{
+    if (m_path == path)
+        return;
+
+    m_path = path;
+    emit pathChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setPattern(const QString &pattern)
+{
+    if (m_pattern == pattern)
+        return;
+
+    m_pattern = pattern;
+    emit patternChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setPatternSyntax(PatternSyntax syntax)
+{
+    if (m_patternSyntax == syntax)
+        return;
+
+    m_patternSyntax = syntax;
+    emit patternSyntaxChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setCaseSensitivity(Qt::CaseSensitivity sensitivity)
+{
+    if (m_caseSensitivity == sensitivity)
+        return;
+
+    m_caseSensitivity = sensitivity;
+    emit caseSensitivityChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setMaximumDepth(int depth)
+{
+    if (m_maximumDepth == depth)
+        return;
+
+    m_maximumDepth = depth;
+    emit maximumDepthChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setMinimumSize(qint64 size)
+{
+    if (m_minimumSize == size)
+        return;
+
+    m_minimumSize = size;
+    emit minimumSizeChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setMaximumSize(qint64 size)
+{
+    if (m_maximumSize == size)
+        return;
+
+    m_maximumSize = size;
+    emit maximumSizeChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setModifiedAfter(const QDateTime &time)
+{
+    if (m_modifiedAfter == time)
+        return;
+
+    m_modifiedAfter = time;
+    emit modifiedAfterChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setModifiedBefore(const QDateTime &time)
+{
+    if (m_modifiedBefore == time)
+        return;
+
+    m_modifiedBefore = time;
+    emit modifiedBeforeChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setIncludeDirectories(bool include)
+{
+    if (m_includeDirectories == include)
+        return;
+
+    m_includeDirectories = include;
+    emit includeDirectoriesChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setIncludeHiddenFiles(bool include)
+{
+    if (m_includeHiddenFiles == include)
+        return;
+
+    m_includeHiddenFiles = include;
+    emit includeHiddenFilesChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setSameFileSystem(bool same)
+{
+    if (m_sameFileSystem == same)
+        return;
+
+    m_sameFileSystem = same;
+    emit sameFileSystemChanged();
+    scheduleSearch();
+}
+
+void FileSearchModel::setActive(bool active)
+{
+    if (m_active == active)
+        return;
+
+    m_active = active;
+    emit activeChanged();
+
+    if (!m_active && m_startTimer.isActive()) {
+        // Defer the pending restart until reactivated
+        m_startTimer.stop();
+        m_dirty = true;
+    } else if (m_active && m_dirty) {
+        scheduleSearch();
+    }
+}
+
+QString FileSearchModel::fileNameAt(int fileIndex) const
+{
+    if (fileIndex < 0 || fileIndex >= m_files.count())
+        return QString();
+
+    return m_files.at(fileIndex).absoluteFilePath();
+}
+
+void FileSearchModel::refresh()
+{
+    scheduleSearch();
+}
+
+void FileSearchModel::cancel()
+{
+    m_startTimer.stop();
+    m_dirty = false;
+
+    if (m_state) {
+        // Keep whatever has been found already
+        collectMatches();
+        stopSearch();
+    }
+}
+
+void FileSearchModel::scheduleSearch()
+{
+    if (!m_active) {
+        m_dirty = true;
+        return;
+    }
+
+    if (!m_startTimer.isActive()) {
+        m_startTimer.start(0, this);
+    }
+}
+
+void FileSearchModel::startSearch()
+{
+    stopSearch();
+    m_dirty = false;
+
+    if (!m_files.isEmpty()) {
+        beginResetModel();
+        m_files.clear();
+        endResetModel();
+        emit countChanged();
+    }
+
+    if (m_path.isEmpty() || m_pattern.isEmpty())
+        return;
+
+    struct stat64 st;
+    if (stat64(QFile::encodeName(m_path).constData(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        qmlInfo(this) << "Path " << m_path << " is not a directory";
+        return;
+    }
+
+    QSharedPointer<FileSearchState> state(new FileSearchState);
+    state->syntax = m_patternSyntax;
+    state->pattern = m_pattern;
+    state->caseSensitivity = m_caseSensitivity;
+    state->maximumDepth = m_maximumDepth;
+    state->minimumSize = m_minimumSize;
+    state->maximumSize = m_maximumSize;
+    if (m_modifiedAfter.isValid())
+        state->modifiedAfter = m_modifiedAfter.toMSecsSinceEpoch();
+    if (m_modifiedBefore.isValid())
+        state->modifiedBefore = m_modifiedBefore.toMSecsSinceEpoch();
+    state->includeDirectories = m_includeDirectories;
+    state->includeHiddenFiles = m_includeHiddenFiles;
+    state->sameFileSystem = m_sameFileSystem;
+    state->rootDevice = st.st_dev;
+
+    if (m_patternSyntax != FixedString) {
+        const QRegularExpression::PatternOptions options = m_caseSensitivity == Qt::CaseInsensitive
+                ? QRegularExpression::CaseInsensitiveOption
+                : QRegularExpression::NoPatternOption;
+        state->expression = QRegularExpression(m_patternSyntax == Wildcard
+                                               ? wildcardToExpression(m_pattern) : m_pattern,
+                                               options);
+        if (!state->expression.isValid()) {
+            qmlInfo(this) << "Invalid search pattern " << m_pattern << ": " << state->expression.errorString();
+            return;
+        }
+    }
+
+    FileSearchState::Directory root = { QSharedPointer<DirectoryReader>(), QByteArray(), m_path, 0 };
+    state->directories.append(root);
+
+    QThreadPool *pool = searchThreadPool();
+    state->runningWalkers = pool->maxThreadCount();
+    for (int i = 0; i < state->runningWalkers; ++i) {
+        pool->start(new FileSearchWalker(state));
+    }
+
+    m_state = state;
+    m_collectTimer.start(CollectIntervalMs, this);
+    setSearching(true);
+}
+
+void FileSearchModel::stopSearch()
+{
+    if (m_state) {
+        m_state->cancel();
+        m_state.clear();
+    }
+    m_collectTimer.stop();
+    setSearching(false);
+}
+
+void FileSearchModel::collectMatches()
+{
+    QVector<StatFileInfo> matches;
+    bool finished = false;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        matches.swap(m_state->matches);
+        finished = m_state->runningWalkers == 0;
+    }
+
+    if (!matches.isEmpty()) {
+        const int first = m_files.count();
+        beginInsertRows(QModelIndex(), first, first + matches.count() - 1);
+        m_files += matches;
+        endInsertRows();
+        emit countChanged();
+    }
+
+    if (finished) {
+        m_state.clear();
+        m_collectTimer.stop();
+        setSearching(false);
+        emit finished();
+    }
+}
+
+void FileSearchModel::setSearching(bool searching)
+{
+    if (m_searching != searching) {
+        m_searching = searching;
+        emit searchingChanged();
+    }
+}
+
+void FileSearchModel::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_startTimer.timerId()) {
+        m_startTimer.stop();
+        startSearch();
+    } else if (event->timerId() == m_collectTimer.timerId()) {
+        collectMatches();
+    }
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef FILESEARCHMODEL_H
+#define FILESEARCHMODEL_H
+
+#include "statfileinfo.h"
+
+#include <QAbstractListModel>
+#include <QBasicTimer>
+#include <QDateTime>
+#include <QSharedPointer>
+#include <QVector>
+
+class FileSearchState;
+
+/**
+ * @brief The FileSearchModel class searches a directory tree recursively for files whose names
+ * match a pattern. The tree is walked by a pool of background threads and matches are appended
+ * to the model as they are found. The model uses the same roles as FileModel, so that the same
+ * delegates can be used to display both.
+ * The search is (re)started whenever the search criteria change while active is true.
+ */
+class FileSearchModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QString path READ path WRITE setPath NOTIFY pathChanged)
+    Q_PROPERTY(QString pattern READ pattern WRITE setPattern NOTIFY patternChanged)
+    Q_PROPERTY(PatternSyntax patternSyntax READ patternSyntax WRITE setPatternSyntax NOTIFY patternSyntaxChanged)
+    Q_PROPERTY(Qt::CaseSensitivity caseSensitivity READ caseSensitivity WRITE setCaseSensitivity NOTIFY caseSensitivityChanged)
+    Q_PROPERTY(int maximumDepth READ maximumDepth WRITE setMaximumDepth NOTIFY maximumDepthChanged)
+    Q_PROPERTY(qint64 minimumSize READ minimumSize WRITE setMinimumSize NOTIFY minimumSizeChanged)
+    Q_PROPERTY(qint64 maximumSize READ maximumSize WRITE setMaximumSize NOTIFY maximumSizeChanged)
+    Q_PROPERTY(QDateTime modifiedAfter READ modifiedAfter WRITE setModifiedAfter NOTIFY modifiedAfterChanged)
+    Q_PROPERTY(QDateTime modifiedBefore READ modifiedBefore WRITE setModifiedBefore NOTIFY modifiedBeforeChanged)
+    Q_PROPERTY(bool includeDirectories READ includeDirectories WRITE setIncludeDirectories NOTIFY includeDirectoriesChanged)
+    Q_PROPERTY(bool includeHiddenFiles READ includeHiddenFiles WRITE setIncludeHiddenFiles NOTIFY includeHiddenFilesChanged)
+    Q_PROPERTY(bool sameFileSystem READ sameFileSystem WRITE setSameFileSystem NOTIFY sameFileSystemChanged)
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(bool searching READ searching NOTIFY searchingChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum PatternSyntax {
+        FixedString,
+        Wildcard,
+        RegExp
+    };
+    Q_ENUM(PatternSyntax)
+
+    explicit FileSearchModel(QObject *parent = nullptr);
+    ~FileSearchModel();
+
+    // methods needed by ListView
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // property accessors
+    QString path() const { return m_path; }
+    void setPath(const QString &path);
+
+    QString pattern() const { return m_pattern; }
+    void setPattern(const QString &pattern);
+
+    PatternSyntax patternSyntax() const { return m_patternSyntax; }
+    void setPatternSyntax(PatternSyntax syntax);
+
+    Qt::CaseSensitivity caseSensitivity() const { return m_caseSensitivity; }
+    void setCaseSensitivity(Qt::CaseSensitivity sensitivity);
+
+    // number of directory levels searched below path, or -1 for no limit
+    int maximumDepth() const { return m_maximumDepth; }
+    void setMaximumDepth(int depth);
+
+    // size limits in bytes, or -1 for no limit; only regular files match when a limit is set
+    qint64 minimumSize() const { return m_minimumSize; }
+    void setMinimumSize(qint64 size);
+
+    qint64 maximumSize() const { return m_maximumSize; }
+    void setMaximumSize(qint64 size);
+
+    QDateTime modifiedAfter() const { return m_modifiedAfter; }
+    void setModifiedAfter(const QDateTime &time);
+
+    QDateTime modifiedBefore() const { return m_modifiedBefore; }
+    void setModifiedBefore(const QDateTime &time);
+
+    bool includeDirectories() const { return m_includeDirectories; }
+    void setIncludeDirectories(bool include);
+
+    bool includeHiddenFiles() const { return m_includeHiddenFiles; }
+    void setIncludeHiddenFiles(bool include);
+
+    // do not descend into directories on other file systems
+    bool sameFileSystem() const { return m_sameFileSystem; }
+    void setSameFileSystem(bool same);
+
+    bool active() const { return m_active; }
+    void setActive(bool active);
+
+    bool searching() const { return m_searching; }
+    int count() const { return m_files.count(); }
+
+    Q_INVOKABLE QString fileNameAt(int fileIndex) const;
+
+public slots:
+    // restarts the search with the current criteria
+    Q_INVOKABLE void refresh();
+    // stops the search, keeping the matches found so far
+    Q_INVOKABLE void cancel();
+
+signals:
+    void pathChanged();
+    void patternChanged();
+    void patternSyntaxChanged();
+    void caseSensitivityChanged();
+    void maximumDepthChanged();
+    void minimumSizeChanged();
+    void maximumSizeChanged();
+    void modifiedAfterChanged();
+    void modifiedBeforeChanged();
+    void includeDirectoriesChanged();
+    void includeHiddenFilesChanged();
+    void sameFileSystemChanged();
+    void activeChanged();
+    void searchingChanged();
+    void countChanged();
+    void finished();
+
+private:
+    void scheduleSearch();
+    void startSearch();
+    void stopSearch();
+    void collectMatches();
+    void setSearching(bool searching);
+
+    void timerEvent(QTimerEvent *event) override;
+
+    QString m_path;
+    QString m_pattern;
+    PatternSyntax m_patternSyntax;
+    Qt::CaseSensitivity m_caseSensitivity;
+    int m_maximumDepth;
+    qint64 m_minimumSize;
+    qint64 m_maximumSize;
+    QDateTime m_modifiedAfter;
+    QDateTime m_modifiedBefore;
+    bool m_includeDirectories;
+    bool m_includeHiddenFiles;
+    bool m_sameFileSystem;
+    bool m_active;
+    bool m_dirty;
+    bool m_searching;
+    QVector<StatFileInfo> m_files;
+    QSharedPointer<FileSearchState> m_state;
+    QBasicTimer m_startTimer;
+    QBasicTimer m_collectTimer;
+};
+
+#endif // FILESEARCHMODEL_H
@@ -31,25 +31,70 @@
  */
 
 #include "filewatcher.h"
+#include "statcache.h"
+
 #include <QFile>
 #include <QFileInfo>
-#include <QFileSystemWatcher>
 #include <QQmlInfo>
+#include <QTimerEvent>
+
+#include <sys/inotify.h>
+
+namespace {
+
+// how often a watcher whose directory is missing looks for it
+const int RetryInterval = 5000;
+
+}
 
 FileWatcher::FileWatcher(QObject *parent)
     : QObject(parent)
     , m_exists(false)
-    , m_watcher(nullptr)
 {
 }
 
 FileWatcher::~FileWatcher()
 {
+    if (!m_directory.isEmpty())
+        InotifyWatcher::instance()->removeWatch(m_directory, m_name, this);
 }
 
 void FileWatcher::testFileExists()
 {
-    bool exists = m_file.exists();
+    watchFile();
+    // from the disk, the shared cache only learns of the changes as their events are handled
+    setExists(!m_file.fileName().isEmpty() && m_file.exists());
+}
+
+void FileWatcher::watchFile()
+{
+    if (!m_directory.isEmpty() || m_file.fileName().isEmpty()) {
+        m_retryTimer.stop();
+        return;
+    }
+
+    QFileInfo fileInfo(m_file.fileName());
+    if (InotifyWatcher::instance()->addWatch(fileInfo.absolutePath(), fileInfo.fileName(), this,
+                                             InotifyWatcher::ChangeEvents)) {
+        m_directory = fileInfo.absolutePath();
+        m_name = fileInfo.fileName();
+        m_retryTimer.stop();
+    } else if (!m_retryTimer.isActive()) {
+        m_retryTimer.start(RetryInterval, this);
+    }
+}
+
+void FileWatcher::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_retryTimer.timerId()) {
+        testFileExists();
+    } else {
+        QObject::timerEvent(event);
+    }
+}
+
+void FileWatcher::setExists(bool exists)
+{
     if (m_exists != exists) {
         m_exists = exists;
         emit existsChanged();
@@ -69,21 +114,58 @@ QString FileWatcher::fileName() const
 void FileWatcher::setFileName(const QString &fileName)
 {
     if (m_file.fileName() != fileName) {
-        delete m_watcher;
-        m_watcher = nullptr;
-        m_file.setFileName(fileName);
-        if (!fileName.isEmpty()) {
-            QFileInfo fileInfo(fileName);
-            QString absolutePath = fileInfo.absolutePath();
-            m_watcher = new QFileSystemWatcher(this);
-            m_watcher->addPath(absolutePath);
-            connect(m_watcher, SIGNAL(directoryChanged(QString)), this, SLOT(testFileExists()));
+        InotifyWatcher *watcher = InotifyWatcher::instance();
+        if (!m_directory.isEmpty()) {
+            watcher->removeWatch(m_directory, m_name, this);
+            m_directory.clear();
+            m_name.clear();
         }
+        m_file.setFileName(fileName);
         testFileExists();
         emit fileNameChanged();
     }
 }
 
+void FileWatcher::directoryEvent(const QString &directory, const InotifyWatcher::Event &event)
+{
+    if (event.mask & (IN_IGNORED | IN_MOVE_SELF)) {
+        // InotifyWatcher drops the watch once the event is handled, it is added again after that
+        // if there is a directory at the path by then, or once there is one
+        m_directory.clear();
+        m_name.clear();
+        StatCache::instance()->invalidateDirectory(directory);
+        QMetaObject::invokeMethod(this, "testFileExists", Qt::QueuedConnection);
+        return;
+    }
+
+    if (!event.name.isEmpty() && !m_name.isEmpty()) {
+        // the event concerns the watched file itself, the shared cache may not have seen it yet
+        StatCache::instance()->invalidate(m_file.fileName());
+        if (event.mask & IN_CREATE) {
+            setExists(true);
+            emit created();
+        } else if (event.mask & IN_DELETE) {
+            setExists(false);
+            emit deleted();
+        } else if (event.mask & IN_MOVED_TO) {
+            setExists(true);
+            emit moved(event.movedPath, m_file.fileName());
+        } else if (event.mask & IN_MOVED_FROM) {
+            setExists(false);
+            emit moved(m_file.fileName(), event.movedPath);
+        } else if (event.mask & IN_CLOSE_WRITE) {
+            emit modified();
+        } else if (event.mask & IN_ATTRIB) {
+            emit attributesChanged();
+        }
+        return;
+    }
+
+    // the directory itself changed or events were lost
+    StatCache::instance()->invalidateDirectory(directory);
+    testFileExists();
+}
+
 bool FileWatcher::testFileExists(const QString &fileName) const
 {
     return QFile::exists(fileName);
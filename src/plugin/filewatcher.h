@@ -33,13 +33,14 @@
 #ifndef FILEWATCHER_H
 #define FILEWATCHER_H
 
+#include <QBasicTimer>
 #include <QObject>
 #include <QString>
 #include <QFile>
 
-class QFileSystemWatcher;
+#include "inotifywatcher.h"
 
-class FileWatcher : public QObject
+class FileWatcher : public QObject, private InotifyWatcher::Listener
 {
     Q_OBJECT
     Q_PROPERTY(QString fileName READ fileName WRITE setFileName NOTIFY fileNameChanged)
@@ -60,13 +61,33 @@ signals:
     void existsChanged();
     void fileNameChanged();
 
+    // typed changes of the watched file
+    void created();
+    void deleted();
+    // the file was closed after writing
+    void modified();
+    void attributesChanged();
+    // the file was renamed, the path at the other end is empty if it is outside the watched directories
+    void moved(const QString &from, const QString &to);
+
 protected slots:
     void testFileExists();
 
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
 private:
+    void directoryEvent(const QString &directory, const InotifyWatcher::Event &event) override;
+    void setExists(bool exists);
+    void watchFile();
+
     bool m_exists;
     QFile m_file;
-    QFileSystemWatcher *m_watcher;
+    // the watched entry, as registered with InotifyWatcher, empty while it cannot be watched
+    QString m_directory;
+    QString m_name;
+    // tries again to watch the entry while its directory is missing
+    QBasicTimer m_retryTimer;
 };
 
 #endif // FILEWATCHER_H
@@ -31,7 +31,6 @@
  */
 
 #include "fileworker.h"
-#include "fileoperations.h"
 #include "diskusage.h"
 
 #include <QQmlInfo>
@@ -42,13 +41,18 @@ FileWorker::FileWorker(QObject *parent) :
     m_proxy(QString("org.nemomobile.FileOperations"), QString("/"), QDBusConnection::sessionBus()),
     m_operation(0),
     m_mode(FileEngine::IdleMode),
+    m_deletePolicy(FileEngine::DeletePermanently),
     m_cancelled(KeepRunning)
 {
     connect(this, &FileWorker::finished, this, &FileWorker::handleFinished);
 
+    qRegisterMetaType<FileOperations::Progress>();
+    connect(this, &FileWorker::progressReported, this, &FileWorker::setProgress, Qt::QueuedConnection);
+
     connect(&m_proxy, &FileOperationsProxy::Failed, this, &FileWorker::fileOperationFailed);
     connect(&m_proxy, &FileOperationsProxy::Succeeded, this, &FileWorker::fileOperationSucceeded);
     connect(&m_proxy, &FileOperationsProxy::Finished, this, &FileWorker::operationFinished);
+    connect(&m_proxy, &FileOperationsProxy::Progress, this, &FileWorker::operationProgress);
 }
 
 FileWorker::~FileWorker()
@@ -74,7 +78,13 @@ void FileWorker::setMode(FileEngine::Mode mode)
     }
 }
 
-void FileWorker::startDeleteFiles(QStringList fileNames, bool nonprivileged)
+void FileWorker::setProgress(const FileOperations::Progress &progress)
+{
+    m_progress = progress;
+    emit progressChanged();
+}
+
+void FileWorker::startDeleteFiles(QStringList fileNames, bool nonprivileged, FileEngine::DeletePolicy policy)
 {
     if (operationInProgress()) {
         emit error(FileEngine::ErrorOperationInProgress, "");
@@ -87,7 +97,9 @@ void FileWorker::startDeleteFiles(QStringList fileNames, bool nonprivileged)
     }
 
     setMode(FileEngine::DeleteMode);
+    setProgress(FileOperations::Progress());
     m_fileNames = fileNames;
+    m_deletePolicy = policy;
     m_cancelled.storeRelease(KeepRunning);
     startOperation(nonprivileged);
 }
@@ -105,6 +117,7 @@ void FileWorker::startCopyFiles(QStringList fileNames, QString destDirectory, bo
     }
 
     setMode(FileEngine::CopyMode);
+    setProgress(FileOperations::Progress());
 
     m_fileNames = fileNames;
     m_destDirectory = destDirectory;
@@ -125,6 +138,7 @@ void FileWorker::startMoveFiles(QStringList fileNames, QString destDirectory, bo
     }
 
     setMode(FileEngine::MoveMode);
+    setProgress(FileOperations::Progress());
 
     m_fileNames = fileNames;
     m_destDirectory = destDirectory;
@@ -189,6 +203,26 @@ bool FileWorker::setPermissions(QString path, QFileDevice::Permissions p, bool n
     return waitForOperation(reply.value());
 }
 
+bool FileWorker::restoreFiles(QStringList fileNames, bool nonprivileged, QString *failedPath)
+{
+    if (!nonprivileged) {
+        FileOperations::PathResultFunc pathResultFn = [failedPath](const QString &path, bool success) {
+            if (!success && failedPath->isEmpty())
+                *failedPath = path;
+        };
+        return FileOperations::restoreFiles(fileNames, pathResultFn) == FileEngine::NoError;
+    }
+
+    QDBusPendingReply<uint> reply = m_proxy.Restore(fileNames);
+    reply.waitForFinished();
+    if (reply.isError()) {
+        qCWarning(diskUsage) << "Error waiting for file operation reply";
+        return false;
+    }
+
+    return waitForOperation(reply.value());
+}
+
 bool FileWorker::operationInProgress()
 {
     return isRunning() || m_operation != 0;
@@ -207,7 +241,11 @@ void FileWorker::startOperation(bool nonprivileged)
 
     switch (m_mode) {
     case FileEngine::DeleteMode:
-        reply = m_proxy.Delete(m_fileNames);
+        if (m_deletePolicy == FileEngine::DeletePermanently) {
+            reply = m_proxy.Delete(m_fileNames);
+        } else {
+            reply = m_proxy.DeleteWithPolicy(m_fileNames, static_cast<unsigned>(m_deletePolicy));
+        }
         break;
 
     case FileEngine::MoveMode:
@@ -283,6 +321,24 @@ void FileWorker::operationFinished(unsigned id)
     }
 }
 
+void FileWorker::operationProgress(unsigned id, qlonglong bytesDone, qlonglong bytesTotal,
+                                   unsigned filesDone, unsigned filesTotal,
+                                   const QString &currentPath, qlonglong bytesPerSecond,
+                                   qlonglong secondsRemaining)
+{
+    if (id == m_operation) {
+        FileOperations::Progress progress;
+        progress.bytesDone = bytesDone;
+        progress.bytesTotal = bytesTotal;
+        progress.filesDone = filesDone;
+        progress.filesTotal = filesTotal;
+        progress.currentPath = currentPath;
+        progress.bytesPerSecond = bytesPerSecond;
+        progress.secondsRemaining = secondsRemaining;
+        setProgress(progress);
+    }
+}
+
 void FileWorker::run()
 {
     FileOperations::ContinueFunc continueFn = [this]() { return m_cancelled.loadAcquire() == KeepRunning; };
@@ -296,19 +352,23 @@ void FileWorker::run()
         }
     };
 
+    FileOperations::ProgressFunc progressFn = [this](const FileOperations::Progress &progress) {
+        emit progressReported(progress);
+    };
+
     FileEngine::Error result = FileEngine::NoError;
 
     switch (m_mode) {
     case FileEngine::DeleteMode:
-        result = FileOperations::deleteFiles(m_fileNames, pathResultFn, continueFn);
+        result = FileOperations::deleteFiles(m_fileNames, pathResultFn, continueFn, progressFn, m_deletePolicy);
         break;
 
     case FileEngine::MoveMode:
-        result = FileOperations::moveFiles(m_fileNames, m_destDirectory, pathResultFn, continueFn);
+        result = FileOperations::moveFiles(m_fileNames, m_destDirectory, pathResultFn, continueFn, progressFn);
         break;
 
     case FileEngine::CopyMode:
-        result = FileOperations::copyFiles(m_fileNames, m_destDirectory, pathResultFn, continueFn);
+        result = FileOperations::copyFiles(m_fileNames, m_destDirectory, pathResultFn, continueFn, progressFn);
         break;
 
     case FileEngine::IdleMode:
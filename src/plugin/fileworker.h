@@ -34,6 +34,7 @@
 #define FILEWORKER_H
 
 #include "fileengine.h"
+#include "fileoperations.h"
 #include "fileoperationsproxy.h"
 
 #include <QThread>
@@ -51,7 +52,8 @@ public:
     ~FileWorker();
 
     // call these to start the thread, returns false if start failed
-    void startDeleteFiles(QStringList fileNames, bool nonprivileged);
+    void startDeleteFiles(QStringList fileNames, bool nonprivileged,
+                          FileEngine::DeletePolicy policy = FileEngine::DeletePermanently);
     void startCopyFiles(QStringList fileNames, QString destDirectory, bool nonprivileged);
     void startMoveFiles(QStringList fileNames, QString destDirectory, bool nonprivileged);
 
@@ -61,8 +63,11 @@ public:
     bool mkdir(QString path, QString name, bool nonprivileged);
     bool rename(QString oldPath, QString newPath, bool nonprivileged);
     bool setPermissions(QString path, QFileDevice::Permissions p, bool nonprivileged);
+    // the path that couldn't be restored is returned in failedPath, if known
+    bool restoreFiles(QStringList fileNames, bool nonprivileged, QString *failedPath);
 
     FileEngine::Mode mode() const;
+    FileOperations::Progress progress() const { return m_progress; }
 
 signals:
 
@@ -72,6 +77,10 @@ signals:
     void error(FileEngine::Error error, QString fileName);
     void fileDeleted(QString fullname);
     void modeChanged();
+    void progressChanged();
+
+    // from the worker thread
+    void progressReported(const FileOperations::Progress &progress);
 
 protected slots:
     void handleFinished();
@@ -79,6 +88,10 @@ protected slots:
     void fileOperationFailed(unsigned id, const QStringList &paths, unsigned errorCode);
     void fileOperationSucceeded(unsigned id, const QStringList &paths);
     void operationFinished(unsigned id);
+    void operationProgress(unsigned id, qlonglong bytesDone, qlonglong bytesTotal,
+                           unsigned filesDone, unsigned filesTotal,
+                           const QString &currentPath, qlonglong bytesPerSecond,
+                           qlonglong secondsRemaining);
 
 protected:
     void run();
@@ -97,10 +110,13 @@ private:
     bool validateFileNames(const QStringList &fileNames);
 
     void setMode(FileEngine::Mode mode);
+    void setProgress(const FileOperations::Progress &progress);
 
     FileOperationsProxy m_proxy;
     unsigned m_operation;
     FileEngine::Mode m_mode;
+    FileEngine::DeletePolicy m_deletePolicy;
+    FileOperations::Progress m_progress;
     QStringList m_fileNames;
     QString m_destDirectory;
     QAtomicInt m_cancelled; // atomic so no locks needed
@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "inotifywatcher.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QVector>
+#include <QtDebug>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+Q_LOGGING_CATEGORY(lcWatcherLog, "org.sailfishos.filemanager.watcher", QtWarningMsg)
+
+namespace {
+
+// always watched, so that the watches can be dropped when the directories go away
+const quint32 baseMask = IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+// delivered to every listener
+const quint32 directoryEvents = IN_Q_OVERFLOW | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT;
+
+struct PendingEvent
+{
+    int wd;
+    quint32 cookie;
+    InotifyWatcher::Event event;
+};
+
+// identifies the events that are repeats of each other, moves are unique by their cookies
+struct EventKey
+{
+    int wd;
+    quint32 mask;
+    quint32 cookie;
+    QString name;
+
+    bool operator==(const EventKey &other) const
+    {
+        return wd == other.wd && mask == other.mask && cookie == other.cookie && name == other.name;
+    }
+};
+
+uint qHash(const EventKey &key, uint seed = 0)
+{
+    return qHash(key.name, seed) ^ uint(key.wd) ^ (key.mask << 8) ^ key.cookie;
+}
+
+}
+
+InotifyWatcher::InotifyWatcher(QObject *parent)
+    : QObject(parent)
+    , m_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    , m_notifier(nullptr)
+    , m_suspended(false)
+    , m_wakeupCount(0)
+    , m_eventCount(0)
+    , m_periodWakeups(0)
+    , m_periodEvents(0)
+{
+    m_period.start();
+
+    if (m_fd < 0) {
+        qWarning() << "Cannot initialize inotify:" << strerror(errno);
+        return;
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, SIGNAL(activated(int)), this, SLOT(readEvents()));
+}
+
+InotifyWatcher::~InotifyWatcher()
+{
+    qDeleteAll(m_watches);
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+InotifyWatcher *InotifyWatcher::instance()
+{
+    static InotifyWatcher *instance = new InotifyWatcher(QCoreApplication::instance());
+    return instance;
+}
+
+QString InotifyWatcher::filePath(const QString &directory, const QString &name)
+{
+    return directory.endsWith(QLatin1Char('/'))
+            ? directory + name
+            : directory + QLatin1Char('/') + name;
+}
+
+void InotifyWatcher::setSuspended(bool suspended)
+{
+    if (m_suspended == suspended)
+        return;
+
+    reportWakeups();
+    m_suspended = suspended;
+    if (m_notifier)
+        m_notifier->setEnabled(!m_suspended);
+    if (!m_suspended)
+        readEvents(); // whatever was queued meanwhile
+
+    emit suspendedChanged();
+}
+
+void InotifyWatcher::reportWakeups()
+{
+    const qint64 elapsed = m_period.restart();
+    const int wakeups = m_wakeupCount - m_periodWakeups;
+    const int events = m_eventCount - m_periodEvents;
+    m_periodWakeups = m_wakeupCount;
+    m_periodEvents = m_eventCount;
+
+    qCDebug(lcWatcherLog) << (m_suspended ? "Suspended:" : "Active:")
+                          << wakeups << "wakeups and" << events << "events in" << elapsed / 1000 << "s,"
+                          << (elapsed > 0 ? wakeups * 60000.0 / elapsed : 0.0) << "wakeups per minute";
+}
+
+bool InotifyWatcher::addWatch(const QString &directory, const QString &name, Listener *listener, quint32 events,
+                              int *error)
+{
+    if (m_fd < 0 || directory.isEmpty()) {
+        if (error)
+            *error = m_fd < 0 ? EBADF : ENOENT;
+        return false;
+    }
+
+    Directory *dir = m_directories.value(directory);
+    if (!dir) {
+        const quint32 mask = baseMask | events;
+        const int wd = inotify_add_watch(m_fd, QFile::encodeName(directory).constData(), mask);
+        if (wd < 0) {
+            // before anything else can change errno
+            if (error)
+                *error = errno;
+            return false;
+        }
+
+        // inotify returns the existing descriptor if the directory is already watched through another path
+        dir = m_watches.value(wd);
+        if (!dir) {
+            dir = new Directory;
+            dir->wd = wd;
+            dir->mask = mask;
+            m_watches.insert(wd, dir);
+        } else {
+            // the mask given replaced the one of the existing watch, restored below
+            dir->mask = mask;
+        }
+        m_directories.insert(directory, dir);
+    }
+
+    ListenerHash &listeners = dir->listeners[directory];
+    if (!listeners.contains(name, listener)) {
+        listeners.insert(name, listener);
+
+        Subscription &subscription = dir->subscriptions[listener];
+        ++subscription.references;
+        subscription.events |= events;
+    }
+
+    updateMask(dir, directory);
+    if (error)
+        *error = 0;
+    return true;
+}
+
+void InotifyWatcher::removeWatch(const QString &directory, const QString &name, Listener *listener)
+{
+    Directory *dir = m_directories.value(directory);
+    if (!dir)
+        return;
+
+    QHash<QString, ListenerHash>::iterator it = dir->listeners.find(directory);
+    if (it->remove(name, listener) > 0) {
+        QHash<Listener *, Subscription>::iterator subscription = dir->subscriptions.find(listener);
+        if (--subscription->references == 0)
+            dir->subscriptions.erase(subscription);
+    }
+
+    if (it->isEmpty()) {
+        dir->listeners.erase(it);
+        m_directories.remove(directory);
+    }
+
+    if (dir->listeners.isEmpty()) {
+        removeDirectory(dir, true);
+    } else {
+        // stop the events nobody is interested in any more
+        updateMask(dir, dir->listeners.constBegin().key());
+    }
+}
+
+void InotifyWatcher::updateMask(Directory *directory, const QString &path)
+{
+    quint32 mask = baseMask;
+    for (QHash<Listener *, Subscription>::const_iterator it = directory->subscriptions.constBegin();
+            it != directory->subscriptions.constEnd(); ++it) {
+        mask |= it->events;
+    }
+
+    if (mask != directory->mask) {
+        directory->mask = mask;
+        inotify_add_watch(m_fd, QFile::encodeName(path).constData(), mask);
+    }
+}
+
+void InotifyWatcher::removeDirectory(Directory *directory, bool removeWatch)
+{
+    if (removeWatch)
+        inotify_rm_watch(m_fd, directory->wd);
+
+    m_watches.remove(directory->wd);
+    foreach (const QString &path, directory->listeners.keys())
+        m_directories.remove(path);
+    delete directory;
+}
+
+void InotifyWatcher::readEvents()
+{
+    alignas(struct inotify_event) char buffer[4096];
+    QVector<PendingEvent> events;
+
+    if (m_suspended)
+        return;
+    ++m_wakeupCount;
+
+    for (;;) {
+        const ssize_t length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (const char *ptr = buffer; ptr < buffer + length; ) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            PendingEvent pending;
+            pending.wd = event->wd;
+            pending.cookie = event->cookie;
+            pending.event.mask = event->mask;
+            if (event->len > 0)
+                pending.event.name = QFile::decodeName(event->name);
+            events.append(pending);
+        }
+    }
+    m_eventCount += events.count();
+
+    // keep the last of the repeated events, e.g. when a file was written several times while
+    // suspended, so that the order of the events that matter is preserved
+    QSet<EventKey> seen;
+    int kept = events.count();
+    for (int i = events.count() - 1; i >= 0; --i) {
+        const PendingEvent &pending = events.at(i);
+        const EventKey key = { pending.wd, pending.event.mask, pending.cookie, pending.event.name };
+        if (!seen.contains(key)) {
+            seen.insert(key);
+            events[--kept] = pending;
+        }
+    }
+    events.remove(0, kept);
+
+    // pair the two halves of the moves, they share a cookie and are queued next to each other
+    QHash<quint32, int> movedFrom;
+    for (int i = 0; i < events.count(); ++i) {
+        PendingEvent &pending = events[i];
+        if (pending.event.mask & IN_MOVED_FROM) {
+            movedFrom.insert(pending.cookie, i);
+        } else if (pending.event.mask & IN_MOVED_TO) {
+            const QHash<quint32, int>::iterator from = movedFrom.find(pending.cookie);
+            if (from == movedFrom.end())
+                continue;
+
+            PendingEvent &source = events[from.value()];
+            movedFrom.erase(from);
+            const Directory *sourceDir = m_watches.value(source.wd);
+            const Directory *targetDir = m_watches.value(pending.wd);
+            if (sourceDir && targetDir) {
+                source.event.movedPath = filePath(targetDir->listeners.constBegin().key(), pending.event.name);
+                pending.event.movedPath = filePath(sourceDir->listeners.constBegin().key(), source.event.name);
+            }
+        }
+    }
+
+    foreach (const PendingEvent &pending, events) {
+        if (pending.event.mask & IN_Q_OVERFLOW) {
+            // events were lost, every listener has to check its state again
+            foreach (int wd, m_watches.keys())
+                dispatch(wd, pending.event);
+        } else {
+            dispatch(pending.wd, pending.event);
+        }
+    }
+}
+
+void InotifyWatcher::dispatch(int wd, const Event &event)
+{
+    Directory *dir = m_watches.value(wd);
+    if (!dir)
+        return;
+
+    struct Target
+    {
+        QString path;
+        QString name;
+        Listener *listener;
+    };
+
+    const bool everyone = event.mask & directoryEvents;
+
+    QList<Target> targets;
+    for (QHash<QString, ListenerHash>::const_iterator it = dir->listeners.constBegin();
+            it != dir->listeners.constEnd(); ++it) {
+        if (event.name.isEmpty()) {
+            for (ListenerHash::const_iterator listener = it->constBegin(); listener != it->constEnd(); ++listener) {
+                const Target target = { it.key(), listener.key(), listener.value() };
+                targets.append(target);
+            }
+        } else {
+            foreach (Listener *listener, it->values(event.name)) {
+                const Target target = { it.key(), event.name, listener };
+                targets.append(target);
+            }
+            foreach (Listener *listener, it->values(QString())) {
+                const Target target = { it.key(), QString(), listener };
+                targets.append(target);
+            }
+        }
+    }
+
+    foreach (const Target &target, targets) {
+        // the listeners may add and remove watches while handling the event
+        dir = m_watches.value(wd);
+        if (!dir)
+            return;
+        if (!dir->listeners.value(target.path).contains(target.name, target.listener))
+            continue;
+        if (everyone || (dir->subscriptions.value(target.listener).events & event.mask))
+            target.listener->directoryEvent(target.path, event);
+    }
+
+    dir = m_watches.value(wd);
+    if (!dir)
+        return;
+
+    if (event.mask & IN_IGNORED) {
+        // the directory was removed or its file system unmounted
+        removeDirectory(dir, false);
+    } else if (event.mask & IN_MOVE_SELF) {
+        // the watch would follow the directory to a path nobody asked for
+        removeDirectory(dir, true);
+    }
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef INOTIFYWATCHER_H
+#define INOTIFYWATCHER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMultiHash>
+#include <QObject>
+#include <QString>
+
+#include <sys/inotify.h>
+
+class QSocketNotifier;
+
+/**
+ * @brief The InotifyWatcher class shares one inotify instance between all the watchers of the plugin.
+ * A directory is watched once however many listeners are interested in it, and the events are
+ * dispatched by the name of the changed entry, so that a listener is only told about the file it
+ * watches. Listeners watching an empty name receive all the events of the directory.
+ *
+ * While suspended, e.g. when the application is in the background, the process is not woken up
+ * for the changes. The kernel queues the events and they are delivered on resume, with repeated
+ * events coalesced. If the queue overflows meanwhile, the listeners check their state again as
+ * they do for any overflow.
+ */
+class InotifyWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Events {
+        // enough to tell whether the watched files exist
+        ExistenceEvents = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO,
+        // files are reported modified when they are closed after writing, rather than on every write
+        ChangeEvents = ExistenceEvents | IN_CLOSE_WRITE | IN_ATTRIB
+    };
+
+    struct Event
+    {
+        quint32 mask; // the inotify event bits
+        QString name; // empty for the events that concern the directory as a whole
+        // for a move between watched directories, the path at the other end of the move
+        QString movedPath;
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+
+        // Events that concern the directory as a whole, e.g. when it is removed or when the event
+        // queue has overflowed, are delivered to all listeners regardless of the events they asked for.
+        virtual void directoryEvent(const QString &directory, const Event &event) = 0;
+    };
+
+    static InotifyWatcher *instance();
+
+    bool isValid() const { return m_fd >= 0; }
+
+    // returns false if the directory cannot be watched, with the reason in error if given,
+    // e.g. ENOSPC when out of watches
+    bool addWatch(const QString &directory, const QString &name, Listener *listener,
+                  quint32 events = ExistenceEvents, int *error = nullptr);
+    void removeWatch(const QString &directory, const QString &name, Listener *listener);
+
+    // the number of inotify watches in use
+    int watchCount() const { return m_watches.count(); }
+
+    bool isSuspended() const { return m_suspended; }
+    void setSuspended(bool suspended);
+
+    // the number of times the process was woken up for changes, by inotify or by the pollers,
+    // and the number of events read
+    int wakeupCount() const { return m_wakeupCount; }
+    int eventCount() const { return m_eventCount; }
+    void recordWakeup() { ++m_wakeupCount; }
+
+    static QString filePath(const QString &directory, const QString &name);
+
+signals:
+    void suspendedChanged();
+
+private slots:
+    void readEvents();
+
+private:
+    explicit InotifyWatcher(QObject *parent = 0);
+    ~InotifyWatcher();
+
+    typedef QMultiHash<QString, Listener *> ListenerHash; // by name
+
+    struct Subscription
+    {
+        int references;
+        quint32 events;
+    };
+
+    struct Directory
+    {
+        int wd;
+        quint32 mask; // the events asked from the kernel
+        // by the path the listeners used, the same directory may be watched through several paths
+        QHash<QString, ListenerHash> listeners;
+        QHash<Listener *, Subscription> subscriptions;
+    };
+
+    void updateMask(Directory *directory, const QString &path);
+    void dispatch(int wd, const Event &event);
+    void removeDirectory(Directory *directory, bool removeWatch);
+
+    void reportWakeups();
+
+    int m_fd;
+    QSocketNotifier *m_notifier;
+    bool m_suspended;
+    int m_wakeupCount;
+    int m_eventCount;
+    // since the last change of the suspended state, with the counts at that point
+    QElapsedTimer m_period;
+    int m_periodWakeups;
+    int m_periodEvents;
+    QHash<int, Directory *> m_watches; // by watch descriptor
+    QHash<QString, Directory *> m_directories; // by path
+};
+
+#endif // INOTIFYWATCHER_H
@@ -38,7 +38,10 @@
 
 #include "archivemodel.h"
 #include "fileengine.h"
+#include "fileinfobatch.h"
+#include "filelistwatcher.h"
 #include "filemodel.h"
+#include "filesearchmodel.h"
 #include "filewatcher.h"
 #include "diskusage.h"
 
@@ -64,7 +67,10 @@ public:
     {
         Q_ASSERT(uri == QLatin1String("Nemo.FileManager"));
         qmlRegisterType<FileInfo>(uri, 1, 0, "FileInfo");
+        qmlRegisterType<FileInfoBatch>(uri, 1, 0, "FileInfoBatch");
+        qmlRegisterType<FileListWatcher>(uri, 1, 0, "FileListWatcher");
         qmlRegisterType<FileModel>(uri, 1, 0, "FileModel");
+        qmlRegisterType<FileSearchModel>(uri, 1, 0, "FileSearchModel");
         qmlRegisterType<Sailfish::ArchiveModel>(uri, 1, 0, "ArchiveModel");
         qmlRegisterType<FileWatcher>(uri, 1, 0, "FileWatcher");
         qmlRegisterType<DiskUsage>(uri, 1, 0, "DiskUsage");
@@ -19,6 +19,11 @@ QMAKE_CXXFLAGS += -Wparentheses -Werror -Wfatal-errors
 
 PKGCONFIG += KF5Archive
 
+packagesExist(liburing) {
+    DEFINES += HAS_LIBURING
+    PKGCONFIG += liburing
+}
+
 # Drop any library linkage we dont actually need
 QMAKE_LFLAGS *= -Wl,--as-needed
 
@@ -36,25 +41,57 @@ system(qdbusxml2cpp -c FileOperationsProxy -p fileoperationsproxy.h:fileoperatio
 
 SOURCES += archiveinfo.cpp \
     archivemodel.cpp \
+    copypipeline.cpp \
+    directoryindex.cpp \
+    directorypoller.cpp \
+    directoryreader.cpp \
+    directorysize.cpp \
     fileengine.cpp \
+    fileinfobatch.cpp \
+    fileinforesolver.cpp \
+    filelistwatcher.cpp \
     filemodel.cpp \
     fileoperations.cpp \
     fileoperationsproxy.cpp \
+    filesearchmodel.cpp \
     filewatcher.cpp \
     fileworker.cpp \
+    inotifywatcher.cpp \
     plugin.cpp \
-    statfileinfo.cpp
+    statcache.cpp \
+    statfileinfo.cpp \
+    trash.cpp \
+    treeremover.cpp \
+    treescanner.cpp \
+    treewatcher.cpp \
+    uringengine.cpp
 
 HEADERS += archiveinfo.h \
     archivemodel_p.h \
     archivemodel.h \
+    copypipeline.h \
+    directoryindex.h \
+    directorypoller.h \
+    directoryreader.h \
+    directorysize.h \
     fileengine.h \
+    fileinfobatch.h \
+    fileinforesolver.h \
+    filelistwatcher.h \
     filemodel.h \
     fileoperations.h \
     fileoperationsproxy.h \
+    filesearchmodel.h \
     filewatcher.h \
     fileworker.h \
+    inotifywatcher.h \
+    statcache.h \
     statfileinfo.h \
+    trash.h \
+    treeremover.h \
+    treescanner.h \
+    treewatcher.h \
+    uringengine.h \
     filemanagerglobal.h
 
 INCLUDEPATH += $$PWD ../shared
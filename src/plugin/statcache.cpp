@@ -0,0 +1,447 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "statcache.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <fcntl.h>
+#include <sys/inotify.h>
+
+namespace {
+
+// beyond this, the least recently used directories are no longer watched
+const int MaximumWatchedDirectories = 128;
+
+// relative paths are cached by their absolute path, to match the paths reported by the watcher
+QString cacheKey(const QString &path)
+{
+    if (path.startsWith(QLatin1Char('/')))
+        return path;
+    return QDir::cleanPath(QDir::current().absoluteFilePath(path));
+}
+
+// of an absolute path
+void splitPath(const QString &path, QString *directory, QString *name)
+{
+    const int index = path.lastIndexOf(QLatin1Char('/'));
+    *directory = index > 0 ? path.left(index) : QStringLiteral("/");
+    *name = path.mid(index + 1);
+}
+
+StatFileInfo readFileInfo(const QString &path)
+{
+    StatFileInfo::StatData data;
+    StatFileInfo::readStatData(AT_FDCWD, QFile::encodeName(path).constData(), &data);
+    return StatFileInfo(path, data, QMimeType());
+}
+
+}
+
+StatCache::StatCache()
+    : QObject()
+    , m_entryCount(0)
+    , m_capacity(4096)
+    , m_clock(0)
+    , m_generation(0)
+    , m_hits(0)
+    , m_misses(0)
+    , m_connected(false)
+{
+}
+
+StatCache *StatCache::instance()
+{
+    // may be first used on a worker thread, the watches are handled on the main thread
+    static StatCache *instance = []() {
+        StatCache *cache = new StatCache;
+        if (QCoreApplication::instance())
+            cache->moveToThread(QCoreApplication::instance()->thread());
+        return cache;
+    }();
+    return instance;
+}
+
+StatFileInfo StatCache::fileInfo(const QString &path, bool detectMimeType)
+{
+    StatFileInfo info;
+    if (lookup(path, detectMimeType, &info))
+        return info;
+
+    // watched before reading, so that no change after the read goes unnoticed
+    QString directory;
+    QString name;
+    splitPath(cacheKey(path), &directory, &name);
+    quint64 generation = 0;
+    const bool watched = watch(directory, &generation);
+
+    if (detectMimeType) {
+        info = StatFileInfo(path);
+    } else {
+        info = readFileInfo(path);
+    }
+    if (watched)
+        insert(info, generation, detectMimeType);
+    return info;
+}
+
+bool StatCache::lookup(const QString &path, bool detectMimeType, StatFileInfo *info)
+{
+    QString directory;
+    QString name;
+    splitPath(cacheKey(path), &directory, &name);
+
+    StatFileInfo::StatData data;
+    QMimeType mimeType;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // the changes made meanwhile are only known once the watchers are resumed
+        QHash<QString, Directory>::iterator dir = m_directories.find(directory);
+        const Entry *entry = nullptr;
+        if (dir != m_directories.end() && !m_suspended.load()) {
+            QHash<QString, Entry>::const_iterator it = dir->entries.constFind(name);
+            if (it != dir->entries.constEnd())
+                entry = &it.value();
+        }
+        if (!entry || (detectMimeType && entry->mimeType < 0)) {
+            ++m_misses;
+            return false;
+        }
+        ++m_hits;
+        dir->lastUsed = ++m_clock;
+
+        data = entry->data;
+        if (entry->mimeType >= 0)
+            mimeType = m_mimeTypes.at(entry->mimeType);
+    }
+
+    *info = StatFileInfo(path, data, mimeType);
+    return true;
+}
+
+void StatCache::insert(const StatFileInfo &info, quint64 generation, bool hasMimeType)
+{
+    if (info.file().isEmpty())
+        return;
+
+    QString directory;
+    QString name;
+    splitPath(cacheKey(info.file()), &directory, &name);
+    if (name.isEmpty())
+        return;
+
+    Entry entry;
+    entry.data.lstat = info.lstatData();
+    entry.data.stat = info.statData();
+    entry.data.birthTime = info.birthTimeNs();
+    entry.data.fields = info.statFields();
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // the changes since the read may have gone unnoticed otherwise, and a change noticed
+        // between the read and now may have been handled before there was anything to drop
+        QHash<QString, Directory>::iterator dir = m_directories.find(directory);
+        if (dir == m_directories.end() || dir->generation != generation)
+            return;
+
+        // a directory larger than the whole cache is only cached in part
+        QHash<QString, Entry>::iterator it = dir->entries.find(name);
+        if (it == dir->entries.end() && dir->entries.count() >= m_capacity)
+            return;
+
+        entry.mimeType = hasMimeType ? mimeTypeId(info.mimeTypeInfo()) : -1;
+        if (it == dir->entries.end()) {
+            dir->entries.insert(name, entry);
+            ++m_entryCount;
+        } else {
+            it.value() = entry;
+        }
+        dir->lastUsed = ++m_clock;
+
+        trim(directory);
+    }
+
+    unwatchDropped();
+}
+
+bool StatCache::watch(const QString &directory, quint64 *generation)
+{
+    const QString path = cacheKey(directory);
+
+    if (isMainThread()) {
+        bool watched;
+        {
+            QMutexLocker locker(&m_mutex);
+            watched = addDirectory(path);
+            if (watched && generation)
+                *generation = m_directories.value(path).generation;
+        }
+        unwatchDropped();
+        return watched;
+    }
+
+    // InotifyWatcher belongs to the main thread
+    QMutexLocker locker(&m_mutex);
+    QHash<QString, Directory>::iterator it = m_directories.find(path);
+    if (it != m_directories.end()) {
+        it->lastUsed = ++m_clock;
+        if (generation)
+            *generation = it->generation;
+        return true;
+    }
+    if (!m_pendingDirectories.contains(path)) {
+        if (m_pendingDirectories.isEmpty())
+            QMetaObject::invokeMethod(this, "watchPending", Qt::QueuedConnection);
+        m_pendingDirectories.insert(path);
+    }
+    return false;
+}
+
+void StatCache::invalidate(const QString &path)
+{
+    QString directory;
+    QString name;
+    splitPath(cacheKey(path), &directory, &name);
+
+    QMutexLocker locker(&m_mutex);
+    removeEntry(directory, name);
+}
+
+void StatCache::invalidateDirectory(const QString &path)
+{
+    const QString key = cacheKey(path);
+    QString parent;
+    QString name;
+    splitPath(key, &parent, &name);
+
+    QMutexLocker locker(&m_mutex);
+
+    removeEntry(parent, name);
+    QHash<QString, Directory>::iterator it = m_directories.find(key);
+    if (it != m_directories.end()) {
+        m_entryCount -= it->entries.count();
+        it->entries.clear();
+        it->generation = ++m_generation;
+    }
+}
+
+void StatCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    for (QHash<QString, Directory>::iterator it = m_directories.begin(); it != m_directories.end(); ++it)
+        it->entries.clear();
+    m_entryCount = 0;
+}
+
+int StatCache::capacity() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_capacity;
+}
+
+void StatCache::setCapacity(int capacity)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_capacity = capacity;
+        trim(QString());
+    }
+    unwatchDropped();
+}
+
+int StatCache::watchCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_directories.count();
+}
+
+quint64 StatCache::hits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hits;
+}
+
+quint64 StatCache::misses() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_misses;
+}
+
+void StatCache::watchPending()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        foreach (const QString &directory, m_pendingDirectories)
+            addDirectory(directory);
+        m_pendingDirectories.clear();
+    }
+    unwatchDropped();
+}
+
+void StatCache::suspendedChanged()
+{
+    // the events queued while suspended have been handled by now
+    m_suspended.store(InotifyWatcher::instance()->isSuspended());
+}
+
+void StatCache::directoryEvent(const QString &directory, const InotifyWatcher::Event &event)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QHash<QString, Directory>::iterator it = m_directories.find(directory);
+    if (it == m_directories.end()) {
+        // a dropped directory that no longer needs unwatching
+        if (event.mask & (IN_IGNORED | IN_MOVE_SELF))
+            m_droppedDirectories.removeAll(directory);
+        return;
+    }
+
+    it->generation = ++m_generation;
+
+    // the directory changes along with its entries, its own information is kept by its parent
+    QString parent;
+    QString name;
+    splitPath(directory, &parent, &name);
+    removeEntry(parent, name);
+
+    if (event.mask & (IN_IGNORED | IN_MOVE_SELF)) {
+        // InotifyWatcher has dropped the watch
+        m_entryCount -= it->entries.count();
+        m_directories.erase(it);
+    } else if (event.name.isEmpty()) {
+        // events were lost, or the directory itself changed
+        m_entryCount -= it->entries.count();
+        it->entries.clear();
+    } else {
+        removeEntry(directory, event.name);
+    }
+}
+
+bool StatCache::addDirectory(const QString &directory)
+{
+    QHash<QString, Directory>::iterator it = m_directories.find(directory);
+    if (it != m_directories.end()) {
+        it->lastUsed = ++m_clock;
+        return true;
+    }
+
+    InotifyWatcher *watcher = InotifyWatcher::instance();
+    if (!m_connected) {
+        m_connected = true;
+        connect(watcher, &InotifyWatcher::suspendedChanged, this, &StatCache::suspendedChanged);
+        m_suspended.store(watcher->isSuspended());
+    }
+
+    // still registered if it was dropped since the last time the dropped ones were unwatched
+    if (m_droppedDirectories.removeAll(directory) == 0
+            && !watcher->addWatch(directory, QString(), this, InotifyWatcher::ChangeEvents)) {
+        return false;
+    }
+
+    Directory &added = m_directories[directory];
+    added.lastUsed = ++m_clock;
+    // nothing read under the generation of an earlier watch of the directory is cached
+    added.generation = ++m_generation;
+    trim(directory);
+    return true;
+}
+
+void StatCache::removeEntry(const QString &directory, const QString &name)
+{
+    QHash<QString, Directory>::iterator it = m_directories.find(directory);
+    if (it != m_directories.end()) {
+        m_entryCount -= it->entries.remove(name);
+        it->generation = ++m_generation;
+    }
+}
+
+void StatCache::trim(const QString &except)
+{
+    while (m_directories.count() > MaximumWatchedDirectories || m_entryCount > m_capacity) {
+        QHash<QString, Directory>::iterator oldest = m_directories.end();
+        for (QHash<QString, Directory>::iterator it = m_directories.begin(); it != m_directories.end(); ++it) {
+            if (it.key() != except && (oldest == m_directories.end() || it->lastUsed < oldest->lastUsed))
+                oldest = it;
+        }
+        if (oldest == m_directories.end())
+            break;
+        dropDirectory(oldest);
+    }
+}
+
+void StatCache::dropDirectory(QHash<QString, Directory>::iterator it)
+{
+    // unwatched by the main thread once the lock is released
+    if (m_droppedDirectories.isEmpty() && !isMainThread())
+        QMetaObject::invokeMethod(this, "watchPending", Qt::QueuedConnection);
+    m_droppedDirectories.append(it.key());
+
+    m_entryCount -= it->entries.count();
+    m_directories.erase(it);
+}
+
+int StatCache::mimeTypeId(const QMimeType &mimeType)
+{
+    int id = m_mimeTypes.indexOf(mimeType);
+    if (id < 0) {
+        id = m_mimeTypes.count();
+        m_mimeTypes.append(mimeType);
+    }
+    return id;
+}
+
+bool StatCache::isMainThread() const
+{
+    return QThread::currentThread() == thread();
+}
+
+void StatCache::unwatchDropped()
+{
+    if (!isMainThread())
+        return;
+
+    QStringList directories;
+    {
+        QMutexLocker locker(&m_mutex);
+        directories.swap(m_droppedDirectories);
+    }
+
+    InotifyWatcher *watcher = InotifyWatcher::instance();
+    foreach (const QString &directory, directories)
+        watcher->removeWatch(directory, QString(), this);
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef STATCACHE_H
+#define STATCACHE_H
+
+#include "inotifywatcher.h"
+#include "statfileinfo.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief The StatCache class is a process wide, thread safe cache of file information, so that
+ * the models and items inspecting the same files don't all go to the kernel separately.
+ *
+ * Only the files of watched directories are cached. The directories are watched through the
+ * shared InotifyWatcher for their entries coming and going and for the files being written,
+ * which is reported when a file is closed, or having their attributes changed. The entries are
+ * dropped by name as the events come in. Beyond a number of directories or entries the least
+ * recently used directories are let go of. While the watchers are suspended the events are not
+ * read, so the lookups go to the kernel until they are resumed.
+ *
+ * The watches are added on the main thread before the files are read. Other threads can only
+ * cache the files of the directories that are watched already, and have the others watched in
+ * the background; watch() on the main thread first to have a directory read on a worker cached.
+ * The generation returned by watch() changes along with the directory, information read under
+ * an earlier generation than the current one is not cached as it may already be out of date.
+ */
+class StatCache : public QObject, private InotifyWatcher::Listener
+{
+    Q_OBJECT
+
+public:
+    static StatCache *instance();
+
+    // the cached information of path, read and cached if there is none. Information read
+    // without mime type detection doesn't satisfy lookups that need the mime type.
+    StatFileInfo fileInfo(const QString &path, bool detectMimeType = true);
+    bool lookup(const QString &path, bool detectMimeType, StatFileInfo *info);
+    // caches information that was read while its directory was watched, at the generation
+    // given by watch() before the read
+    void insert(const StatFileInfo &info, quint64 generation, bool hasMimeType = true);
+
+    // returns whether the directory is watched, so that the files read from now on can be
+    // cached. Watched right away on the main thread, in the background from the others.
+    bool watch(const QString &directory, quint64 *generation = nullptr);
+
+    void invalidate(const QString &path);
+    // drops the directory and the cached entries in it
+    void invalidateDirectory(const QString &path);
+    void clear();
+
+    // the number of entries kept
+    int capacity() const;
+    void setCapacity(int capacity);
+
+    // the number of directories watched
+    int watchCount() const;
+
+    quint64 hits() const;
+    quint64 misses() const;
+
+private slots:
+    void watchPending();
+    void suspendedChanged();
+
+private:
+    explicit StatCache();
+
+    struct Entry
+    {
+        StatFileInfo::StatData data;
+        int mimeType; // index to m_mimeTypes, or -1 if not detected
+    };
+
+    struct Directory
+    {
+        Directory() : lastUsed(0), generation(0) {}
+
+        QHash<QString, Entry> entries; // by file name
+        quint64 lastUsed;
+        quint64 generation; // from m_generation whenever the directory changes
+    };
+
+    void directoryEvent(const QString &directory, const InotifyWatcher::Event &event) override;
+
+    // these expect m_mutex to be locked
+    bool addDirectory(const QString &directory);
+    void removeEntry(const QString &directory, const QString &name);
+    void trim(const QString &except);
+    void dropDirectory(QHash<QString, Directory>::iterator it);
+    int mimeTypeId(const QMimeType &mimeType);
+
+    bool isMainThread() const;
+    void unwatchDropped();
+
+    mutable QMutex m_mutex;
+    QHash<QString, Directory> m_directories; // watched, by path
+    QSet<QString> m_pendingDirectories; // to be watched on the main thread
+    QStringList m_droppedDirectories; // to be unwatched on the main thread
+    QVector<QMimeType> m_mimeTypes;
+    int m_entryCount;
+    int m_capacity;
+    quint64 m_clock;
+    quint64 m_generation;
+    quint64 m_hits;
+    quint64 m_misses;
+    QAtomicInt m_suspended;
+    bool m_connected;
+};
+
+#endif // STATCACHE_H
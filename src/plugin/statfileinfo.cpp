@@ -31,21 +31,135 @@
  */
 
 #include "statfileinfo.h"
+#include "archiveinfo.h"
+#include "fileinforesolver.h"
+#include "statcache.h"
 
 #include <QMimeDatabase>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/sysmacros.h>
+
+namespace {
+
+qint64 toNanoseconds(const struct timespec &time)
+{
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+QDateTime fromNanoseconds(qint64 time)
+{
+    return QDateTime::fromMSecsSinceEpoch(time / 1000000);
+}
+
+#ifdef STATX_BASIC_STATS
+// set when the kernel turns out to predate statx()
+QBasicAtomicInt statxUnsupported = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+void copyTimestamp(const struct statx_timestamp &from, struct timespec *to)
+{
+    to->tv_sec = from.tv_sec;
+    to->tv_nsec = from.tv_nsec;
+}
+
+bool statxAt(int dirFd, const char *fileName, int flags, struct stat64 *st, qint64 *birthTime)
+{
+    struct statx stx;
+    if (statx(dirFd, fileName, flags | AT_STATX_SYNC_AS_STAT, STATX_BASIC_STATS | STATX_BTIME, &stx) != 0)
+        return false;
+
+    memset(st, 0, sizeof(*st));
+    st->st_dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    st->st_ino = stx.stx_ino;
+    st->st_mode = stx.stx_mode;
+    st->st_nlink = stx.stx_nlink;
+    st->st_uid = stx.stx_uid;
+    st->st_gid = stx.stx_gid;
+    st->st_rdev = makedev(stx.stx_rdev_major, stx.stx_rdev_minor);
+    st->st_size = stx.stx_size;
+    st->st_blksize = stx.stx_blksize;
+    st->st_blocks = stx.stx_blocks;
+    copyTimestamp(stx.stx_atime, &st->st_atim);
+    copyTimestamp(stx.stx_mtime, &st->st_mtim);
+    copyTimestamp(stx.stx_ctime, &st->st_ctim);
+
+    *birthTime = (stx.stx_mask & STATX_BTIME)
+            ? qint64(stx.stx_btime.tv_sec) * 1000000000 + stx.stx_btime.tv_nsec
+            : -1;
+    return true;
+}
+#endif
+
+bool statAt(int dirFd, const char *fileName, bool followSymLinks, struct stat64 *st, qint64 *birthTime)
+{
+    const int flags = followSymLinks ? 0 : AT_SYMLINK_NOFOLLOW;
+
+#ifdef STATX_BASIC_STATS
+    if (!statxUnsupported.load()) {
+        if (statxAt(dirFd, fileName, flags, st, birthTime))
+            return true;
+        // statx() never fails with EPERM by itself, seccomp filters that predate it do
+        if (errno != ENOSYS && errno != EPERM)
+            return false;
+        statxUnsupported.store(1);
+    }
+#endif
+
+    *birthTime = -1;
+    return fstatat64(dirFd, fileName, st, flags) == 0;
+}
+
+void splitExtension(const QMimeDatabase &mimeDatabase, const QString &filePath, const QString &fileName,
+                    QString *baseName, QString *extension)
+{
+    *extension = mimeDatabase.suffixForFileName(filePath);
+    *baseName = fileName;
+
+    if (!extension->isEmpty()) {
+        if (baseName->lastIndexOf(*extension) < 1) {
+            extension->clear();
+        } else {
+            baseName->chop(extension->length() + 1);
+        }
+    }
+}
+
+}
+
 StatFileInfo::StatFileInfo()
-    : m_selected(false)
+    : m_birthTime(-1), m_archive(false), m_selected(false)
 {
     refresh();
 }
 
 StatFileInfo::StatFileInfo(QString fileName)
-    : m_fileName(fileName), m_selected(false)
+    : m_fileName(fileName), m_birthTime(-1), m_archive(false), m_selected(false)
 {
     refresh();
 }
 
+StatFileInfo::StatFileInfo(const QString &fileName, const StatData &data, const QMimeType &mimeType)
+    : m_fileName(fileName)
+    , m_mimeType(mimeType)
+    , m_fileInfo(fileName)
+    , m_stat(data.stat)
+    , m_lstat(data.lstat)
+    , m_birthTime(data.fields & BirthTime ? data.birthTime : -1)
+    , m_statFields(data.fields)
+    , m_archive(Sailfish::ArchiveInfo::format(mimeType) != Sailfish::ArchiveInfo::Unknown)
+    , m_selected(false)
+{
+    updateCachedData();
+    splitExtension(QMimeDatabase(), m_fileName, m_name, &m_baseName, &m_extension);
+}
+
+StatFileInfo::StatFileInfo(const QString &fileName, const struct stat64 &lstat, const struct stat64 &stat,
+                           const QMimeType &mimeType)
+    : StatFileInfo(fileName, StatData { lstat, stat, -1, BasicStats }, mimeType)
+{
+}
+
 StatFileInfo::~StatFileInfo()
 {
 }
@@ -60,7 +174,82 @@ void StatFileInfo::setFile(QString fileName)
 
 bool StatFileInfo::exists() const
 {
-    return m_fileInfo.exists();
+    // like QFileInfo, a broken symlink does not exist
+    return m_stat.st_mode != 0;
+}
+
+QString StatFileInfo::urlString() const
+{
+    if (m_url.isEmpty() && !m_absoluteFilePath.isEmpty())
+        m_url = QUrl::fromLocalFile(m_absoluteFilePath).toString();
+    return m_url;
+}
+
+void StatFileInfo::updateCachedData()
+{
+    m_name = m_fileInfo.fileName();
+    m_absoluteFilePath = m_fileInfo.absoluteFilePath();
+    if (m_absoluteFilePath == m_fileName) {
+        // share the data
+        m_absoluteFilePath = m_fileName;
+    }
+    m_symLinkTarget = isSymLink() ? m_fileInfo.symLinkTarget() : QString();
+    m_lastModified = exists() ? fromNanoseconds(lastModifiedNs()) : QDateTime();
+    m_url.clear();
+}
+
+QDateTime StatFileInfo::lastAccessed() const
+{
+    if (!(m_statFields & FullStats))
+        return m_fileInfo.lastRead();
+    return exists() ? fromNanoseconds(lastAccessedNs()) : QDateTime();
+}
+
+QDateTime StatFileInfo::created() const
+{
+    // without a birth time QFileInfo falls back to the status change time
+    if (m_birthTime < 0)
+        return m_fileInfo.created();
+    return fromNanoseconds(m_birthTime);
+}
+
+qint64 StatFileInfo::lastModifiedNs() const
+{
+    return exists() ? toNanoseconds(m_stat.st_mtim) : -1;
+}
+
+qint64 StatFileInfo::lastAccessedNs() const
+{
+    return exists() && (m_statFields & FullStats) ? toNanoseconds(m_stat.st_atim) : -1;
+}
+
+void StatFileInfo::readStatData(int dirFd, const char *fileName, StatData *data)
+{
+    memset(&data->lstat, 0, sizeof(data->lstat));
+    memset(&data->stat, 0, sizeof(data->stat));
+    data->birthTime = -1;
+    data->fields = BasicStats | FullStats;
+
+    // check the file without following symlinks
+    qint64 birthTime;
+    if (!statAt(dirFd, fileName, false, &data->lstat, &birthTime)) {
+        // if error, then set to undefined
+        memset(&data->lstat, 0, sizeof(data->lstat));
+        return;
+    }
+
+    if (!S_ISLNK(data->lstat.st_mode)) {
+        // if not symlink, then just copy lstat data to stat
+        data->stat = data->lstat;
+        data->birthTime = birthTime;
+    } else if (!statAt(dirFd, fileName, true, &data->stat, &data->birthTime)) {
+        // check the file after following possible symlinks
+        memset(&data->stat, 0, sizeof(data->stat));
+        data->birthTime = -1;
+    }
+
+    if (data->birthTime >= 0)
+        data->fields |= BirthTime;
 }
 
 bool StatFileInfo::isSafeToRead() const
@@ -76,7 +265,7 @@ bool StatFileInfo::isSafeToRead() const
 bool StatFileInfo::isSymLinkBroken() const
 {
     // if it is a symlink but it doesn't exist, then it is broken
-    if (m_fileInfo.isSymLink() && !m_fileInfo.exists())
+    if (isSymLink() && !exists())
         return true;
     return false;
 }
@@ -90,12 +279,16 @@ void StatFileInfo::refresh()
 {
     memset(&m_stat, 0, sizeof(m_stat));
     memset(&m_lstat, 0, sizeof(m_lstat));
+    m_birthTime = -1;
+    m_statFields = BasicStats | FullStats;
 
     m_fileInfo = QFileInfo(m_fileName);
     if (m_fileName.isEmpty()) {
         m_mimeType = QMimeType();
         m_baseName = QString();
         m_extension = QString();
+        m_archive = false;
+        updateCachedData();
 
         fileChanged();
 
@@ -107,50 +300,108 @@ void StatFileInfo::refresh()
     QMimeDatabase mimeDatabase;
 
     m_mimeType = mimeDatabase.mimeTypeForFile(m_fileInfo);
-    m_extension = mimeDatabase.suffixForFileName(m_fileName);
-    m_baseName = m_fileInfo.fileName();
 
-    if (!m_extension.isEmpty()) {
-        if (m_baseName.lastIndexOf(m_extension) < 1) {
-            m_extension.clear();
-        } else {
-            m_baseName.chop(m_extension.length() + 1);
-        }
-    }
+    m_archive = Sailfish::ArchiveInfo::format(m_mimeType) != Sailfish::ArchiveInfo::Unknown;
 
-    m_archiveInfo.setFile(m_fileName);
+    StatData data;
+    readStatData(AT_FDCWD, m_fileName.toUtf8().constData(), &data);
+    m_lstat = data.lstat;
+    m_stat = data.stat;
+    m_birthTime = data.birthTime;
+    m_statFields = data.fields;
 
-    QByteArray ba = m_fileName.toUtf8();
-    char *fn = ba.data();
+    updateCachedData();
+    splitExtension(mimeDatabase, m_fileName, m_name, &m_baseName, &m_extension);
 
-    // check the file without following symlinks
-    int res = lstat64(fn, &m_lstat);
-    if (res != 0) { // if error, then set to undefined
-        m_lstat.st_mode = 0;
-    }
-    // if not symlink, then just copy lstat data to stat
-    if (!S_ISLNK(m_lstat.st_mode)) {
-        memcpy(&m_stat, &m_lstat, sizeof(m_stat));        
-    } else {
-        // check the file after following possible symlinks
-        res = stat64(fn, &m_stat);
-        if (res != 0) { // if error, then set to undefined
-            m_stat.st_mode = 0;
-        }
+    fileChanged();
+}
+
+QVariant StatFileInfo::roleData(int role) const
+{
+    switch (role) {
+
+    case Qt::DisplayRole:
+    case FileNameRole:
+        return fileName();
+
+    case MimeTypeRole:
+        return mimeType();
+
+    case SizeRole:
+        return size();
+
+    case LastModifiedRole:
+        return lastModified();
+
+    case CreatedRole:
+        return created();
+
+    case IsDirRole:
+        return isDirAtEnd();
+
+    case IsArchiveRole:
+        return isArchive();
+
+    case IsLinkRole:
+        return isSymLink();
+
+    case SymLinkTargetRole:
+        return symLinkTarget();
+
+    case IsSelectedRole:
+        return isSelected();
+
+    case ExtensionRole:
+        return extension();
+
+    case AbsolutePathRole:
+        return absoluteFilePath();
+
+    case LastAccessedRole:
+        return lastAccessed();
+
+    case BaseNameRole:
+        return baseName();
+
+    case UrlRole:
+        return urlString();
+
+    default:
+        return QVariant();
     }
+}
 
-    fileChanged();
+QHash<int, QByteArray> StatFileInfo::roleNames()
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(FileNameRole, QByteArray("fileName"));
+    roles.insert(MimeTypeRole, QByteArray("mimeType"));
+    roles.insert(SizeRole, QByteArray("size"));
+    roles.insert(LastModifiedRole, QByteArray("modified"));
+    roles.insert(CreatedRole, QByteArray("created"));
+    roles.insert(IsDirRole, QByteArray("isDir"));
+    roles.insert(IsArchiveRole, QByteArray("isArchive"));
+    roles.insert(IsLinkRole, QByteArray("isLink"));
+    roles.insert(SymLinkTargetRole, QByteArray("symLinkTarget"));
+    roles.insert(IsSelectedRole, QByteArray("isSelected"));
+    roles.insert(ExtensionRole, QByteArray("extension"));
+    roles.insert(AbsolutePathRole, QByteArray("absolutePath"));
+    roles.insert(LastAccessedRole, QByteArray("accessed"));
+    roles.insert(BaseNameRole, QByteArray("baseName"));
+    roles.insert(UrlRole, QByteArray("url"));
+    return roles;
 }
 
 bool operator==(const StatFileInfo &lhs, const StatFileInfo &rhs)
 {
-    // We could just do an inode comparison here?
+    // Compare the raw stat data rather than permissions() or timestamps, which would
+    // access the files again. The mode covers isDirAtEnd() as well.
     return (lhs.fileName() == rhs.fileName() &&
             lhs.size() == rhs.size() &&
-            lhs.permissions() == rhs.permissions() &&
-            lhs.lastModified() == rhs.lastModified() &&
-            lhs.isSymLink() == rhs.isSymLink() &&
-            lhs.isDirAtEnd() == rhs.isDirAtEnd());
+            lhs.statData().st_mode == rhs.statData().st_mode &&
+            lhs.statData().st_ino == rhs.statData().st_ino &&
+            lhs.lastModifiedNs() == rhs.lastModifiedNs() &&
+            lhs.isSymLink() == rhs.isSymLink());
 }
 
 bool operator!=(const StatFileInfo &lhs, const StatFileInfo &rhs)
@@ -182,11 +433,24 @@ void FileInfo::setUrl(const QUrl &url)
         if (!m_url.isEmpty() && m_url.isLocalFile()) {
             m_localFile = true;
 
-            StatFileInfo::setFile(m_url.toLocalFile());
+            if (m_asynchronous) {
+                requestResolve();
+            } else {
+                ++m_serial;
+                const QString fileName = m_url.toLocalFile();
+                if (file() != fileName) {
+                    StatFileInfo::operator=(StatCache::instance()->fileInfo(fileName));
+                    emit fileChanged();
+                }
+                setStatus(Ready);
+            }
         } else {
             m_localFile = false;
 
+            // drop a pending asynchronous result
+            ++m_serial;
             StatFileInfo::setFile(QString());
+            setStatus(Null);
         }
 
         if (m_localFile != wasLocal) {
@@ -210,3 +474,54 @@ void FileInfo::setFile(const QString &file)
         setUrl(QUrl::fromLocalFile(file));
     }
 }
+
+void FileInfo::setAsynchronous(bool asynchronous)
+{
+    if (m_asynchronous != asynchronous) {
+        m_asynchronous = asynchronous;
+        emit asynchronousChanged();
+    }
+}
+
+void FileInfo::refresh()
+{
+    if (!m_localFile) {
+        StatFileInfo::refresh();
+    } else if (m_asynchronous) {
+        StatCache::instance()->invalidate(m_url.toLocalFile());
+        requestResolve();
+    } else {
+        // an explicit refresh always reads the file again
+        ++m_serial;
+        StatCache *cache = StatCache::instance();
+        cache->invalidate(m_url.toLocalFile());
+        StatFileInfo::operator=(cache->fileInfo(m_url.toLocalFile()));
+        emit fileChanged();
+        setStatus(Ready);
+    }
+}
+
+void FileInfo::requestResolve()
+{
+    FileInfoResolver::instance()->request(this, m_url.toLocalFile(), ++m_serial);
+    setStatus(Loading);
+}
+
+void FileInfo::setStatus(Status status)
+{
+    if (m_status != status) {
+        m_status = status;
+        emit statusChanged();
+    }
+}
+
+void FileInfo::setResolved(const StatFileInfo &info, quint64 serial)
+{
+    // a newer request is pending
+    if (serial != m_serial)
+        return;
+
+    StatFileInfo::operator=(info);
+    emit fileChanged();
+    setStatus(Ready);
+}
@@ -35,29 +35,68 @@
 
 #include <QFileInfo>
 #include <QDateTime>
+#include <QHash>
 #include <QMimeType>
 #include <QDir>
 #include <QUrl>
+#include <QVariant>
 #include <sys/stat.h>
 
-#include "archiveinfo.h"
-
 /**
  * @brief The StatFileInfo class is like QFileInfo, but has more detailed information about file types.
  */
 class StatFileInfo
 {
 public:
+    // model roles, shared by all the models that list StatFileInfo entries
+    enum Role {
+        FileNameRole = Qt::UserRole + 1,
+        MimeTypeRole,
+        SizeRole,
+        LastModifiedRole,
+        CreatedRole,
+        IsDirRole,
+        IsArchiveRole,
+        IsLinkRole,
+        SymLinkTargetRole,
+        IsSelectedRole,
+        ExtensionRole,
+        AbsolutePathRole,
+        LastAccessedRole,
+        BaseNameRole,
+        UrlRole
+    };
+
+    // the parts of the stat information that are known
+    enum StatField {
+        BasicStats = 0x1, // type, mode, size, inode and modification time
+        FullStats = 0x2, // everything else stat() returns, including access time
+        BirthTime = 0x4
+    };
+    Q_DECLARE_FLAGS(StatFields, StatField)
+
+    struct StatData {
+        struct stat64 lstat; // file itself without following symlinks
+        struct stat64 stat; // after following possible symlinks
+        qint64 birthTime; // in nanoseconds, or -1 if not recorded by the file system
+        StatFields fields;
+    };
+
     explicit StatFileInfo();
     explicit StatFileInfo(QString fileName);
+    // restores previously recorded information without accessing the file system
+    StatFileInfo(const QString &fileName, const StatData &data, const QMimeType &mimeType);
+    StatFileInfo(const QString &fileName, const struct stat64 &lstat, const struct stat64 &stat,
+                 const QMimeType &mimeType);
     ~StatFileInfo();
 
     QString file() const { return m_fileName; }
     void setFile(QString fileName);
-    QString fileName() const { return m_fileInfo.fileName(); }
+    QString fileName() const { return m_name; }
 
     QString mimeType() const { return m_mimeType.name(); }
     QString mimeTypeComment() const { return m_mimeType.comment(); }
+    QMimeType mimeTypeInfo() const { return m_mimeType; }
 
     // these inspect the file itself without following symlinks
 
@@ -85,7 +124,7 @@ public:
     bool isDirAtEnd() const { return S_ISDIR(m_stat.st_mode); }
 
     // archive
-    bool isArchive() const  { return m_archiveInfo.supported(); }
+    bool isArchive() const  { return m_archive; }
 
     // block special file
     bool isBlkAtEnd() const { return S_ISBLK(m_stat.st_mode); }
@@ -107,22 +146,38 @@ public:
     uint groupId() const { return m_fileInfo.groupId(); }
     QString owner() const { return m_fileInfo.owner(); }
     uint ownerId() const { return m_fileInfo.ownerId(); }
-    qint64 size() const { return m_fileInfo.size(); }
-    QDateTime lastModified() const { return m_fileInfo.lastModified(); }
-    QDateTime lastAccessed() const { return m_fileInfo.lastRead(); }
-    QDateTime created() const { return m_fileInfo.created(); }
+    qint64 size() const { return m_stat.st_size; }
+    QDateTime lastModified() const { return m_lastModified; }
+    QDateTime lastAccessed() const;
+    QDateTime created() const;
     QString extension() const { return m_extension; }
     QString baseName() const { return m_baseName; }
     bool exists() const;
     bool isSafeToRead() const;
 
+    // the raw stat() information, after following possible symlinks
+    const struct stat64 &statData() const { return m_stat; }
+    const struct stat64 &lstatData() const { return m_lstat; }
+    StatFields statFields() const { return m_statFields; }
+
+    // timestamps in nanoseconds since the epoch, -1 if not known
+    qint64 lastModifiedNs() const;
+    qint64 lastAccessedNs() const;
+    qint64 birthTimeNs() const { return m_birthTime; }
+
+    // reads the stat information of fileName, relative to dirFd if it is not an absolute path.
+    // Uses statx() when the kernel supports it, so that the birth time is available.
+    static void readStatData(int dirFd, const char *fileName, StatData *data);
+
     // path accessors
 
     QDir absoluteDir() const { return m_fileInfo.absoluteDir(); }
     QString absolutePath() const { return m_fileInfo.absolutePath(); }
-    QString absoluteFilePath() const { return m_fileInfo.absoluteFilePath(); }
+    QString absoluteFilePath() const { return m_absoluteFilePath; }
     QString suffix() const { return m_fileInfo.suffix(); }
-    QString symLinkTarget() const { return m_fileInfo.symLinkTarget(); }
+    QString symLinkTarget() const { return m_symLinkTarget; }
+    // the file URL as a string, built on first use
+    QString urlString() const;
     bool isSymLinkBroken() const;
 
     // selection
@@ -131,21 +186,37 @@ public:
 
     void refresh();
 
+    // model data for the given role
+    QVariant roleData(int role) const;
+    static QHash<int, QByteArray> roleNames();
+
 protected:
     virtual void fileChanged() {}
 
 private:
+    void updateCachedData();
+
     QString m_fileName;
     QString m_baseName;
     QString m_extension;
+    // precalculated, so that model data can be returned without allocations
+    QString m_name;
+    QString m_absoluteFilePath;
+    QString m_symLinkTarget;
+    QDateTime m_lastModified;
+    mutable QString m_url;
     QMimeType m_mimeType;
     QFileInfo m_fileInfo;
-    Sailfish::ArchiveInfo m_archiveInfo;
     struct stat64 m_stat; // after following possible symlinks
     struct stat64 m_lstat; // file itself without following symlinks
+    qint64 m_birthTime;
+    StatFields m_statFields;
+    bool m_archive;
     bool m_selected;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(StatFileInfo::StatFields)
+
 bool operator==(const StatFileInfo &lhs, const StatFileInfo &rhs);
 bool operator!=(const StatFileInfo &lhs, const StatFileInfo &rhs);
 
@@ -166,11 +237,21 @@ class FileInfo : public QObject, protected StatFileInfo
     Q_PROPERTY(QString extension READ extension NOTIFY fileChanged)
     Q_PROPERTY(QString absolutePath READ absoluteFilePath NOTIFY fileChanged)
     Q_PROPERTY(QDateTime accessed READ lastAccessed NOTIFY fileChanged)
+    Q_PROPERTY(QDateTime created READ created NOTIFY fileChanged)
     Q_PROPERTY(QString baseName READ baseName NOTIFY fileChanged)
     Q_PROPERTY(QString directoryPath READ absolutePath NOTIFY fileChanged)
     Q_PROPERTY(bool exists READ exists NOTIFY fileChanged)
     Q_PROPERTY(bool localFile READ isLocalFile NOTIFY localFileChanged)
+    Q_PROPERTY(bool asynchronous READ asynchronous WRITE setAsynchronous NOTIFY asynchronousChanged)
+    Q_PROPERTY(Status status READ status NOTIFY statusChanged)
 public:
+    enum Status {
+        Null,
+        Loading,
+        Ready
+    };
+    Q_ENUM(Status)
+
     explicit FileInfo(QObject *parent = nullptr);
     ~FileInfo() override;
 
@@ -181,16 +262,34 @@ public:
 
     void setFile(const QString &file);
 
-    Q_INVOKABLE void refresh() { StatFileInfo::refresh(); }
+    // when asynchronous, the file is read on a worker thread and the properties keep their
+    // previous values until status becomes Ready
+    bool asynchronous() const { return m_asynchronous; }
+    void setAsynchronous(bool asynchronous);
+
+    Status status() const { return m_status; }
+
+    Q_INVOKABLE void refresh();
 
 signals:
     void fileChanged() override;
     void urlChanged();
     void localFileChanged();
+    void asynchronousChanged();
+    void statusChanged();
 
 private:
+    friend class FileInfoResolver;
+
+    void requestResolve();
+    void setStatus(Status status);
+    void setResolved(const StatFileInfo &info, quint64 serial);
+
     QUrl m_url;
     bool m_localFile = false;
+    bool m_asynchronous = false;
+    Status m_status = Null;
+    quint64 m_serial = 0;
 };
 
 #endif // STATFILEINFO_H
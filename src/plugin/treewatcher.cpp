@@ -0,0 +1,446 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "treewatcher.h"
+#include "directoryreader.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QPair>
+#include <QTimerEvent>
+#include <QVector>
+#include <QtConcurrent>
+#include <QtDebug>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <sys/inotify.h>
+
+namespace {
+
+// set for testing, otherwise derived from fs.inotify.max_user_watches
+int watchBudgetOverride = -1;
+
+// the signature of a tree that no longer exists, zero stands for not yet known
+const quint64 MissingTree = 1;
+
+bool isInside(const QString &path, const QString &root)
+{
+    if (!path.startsWith(root))
+        return false;
+    return path.length() == root.length()
+            || root.endsWith(QLatin1Char('/'))
+            || path.at(root.length()) == QLatin1Char('/');
+}
+
+// calls visit() for the subdirectories of the tree, without descending into other file systems
+template <typename Visit>
+void walkTree(DirectoryReader &reader, const QString &path, dev_t device, Visit visit)
+{
+    while (const struct dirent64 *entry = reader.next()) {
+        if (DirectoryReader::entryType(reader.fd(), entry) != DT_DIR)
+            continue;
+
+        DirectoryReader child(reader.fd(), entry->d_name);
+        struct stat64 st;
+        if (!child.isValid() || fstat64(child.fd(), &st) != 0 || st.st_dev != device)
+            continue;
+
+        const QString directory = InotifyWatcher::filePath(path, QFile::decodeName(entry->d_name));
+        visit(directory, st);
+        walkTree(child, directory, device, visit);
+    }
+}
+
+// the directories of the tree, including the top
+QStringList readTree(const QString &path)
+{
+    QStringList rv;
+    DirectoryReader reader(path);
+    struct stat64 st;
+    if (reader.isValid() && fstat64(reader.fd(), &st) == 0) {
+        rv.append(path);
+        walkTree(reader, path, st.st_dev, [&rv](const QString &directory, const struct stat64 &) {
+            rv.append(directory);
+        });
+    }
+    return rv;
+}
+
+quint64 directorySignature(const struct stat64 &st)
+{
+    // order independent, so that the order of the entries does not matter
+    const quint64 modified = quint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return (modified ^ (quint64(st.st_ino) << 32) ^ st.st_ino) * Q_UINT64_C(1099511628211);
+}
+
+quint64 treeSignature(const QString &path)
+{
+    DirectoryReader reader(path);
+    struct stat64 st;
+    if (!reader.isValid() || fstat64(reader.fd(), &st) != 0)
+        return MissingTree;
+
+    quint64 rv = MissingTree + 1 + directorySignature(st);
+    walkTree(reader, path, st.st_dev, [&rv](const QString &, const struct stat64 &child) {
+        rv += directorySignature(child);
+    });
+    return rv == 0 ? MissingTree + 1 : rv;
+}
+
+QVector<quint64> treeSignatures(const QStringList &paths)
+{
+    QVector<quint64> rv;
+    rv.reserve(paths.count());
+    foreach (const QString &path, paths)
+        rv.append(treeSignature(path));
+    return rv;
+}
+
+}
+
+TreeWatcher::TreeWatcher(QObject *parent)
+    : QObject(parent)
+    , m_events(InotifyWatcher::ExistenceEvents)
+    , m_pollInterval(10000)
+    , m_overflowCount(0)
+    , m_polling(false)
+{
+    m_clock.start();
+    connect(InotifyWatcher::instance(), &InotifyWatcher::suspendedChanged, this, &TreeWatcher::suspendedChanged);
+}
+
+TreeWatcher::~TreeWatcher()
+{
+    clear();
+}
+
+void TreeWatcher::addPath(const QString &path)
+{
+    const QString root = QDir::cleanPath(path);
+    if (root.isEmpty() || m_roots.contains(root))
+        return;
+
+    const bool covered = isCovered(root);
+    m_roots.append(root);
+    if (!covered) {
+        // watch the top right away, the rest of the tree is read on a worker thread
+        watchDirectory(root);
+        scanTree(root);
+    }
+}
+
+void TreeWatcher::removePath(const QString &path)
+{
+    const QString root = QDir::cleanPath(path);
+    if (!m_roots.removeOne(root))
+        return;
+
+    InotifyWatcher *watcher = InotifyWatcher::instance();
+    for (QHash<QString, qint64>::iterator it = m_directories.begin(); it != m_directories.end(); ) {
+        if (isInside(it.key(), root) && !isCovered(it.key())) {
+            watcher->removeWatch(it.key(), QString(), this);
+            it = m_directories.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (QHash<QString, quint64>::iterator it = m_polled.begin(); it != m_polled.end(); ) {
+        if (isInside(it.key(), root) && !isCovered(it.key())) {
+            it = m_polled.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (m_polled.isEmpty())
+        m_pollTimer.stop();
+}
+
+void TreeWatcher::clear()
+{
+    InotifyWatcher *watcher = InotifyWatcher::instance();
+    for (QHash<QString, qint64>::const_iterator it = m_directories.constBegin(); it != m_directories.constEnd(); ++it)
+        watcher->removeWatch(it.key(), QString(), this);
+
+    m_roots.clear();
+    m_directories.clear();
+    m_polled.clear();
+    m_pollTimer.stop();
+    m_overflowTimer.stop();
+}
+
+void TreeWatcher::setPollInterval(int interval)
+{
+    m_pollInterval = interval;
+    if (m_pollTimer.isActive())
+        m_pollTimer.start(m_pollInterval, this);
+}
+
+void TreeWatcher::setEvents(quint32 events)
+{
+    m_events = events;
+}
+
+int TreeWatcher::watchBudget()
+{
+    if (watchBudgetOverride >= 0)
+        return watchBudgetOverride;
+
+    static const int budget = []() {
+        QFile file(QStringLiteral("/proc/sys/fs/inotify/max_user_watches"));
+        const int maximum = file.open(QIODevice::ReadOnly) ? file.readAll().trimmed().toInt() : 0;
+        // the limit is shared with the other processes of the user
+        return maximum > 0 ? maximum / 2 : 4096;
+    }();
+    return budget;
+}
+
+void TreeWatcher::setWatchBudget(int budget)
+{
+    watchBudgetOverride = budget;
+}
+
+void TreeWatcher::suspendedChanged()
+{
+    if (InotifyWatcher::instance()->isSuspended()) {
+        m_pollTimer.stop();
+    } else if (!m_polled.isEmpty()) {
+        // catch up with the changes made while suspended
+        m_pollTimer.start(m_pollInterval, this);
+        poll();
+    }
+}
+
+void TreeWatcher::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_pollTimer.timerId()) {
+        InotifyWatcher::instance()->recordWakeup();
+        poll();
+    } else if (event->timerId() == m_overflowTimer.timerId()) {
+        m_overflowTimer.stop();
+
+        // anything may have changed, and new subdirectories may have gone unnoticed
+        foreach (const QString &root, m_roots) {
+            scanTree(root);
+            emit directoryChanged(root);
+        }
+    } else {
+        QObject::timerEvent(event);
+    }
+}
+
+void TreeWatcher::directoryEvent(const QString &directory, const InotifyWatcher::Event &event)
+{
+    const quint32 mask = event.mask;
+
+    if (mask & IN_Q_OVERFLOW) {
+        // reported for every watched directory, handle it once
+        if (!m_overflowTimer.isActive()) {
+            ++m_overflowCount;
+            m_overflowTimer.start(0, this);
+        }
+        return;
+    }
+
+    QHash<QString, qint64>::iterator it = m_directories.find(directory);
+    if (it != m_directories.end()) {
+        if (mask & (IN_IGNORED | IN_MOVE_SELF)) {
+            // InotifyWatcher has dropped the watch
+            m_directories.erase(it);
+        } else {
+            it.value() = m_clock.elapsed();
+        }
+    }
+
+    if (!event.name.isEmpty() && (mask & IN_ISDIR)) {
+        const QString path = InotifyWatcher::filePath(directory, event.name);
+        if (mask & (IN_CREATE | IN_MOVED_TO)) {
+            // the new directory may already have subdirectories of its own
+            watchDirectory(path);
+            scanTree(path);
+        } else if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+            unwatchTree(path);
+        }
+    }
+
+    if (!(mask & IN_IGNORED))
+        emit directoryChanged(directory);
+}
+
+void TreeWatcher::scanTree(const QString &path)
+{
+    QFutureWatcher<QStringList> *watcher = new QFutureWatcher<QStringList>(this);
+    connect(watcher, &QFutureWatcher<QStringList>::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+
+        foreach (const QString &directory, watcher->result()) {
+            // the tree may have been removed meanwhile
+            if (isCovered(directory))
+                watchDirectory(directory);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(readTree, path));
+}
+
+void TreeWatcher::watchDirectory(const QString &path)
+{
+    if (m_directories.contains(path) || isPolled(path))
+        return;
+
+    InotifyWatcher *watcher = InotifyWatcher::instance();
+    if (watcher->watchCount() >= watchBudget()) {
+        degradeLeastActive(path);
+        // the path may have ended up in a polled subtree
+        if (isPolled(path))
+            return;
+        if (watcher->watchCount() >= watchBudget()) {
+            startPolling(path);
+            return;
+        }
+    }
+
+    int error = 0;
+    if (watcher->addWatch(path, QString(), this, m_events, &error)) {
+        m_directories.insert(path, m_clock.elapsed());
+    } else if (!watcher->isValid() || error == ENOSPC) {
+        // out of watches regardless of the budget
+        startPolling(path);
+    }
+}
+
+void TreeWatcher::startPolling(const QString &path)
+{
+    unwatchTree(path);
+    m_polled.insert(path, 0);
+    if (!m_pollTimer.isActive() && !InotifyWatcher::instance()->isSuspended())
+        m_pollTimer.start(m_pollInterval, this);
+}
+
+void TreeWatcher::unwatchTree(const QString &path)
+{
+    InotifyWatcher *watcher = InotifyWatcher::instance();
+    for (QHash<QString, qint64>::iterator it = m_directories.begin(); it != m_directories.end(); ) {
+        if (isInside(it.key(), path)) {
+            watcher->removeWatch(it.key(), QString(), this);
+            it = m_directories.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (QHash<QString, quint64>::iterator it = m_polled.begin(); it != m_polled.end(); ) {
+        if (isInside(it.key(), path)) {
+            it = m_polled.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TreeWatcher::degradeLeastActive(const QString &except)
+{
+    QVector<QPair<qint64, QString> > candidates;
+    candidates.reserve(m_directories.count());
+    for (QHash<QString, qint64>::const_iterator it = m_directories.constBegin(); it != m_directories.constEnd(); ++it) {
+        // the tops of the trees stay watched
+        if (!m_roots.contains(it.key()) && it.key() != except)
+            candidates.append(qMakePair(it.value(), it.key()));
+    }
+    if (candidates.isEmpty())
+        return;
+
+    if (m_polled.isEmpty())
+        qWarning() << "Out of inotify watches, polling the least active directories";
+
+    // free a quarter of the budget at once, so that this is not repeated for every new directory
+    std::sort(candidates.begin(), candidates.end());
+    InotifyWatcher *watcher = InotifyWatcher::instance();
+    const int target = watchBudget() * 3 / 4;
+    for (int i = 0; i < candidates.count() && watcher->watchCount() > target; ++i) {
+        if (m_directories.contains(candidates.at(i).second))
+            startPolling(candidates.at(i).second);
+    }
+}
+
+bool TreeWatcher::isCovered(const QString &path) const
+{
+    foreach (const QString &root, m_roots) {
+        if (isInside(path, root))
+            return true;
+    }
+    return false;
+}
+
+bool TreeWatcher::isPolled(const QString &path) const
+{
+    for (QHash<QString, quint64>::const_iterator it = m_polled.constBegin(); it != m_polled.constEnd(); ++it) {
+        if (isInside(path, it.key()))
+            return true;
+    }
+    return false;
+}
+
+void TreeWatcher::poll()
+{
+    if (m_polled.isEmpty()) {
+        m_pollTimer.stop();
+        return;
+    }
+    if (m_polling)
+        return;
+
+    m_polling = true;
+    const QStringList subtrees = m_polled.keys();
+
+    QFutureWatcher<QVector<quint64> > *watcher = new QFutureWatcher<QVector<quint64> >(this);
+    connect(watcher, &QFutureWatcher<QVector<quint64> >::finished, this, [this, watcher, subtrees]() {
+        watcher->deleteLater();
+        m_polling = false;
+
+        const QVector<quint64> signatures = watcher->result();
+        for (int i = 0; i < subtrees.count(); ++i) {
+            QHash<QString, quint64>::iterator it = m_polled.find(subtrees.at(i));
+            if (it == m_polled.end())
+                continue;
+
+            const quint64 previous = it.value();
+            it.value() = signatures.at(i);
+            if (previous != 0 && previous != signatures.at(i))
+                emit directoryChanged(subtrees.at(i));
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(treeSignatures, subtrees));
+}
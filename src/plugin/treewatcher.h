@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef TREEWATCHER_H
+#define TREEWATCHER_H
+
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+#include "inotifywatcher.h"
+
+/**
+ * @brief The TreeWatcher class watches whole directory trees. Subdirectories are watched as they
+ * appear, through the shared InotifyWatcher. The inotify watches of a user are limited by
+ * fs.inotify.max_user_watches, so the process only uses a share of them; when that runs out, the
+ * least active subtrees stop being watched and are polled for changes in their directory
+ * modification times instead.
+ * By default only entries appearing and disappearing are reported. Owners that depend on the
+ * contents of the files, e.g. their sizes, should ask for InotifyWatcher::ChangeEvents; polled
+ * subtrees still only notice changes to the directories.
+ */
+class TreeWatcher : public QObject, private InotifyWatcher::Listener
+{
+    Q_OBJECT
+
+public:
+    explicit TreeWatcher(QObject *parent = 0);
+    ~TreeWatcher();
+
+    void addPath(const QString &path);
+    void removePath(const QString &path);
+    void clear();
+    QStringList paths() const { return m_roots; }
+
+    // the InotifyWatcher::Events to watch for, applies to the directories watched afterwards
+    quint32 events() const { return m_events; }
+    void setEvents(quint32 events);
+
+    // the number of directories watched with inotify, and the number of polled subtrees
+    int watchCount() const { return m_directories.count(); }
+    int polledCount() const { return m_polled.count(); }
+    // the number of times inotify events were lost and the trees were checked again
+    int overflowCount() const { return m_overflowCount; }
+
+    int pollInterval() const { return m_pollInterval; }
+    void setPollInterval(int interval);
+
+    // the number of inotify watches all the TreeWatchers of the process may use together,
+    // by default half of fs.inotify.max_user_watches
+    static int watchBudget();
+    static void setWatchBudget(int budget);
+
+signals:
+    // a directory in one of the trees changed, for polled subtrees this is the top of the subtree
+    void directoryChanged(const QString &path);
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    void directoryEvent(const QString &directory, const InotifyWatcher::Event &event) override;
+
+    void scanTree(const QString &path);
+    void watchDirectory(const QString &path);
+    void startPolling(const QString &path);
+    void unwatchTree(const QString &path);
+    void degradeLeastActive(const QString &except);
+    bool isCovered(const QString &path) const;
+    bool isPolled(const QString &path) const;
+    void poll();
+    void suspendedChanged();
+
+    QStringList m_roots;
+    QHash<QString, qint64> m_directories; // the time of the last event, by the watched directory
+    QHash<QString, quint64> m_polled; // the signature of the tree, by the top of the polled subtree
+    QElapsedTimer m_clock;
+    QBasicTimer m_pollTimer;
+    QBasicTimer m_overflowTimer;
+    quint32 m_events;
+    int m_pollInterval;
+    int m_overflowCount;
+    bool m_polling;
+};
+
+#endif // TREEWATCHER_H
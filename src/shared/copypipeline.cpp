@@ -0,0 +1,452 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "copypipeline.h"
+#include "directoryreader.h"
+#include "uringengine.h"
+
+#include <QFile>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThread>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+namespace {
+
+// the jobs waiting for a copying thread, the walk pauses beyond this
+const int MaximumQueued = 256;
+
+// how often waiting threads ask whether to go on
+const unsigned long WaitInterval = 100;
+
+int concurrencies[] = {
+    1, // RotationalDevice, parallel copies would only make the heads seek
+    4, // SolidStateDevice
+    0, // MemoryDevice, one per core
+    8 // RemoteDevice, bound by the round trips
+};
+
+QString filePath(const QString &directory, const char *name)
+{
+    return directory + QLatin1Char('/') + QFile::decodeName(name);
+}
+
+// the queue/rotational flag of the block device, or of the disk of a partition
+int rotational(dev_t device)
+{
+    const QString path = QStringLiteral("/sys/dev/block/%1:%2/").arg(major(device)).arg(minor(device));
+    const QString names[] = { QStringLiteral("queue/rotational"), QStringLiteral("../queue/rotational") };
+    for (const QString &name : names) {
+        QFile file(path + name);
+        if (file.open(QIODevice::ReadOnly))
+            return file.readAll().trimmed().toInt();
+    }
+    return -1;
+}
+
+}
+
+class CopyPipeline::Worker : public QRunnable
+{
+public:
+    explicit Worker(CopyPipeline *pipeline) : m_pipeline(pipeline) {}
+
+    void run() override { m_pipeline->work(); }
+
+private:
+    CopyPipeline *m_pipeline;
+};
+
+CopyPipeline::CopyPipeline(const QString &srcDirectory, const QString &destDirectory)
+    : m_srcDirectory(srcDirectory)
+    , m_destDirectory(destDirectory)
+    , m_removeSources(false)
+    , m_destDevice(0)
+    , m_walkDone(false)
+    , m_stopped(false)
+    , m_failed(false)
+{
+    QString existing = destDirectory;
+    while (!existing.isEmpty() && !QFile::exists(existing))
+        existing = existing.left(existing.lastIndexOf(QLatin1Char('/')));
+    setConcurrency(defaultConcurrency(deviceType(existing.isEmpty() ? QStringLiteral("/") : existing)));
+    setBackend(UringBackend);
+}
+
+CopyPipeline::~CopyPipeline()
+{
+    stop();
+    m_pool.waitForDone();
+}
+
+void CopyPipeline::setConcurrency(int concurrency)
+{
+    m_concurrency = qMax(1, concurrency);
+}
+
+void CopyPipeline::setBackend(Backend backend)
+{
+    m_backend = backend == UringBackend && UringEngine::isAvailable() ? UringBackend : ThreadedBackend;
+}
+
+void CopyPipeline::setRemoveSources(bool remove)
+{
+    m_removeSources = remove;
+}
+
+void CopyPipeline::setProgressFuncs(const FileFunc &fileStarted, const FileOperations::BytesFunc &copied,
+                                    const FileFunc &fileCopied)
+{
+    m_fileStarted = fileStarted;
+    m_copied = copied;
+    m_fileCopied = fileCopied;
+}
+
+CopyPipeline::DeviceType CopyPipeline::deviceType(const QString &path)
+{
+    const int fd = open(QFile::encodeName(path).constData(), O_PATH | O_CLOEXEC);
+    if (fd < 0)
+        return SolidStateDevice;
+
+    const DeviceType type = deviceType(fd);
+    close(fd);
+    return type;
+}
+
+CopyPipeline::DeviceType CopyPipeline::deviceType(int fd)
+{
+    struct statfs64 fs;
+    if (fstatfs64(fd, &fs) == 0) {
+        switch (quint32(fs.f_type)) {
+        case 0x65735546: // FUSE
+        case 0x517b: // SMB
+        case 0xfe534d42: // SMB2
+        case 0xff534d42: // CIFS
+        case 0x6969: // NFS
+            return RemoteDevice;
+        case 0x01021994: // tmpfs
+        case 0x858458f6: // ramfs
+            return MemoryDevice;
+        default:
+            break;
+        }
+    }
+
+    struct stat64 st;
+    if (fstat64(fd, &st) == 0 && rotational(st.st_dev) == 1)
+        return RotationalDevice;
+
+    // flash, or a file system without a single block device, like btrfs
+    return SolidStateDevice;
+}
+
+int CopyPipeline::defaultConcurrency(DeviceType type)
+{
+    const int concurrency = concurrencies[type];
+    return concurrency > 0 ? concurrency : qMax(1, QThread::idealThreadCount());
+}
+
+void CopyPipeline::setDefaultConcurrency(DeviceType type, int concurrency)
+{
+    concurrencies[type] = concurrency;
+}
+
+bool CopyPipeline::run(const FileOperations::ContinueFunc &continueOperation)
+{
+    const QByteArray srcName = QFile::encodeName(m_srcDirectory);
+    struct stat64 st;
+    if (lstat64(srcName.constData(), &st) != 0)
+        return false;
+
+    if (S_ISLNK(st.st_mode)) {
+        // copy dir symlink by creating a new link, the contents belong to the target
+        if (m_fileStarted)
+            m_fileStarted(m_srcDirectory);
+        return FileOperations::copyOverwrite(m_srcDirectory, m_destDirectory) && fileCopied(m_srcDirectory);
+    }
+
+    if (!S_ISDIR(st.st_mode))
+        return false;
+
+    // subtrees already on the destination file system are renamed rather than copied
+    if (m_removeSources) {
+        const QString parent = m_destDirectory.left(m_destDirectory.lastIndexOf(QLatin1Char('/')));
+        struct stat64 destStat;
+        if (stat64(QFile::encodeName(parent.isEmpty() ? QStringLiteral("/") : parent).constData(), &destStat) == 0)
+            m_destDevice = destStat.st_dev;
+    }
+
+    // one ring keeps as many files in flight as the threads would
+    const int workers = m_backend == UringBackend ? 1 : m_concurrency;
+    m_pool.setMaxThreadCount(workers);
+    for (int i = 0; i < workers; ++i)
+        m_pool.start(new Worker(this));
+
+    const bool walked = walk(m_srcDirectory, m_destDirectory, continueOperation);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_walkDone = true;
+        if (!walked)
+            m_stopped = true;
+        m_jobAvailable.wakeAll();
+    }
+
+    // the copies may still be cancelled
+    while (!m_pool.waitForDone(WaitInterval)) {
+        if (continueOperation && !continueOperation())
+            stop();
+    }
+
+    applyMetadata();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_stopped || m_failed)
+            return false;
+    }
+
+    return !m_removeSources || removeSourceDirectories();
+}
+
+bool CopyPipeline::walk(const QString &srcDirectory, const QString &destDirectory,
+                        const FileOperations::ContinueFunc &continueOperation)
+{
+    DirectoryReader reader(srcDirectory);
+    struct stat64 st;
+    if (!reader.isValid() || fstat64(reader.fd(), &st) != 0)
+        return false;
+
+    // writable until filled, the permissions are applied at the end
+    const QByteArray destName = QFile::encodeName(destDirectory);
+    if (mkdir(destName.constData(), S_IRWXU) == 0) {
+        m_directories.append(qMakePair(destName, mode_t(st.st_mode & 07777)));
+    } else if (errno != EEXIST) {
+        return false;
+    }
+    if (m_removeSources)
+        m_sourceDirectories.append(QFile::encodeName(srcDirectory));
+
+    QStringList subdirectories;
+    while (const struct dirent64 *entry = reader.next()) {
+        // stop if cancelled
+        if (continueOperation && !continueOperation())
+            return false;
+
+        // as QDir::Files and QDir::AllDirs would list them, but a move leaves nothing behind
+        if (entry->d_name[0] == '.' && !m_removeSources)
+            continue;
+
+        const unsigned char type = DirectoryReader::entryType(reader.fd(), entry);
+        if (type == DT_DIR) {
+            // e.g. a mount of the destination file system within the source
+            struct stat64 subdirectory;
+            if (m_removeSources
+                    && fstatat64(reader.fd(), entry->d_name, &subdirectory, AT_SYMLINK_NOFOLLOW) == 0
+                    && subdirectory.st_dev == m_destDevice
+                    && rename(QFile::encodeName(filePath(srcDirectory, entry->d_name)).constData(),
+                              QFile::encodeName(filePath(destDirectory, entry->d_name)).constData()) == 0) {
+                continue;
+            }
+            subdirectories.append(QFile::decodeName(entry->d_name));
+        } else if (type == DT_REG || type == DT_LNK) {
+            const Job job = { filePath(srcDirectory, entry->d_name), filePath(destDirectory, entry->d_name),
+                              type == DT_LNK };
+            if (!enqueue(job, continueOperation))
+                return false;
+        }
+    }
+
+    foreach (const QString &name, subdirectories) {
+        if (!walk(srcDirectory + QLatin1Char('/') + name, destDirectory + QLatin1Char('/') + name, continueOperation))
+            return false;
+    }
+
+    return true;
+}
+
+bool CopyPipeline::enqueue(const Job &job, const FileOperations::ContinueFunc &continueOperation)
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_jobs.count() >= MaximumQueued && !m_stopped && !m_failed) {
+        if (!m_spaceAvailable.wait(&m_mutex, WaitInterval) && continueOperation) {
+            locker.unlock();
+            const bool proceed = continueOperation();
+            locker.relock();
+            if (!proceed) {
+                m_stopped = true;
+                m_jobAvailable.wakeAll();
+            }
+        }
+    }
+
+    if (m_stopped || m_failed)
+        return false;
+
+    m_jobs.enqueue(job);
+    m_jobAvailable.wakeOne();
+    return true;
+}
+
+void CopyPipeline::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stopped = true;
+    m_jobAvailable.wakeAll();
+    m_spaceAvailable.wakeAll();
+}
+
+void CopyPipeline::fail()
+{
+    QMutexLocker locker(&m_mutex);
+    m_failed = true;
+    m_jobAvailable.wakeAll();
+    m_spaceAvailable.wakeAll();
+}
+
+// waits for jobs, false once there will be no more
+bool CopyPipeline::takeJobs(QVector<Job> *jobs, int maximum)
+{
+    jobs->clear();
+
+    QMutexLocker locker(&m_mutex);
+    while (m_jobs.isEmpty() && !m_walkDone && !m_stopped && !m_failed)
+        m_jobAvailable.wait(&m_mutex);
+    if (m_jobs.isEmpty() || m_stopped || m_failed)
+        return false;
+
+    while (!m_jobs.isEmpty() && jobs->count() < maximum)
+        jobs->append(m_jobs.dequeue());
+    m_spaceAvailable.wakeAll();
+    return true;
+}
+
+bool CopyPipeline::copy(const Job &job)
+{
+    if (m_fileStarted)
+        m_fileStarted(job.source);
+
+    return FileOperations::copyOverwrite(job.source, job.target, nullptr, m_copied) && fileCopied(job.source);
+}
+
+bool CopyPipeline::fileCopied(const QString &source)
+{
+    if (m_removeSources && !removeCopied(source, m_destDirectory + source.mid(m_srcDirectory.length())))
+        return false;
+
+    if (m_fileCopied)
+        m_fileCopied(source);
+    return true;
+}
+
+bool CopyPipeline::removeCopied(const QString &source, const QString &target)
+{
+    const QByteArray srcName = QFile::encodeName(source);
+    struct stat64 srcStat;
+    struct stat64 destStat;
+    if (lstat64(srcName.constData(), &srcStat) != 0
+            || lstat64(QFile::encodeName(target).constData(), &destStat) != 0
+            || (srcStat.st_mode & S_IFMT) != (destStat.st_mode & S_IFMT)
+            || (S_ISREG(srcStat.st_mode) && srcStat.st_size != destStat.st_size)) {
+        return false;
+    }
+
+    // the copy has to be on the disk before the only other one goes, a write error surfacing
+    // only at writeback would otherwise lose the file
+    if (S_ISREG(destStat.st_mode)) {
+        const int fd = open(QFile::encodeName(target).constData(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+        const bool synced = fdatasync(fd) == 0;
+        if (close(fd) != 0 || !synced)
+            return false;
+    }
+
+    return unlink(srcName.constData()) == 0;
+}
+
+// the deepest first, a directory still holding special files stays and fails the move
+bool CopyPipeline::removeSourceDirectories()
+{
+    bool removed = true;
+    for (int i = m_sourceDirectories.count() - 1; i >= 0; --i)
+        removed = rmdir(m_sourceDirectories.at(i).constData()) == 0 && removed;
+    return removed;
+}
+
+void CopyPipeline::work()
+{
+    QScopedPointer<UringEngine> engine;
+    if (m_backend == UringBackend) {
+        engine.reset(new UringEngine);
+        if (!engine->isValid())
+            engine.reset();
+    }
+
+    QVector<Job> jobs;
+    while (takeJobs(&jobs, engine ? MaximumQueued : 1)) {
+        QVector<UringEngine::File> files;
+        for (const Job &job : jobs) {
+            if (engine && !job.link) {
+                const UringEngine::File file = { job.source, job.target };
+                files.append(file);
+            } else if (!copy(job)) {
+                fail();
+                return;
+            }
+        }
+
+        if (!files.isEmpty()
+                && !engine->copyFiles(files, m_fileStarted, m_copied, [this](const QString &source) {
+                    if (!fileCopied(source))
+                        fail();
+                }, [this]() -> bool {
+                    QMutexLocker locker(&m_mutex);
+                    return !m_stopped && !m_failed;
+                })) {
+            fail();
+            return;
+        }
+    }
+}
+
+void CopyPipeline::applyMetadata()
+{
+    // the deepest first, so that a read-only parent doesn't stop the rest
+    for (int i = m_directories.count() - 1; i >= 0; --i)
+        chmod(m_directories.at(i).first.constData(), m_directories.at(i).second);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef COPYPIPELINE_H
+#define COPYPIPELINE_H
+
+#include "fileoperations.h"
+
+#include <QMutex>
+#include <QPair>
+#include <QQueue>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <sys/types.h>
+
+/**
+ * @brief The CopyPipeline class copies a directory tree in stages: the calling thread walks the
+ * source and creates the directories, a pool of threads copies the files as they are found, and
+ * the permissions of the new directories are applied last, so that read-only directories can be
+ * filled first. Copying several small files at once hides the latency of opening and creating
+ * them; how many is chosen by the type of the destination device.
+ *
+ * Where io_uring is available the files are instead copied from a single thread through a
+ * UringEngine, in batches taken from the queue.
+ *
+ * Like the sequential copy, hidden files and special files are skipped, and symbolic links are
+ * copied as links.
+ *
+ * To move a tree to another file system, the pipeline can remove each source file as soon as its
+ * copy is complete, so that the extra space used stays within the files in flight, and the source
+ * directories once emptied. Hidden files are then moved too, and the subtrees already on the
+ * file system of the destination are renamed.
+ */
+class CopyPipeline
+{
+public:
+    enum DeviceType {
+        RotationalDevice,
+        SolidStateDevice,
+        MemoryDevice,
+        RemoteDevice
+    };
+
+    enum Backend {
+        ThreadedBackend,
+        UringBackend
+    };
+
+    typedef std::function<void(const QString &)> FileFunc;
+
+    CopyPipeline(const QString &srcDirectory, const QString &destDirectory);
+    ~CopyPipeline();
+
+    // the number of files copied at once, by default chosen by the destination device
+    int concurrency() const { return m_concurrency; }
+    void setConcurrency(int concurrency);
+
+    // by default io_uring where the kernel supports it, otherwise the threads
+    Backend backend() const { return m_backend; }
+    void setBackend(Backend backend);
+
+    // turns the copy into a move
+    bool removesSources() const { return m_removeSources; }
+    void setRemoveSources(bool remove);
+
+    // called from the copying threads, fileStarted and fileCopied with the source path
+    void setProgressFuncs(const FileFunc &fileStarted, const FileOperations::BytesFunc &copied,
+                          const FileFunc &fileCopied);
+
+    // continueOperation is only called from the calling thread
+    bool run(const FileOperations::ContinueFunc &continueOperation = FileOperations::ContinueFunc());
+
+    static DeviceType deviceType(const QString &path);
+    static DeviceType deviceType(int fd);
+    static int defaultConcurrency(DeviceType type);
+    static void setDefaultConcurrency(DeviceType type, int concurrency);
+
+    // removes source once target is found to be a complete copy of it, and is on the disk
+    static bool removeCopied(const QString &source, const QString &target);
+
+private:
+    Q_DISABLE_COPY(CopyPipeline)
+
+    class Worker;
+
+    struct Job
+    {
+        QString source;
+        QString target;
+        bool link;
+    };
+
+    bool walk(const QString &srcDirectory, const QString &destDirectory,
+              const FileOperations::ContinueFunc &continueOperation);
+    bool enqueue(const Job &job, const FileOperations::ContinueFunc &continueOperation);
+    void stop();
+    void fail();
+    bool takeJobs(QVector<Job> *jobs, int maximum);
+    bool copy(const Job &job);
+    bool fileCopied(const QString &source);
+    bool removeSourceDirectories();
+    void work();
+    void applyMetadata();
+
+    const QString m_srcDirectory;
+    const QString m_destDirectory;
+    int m_concurrency;
+    Backend m_backend;
+    bool m_removeSources;
+    dev_t m_destDevice;
+    FileFunc m_fileStarted;
+    FileOperations::BytesFunc m_copied;
+    FileFunc m_fileCopied;
+
+    QMutex m_mutex;
+    QWaitCondition m_jobAvailable;
+    QWaitCondition m_spaceAvailable;
+    QQueue<Job> m_jobs;
+    bool m_walkDone;
+    bool m_stopped;
+    bool m_failed;
+    // the directories created, with the permissions to give them once filled
+    QVector<QPair<QByteArray, mode_t> > m_directories;
+    // the source directories walked, to remove once emptied
+    QVector<QByteArray> m_sourceDirectories;
+    QThreadPool m_pool;
+};
+
+#endif // COPYPIPELINE_H
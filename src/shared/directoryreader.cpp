@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "directoryreader.h"
+
+#include <QFile>
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+DirectoryReader::DirectoryReader(const QString &path)
+    : m_dir(nullptr)
+    , m_fd(-1)
+{
+    open(AT_FDCWD, QFile::encodeName(path).constData(), 0);
+}
+
+DirectoryReader::DirectoryReader(int parentFd, const char *name)
+    : m_dir(nullptr)
+    , m_fd(-1)
+{
+    open(parentFd, name, O_NOFOLLOW);
+}
+
+DirectoryReader::~DirectoryReader()
+{
+    if (m_dir) {
+        // closes m_fd as well
+        closedir(m_dir);
+    }
+}
+
+void DirectoryReader::open(int dirFd, const char *name, int flags)
+{
+    int fd = openat(dirFd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | flags);
+    if (fd < 0) {
+        return;
+    }
+
+    m_dir = fdopendir(fd);
+    if (m_dir) {
+        m_fd = fd;
+    } else {
+        close(fd);
+    }
+}
+
+const struct dirent64 *DirectoryReader::next()
+{
+    if (!m_dir) {
+        return nullptr;
+    }
+
+    while (const struct dirent64 *entry = readdir64(m_dir)) {
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        return entry;
+    }
+    return nullptr;
+}
+
+unsigned char DirectoryReader::entryType(int dirFd, const struct dirent64 *entry)
+{
+    if (entry->d_type != DT_UNKNOWN) {
+        return entry->d_type;
+    }
+
+    struct stat64 st;
+    if (fstatat64(dirFd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return DT_UNKNOWN;
+    }
+    return IFTODT(st.st_mode);
+}
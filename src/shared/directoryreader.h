@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef DIRECTORYREADER_H
+#define DIRECTORYREADER_H
+
+#include <QString>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+/**
+ * @brief The DirectoryReader class iterates the entries of a directory using a directory file
+ * descriptor, so that the entries can be inspected and opened with the *at() family of calls
+ * without building full path strings.
+ */
+class DirectoryReader
+{
+public:
+    explicit DirectoryReader(const QString &path);
+    // opens a subdirectory of an already open directory without following symlinks
+    DirectoryReader(int parentFd, const char *name);
+    ~DirectoryReader();
+
+    bool isValid() const { return m_dir != nullptr; }
+    int fd() const { return m_fd; }
+
+    // returns the next entry other than . and .., or nullptr when the directory is exhausted
+    const struct dirent64 *next();
+
+    // the type of an entry, falling back to fstatat() if the file system doesn't report it
+    static unsigned char entryType(int dirFd, const struct dirent64 *entry);
+
+private:
+    Q_DISABLE_COPY(DirectoryReader)
+
+    void open(int dirFd, const char *name, int flags);
+
+    DIR *m_dir;
+    int m_fd;
+};
+
+#endif // DIRECTORYREADER_H
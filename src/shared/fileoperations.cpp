@@ -33,32 +33,519 @@
 
 #include "fileoperations.h"
 
+#include "copypipeline.h"
+#include "trash.h"
+#include "treeremover.h"
+#include "treescanner.h"
+#include "uringengine.h"
+
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QMutex>
+#include <QScopedPointer>
+#include <QVector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// the most asked from the kernel at a time, small enough for the progress to move smoothly
+const size_t CopyChunkSize = 8 * 1024 * 1024;
+
+// files from this size on are kept from filling the page cache
+const qint64 LargeFileSize = 32 * 1024 * 1024;
+// the data written behind the copy is flushed and dropped in windows of this size
+const qint64 WriteBehindWindow = 8 * 1024 * 1024;
+
+// the alignment O_DIRECT needs for buffers, lengths and offsets on any device
+const size_t DirectAlignment = 4096;
+
+// the least time between progress reports
+const qint64 ProgressInterval = 250;
+
+enum CopyResult {
+    CopyDone,
+    CopyFailed,
+    CopyUnsupported // the next method continues from where this one stopped
+};
+
+bool isUnsupported(int error)
+{
+    switch (error) {
+    case ENOSYS:
+    case EXDEV:
+    case EINVAL:
+    case EOPNOTSUPP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// calls copy() until the end of the file, size tells if a file reported empty is not really
+template <typename Copy>
+CopyResult copyChunks(qint64 size, const FileOperations::BytesFunc &progress, Copy copy)
+{
+    bool copied = false;
+    for (;;) {
+        const ssize_t length = copy();
+        if (length > 0) {
+            copied = true;
+            if (progress)
+                progress(length);
+        } else if (length == 0) {
+            // e.g. the files of procfs and sysfs cannot be copied within the kernel
+            return !copied && size > 0 ? CopyUnsupported : CopyDone;
+        } else if (errno != EINTR) {
+            return isUnsupported(errno) ? CopyUnsupported : CopyFailed;
+        }
+    }
+}
+
+CopyResult cloneFile(int srcFd, int destFd)
+{
+#ifdef FICLONE
+    return ioctl(destFd, FICLONE, srcFd) == 0 ? CopyDone : CopyUnsupported;
+#else
+    Q_UNUSED(srcFd)
+    Q_UNUSED(destFd)
+    return CopyUnsupported;
+#endif
+}
+
+CopyResult copyFileRange(int srcFd, int destFd, qint64 size, const FileOperations::BytesFunc &progress)
+{
+#ifdef __NR_copy_file_range
+    // the file positions are used and advanced
+    return copyChunks(size, progress, [srcFd, destFd]() {
+        return ssize_t(syscall(__NR_copy_file_range, srcFd, nullptr, destFd, nullptr, CopyChunkSize, 0));
+    });
+#else
+    Q_UNUSED(srcFd)
+    Q_UNUSED(destFd)
+    Q_UNUSED(size)
+    Q_UNUSED(progress)
+    return CopyUnsupported;
+#endif
+}
+
+CopyResult sendFile(int srcFd, int destFd, qint64 size, const FileOperations::BytesFunc &progress)
+{
+    return copyChunks(size, progress, [srcFd, destFd]() {
+        return sendfile(destFd, srcFd, nullptr, CopyChunkSize);
+    });
+}
+
+// long sequential runs for disks, less for flash and for memory, which only gains from fewer calls
+size_t bufferSize(int destFd)
+{
+    switch (CopyPipeline::deviceType(destFd)) {
+    case CopyPipeline::RotationalDevice:
+        return 8 * 1024 * 1024;
+    case CopyPipeline::SolidStateDevice:
+        return 2 * 1024 * 1024;
+    default:
+        return 1024 * 1024;
+    }
+}
+
+// with direct, the files are switched to O_DIRECT for the copy, which the file system may refuse
+CopyResult readWrite(int srcFd, int destFd, const FileOperations::BytesFunc &progress, bool direct = false)
+{
+    const size_t size = bufferSize(destFd);
+    void *memory = nullptr;
+    if (posix_memalign(&memory, DirectAlignment, size) != 0)
+        return CopyFailed;
+    QScopedPointer<char, QScopedPointerPodDeleter> buffer(static_cast<char *>(memory));
+    char *data = buffer.data();
+
+    const int srcFlags = direct ? fcntl(srcFd, F_GETFL) : 0;
+    const int destFlags = direct ? fcntl(destFd, F_GETFL) : 0;
+    const off64_t srcStart = direct ? lseek64(srcFd, 0, SEEK_CUR) : 0;
+    const off64_t destStart = direct ? lseek64(destFd, 0, SEEK_CUR) : 0;
+    if (direct) {
+        if (srcFlags < 0 || destFlags < 0 || srcStart < 0 || destStart < 0
+                || srcStart % DirectAlignment != 0 || destStart % DirectAlignment != 0
+                || fcntl(srcFd, F_SETFL, srcFlags | O_DIRECT) != 0) {
+            return CopyUnsupported;
+        }
+        if (fcntl(destFd, F_SETFL, destFlags | O_DIRECT) != 0) {
+            fcntl(srcFd, F_SETFL, srcFlags);
+            return CopyUnsupported;
+        }
+    }
+
+    bool copied = false;
+    CopyResult result = CopyDone;
+    for (;;) {
+        const ssize_t length = read(srcFd, data, size);
+        if (length == 0)
+            break;
+        if (length < 0) {
+            if (errno == EINTR)
+                continue;
+            result = direct && !copied && errno == EINVAL ? CopyUnsupported : CopyFailed;
+            break;
+        }
+
+        // the tail of the file isn't a whole block
+        if (direct && length % DirectAlignment != 0)
+            fcntl(destFd, F_SETFL, destFlags);
+
+        for (ssize_t written = 0; written < length; ) {
+            const ssize_t rv = write(destFd, data + written, length - written);
+            if (rv < 0) {
+                if (errno == EINTR)
+                    continue;
+                result = direct && !copied && errno == EINVAL ? CopyUnsupported : CopyFailed;
+                break;
+            }
+            written += rv;
+        }
+        if (result != CopyDone)
+            break;
+
+        copied = true;
+        if (progress)
+            progress(length);
+    }
+
+    if (direct) {
+        fcntl(srcFd, F_SETFL, srcFlags);
+        fcntl(destFd, F_SETFL, destFlags);
+        // the next method continues from where this one started
+        if (result == CopyUnsupported) {
+            lseek64(srcFd, srcStart, SEEK_SET);
+            lseek64(destFd, destStart, SEEK_SET);
+        }
+    }
+
+    return result;
+}
+
+// copies the data segments of a file with holes, at the same offsets, and leaves the holes out so
+// that the destination gets the same ones. The holes count as copied for the progress. Either
+// copy_file_range() or a buffer is used, the file positions are neither used nor changed.
+CopyResult copySparse(int srcFd, int destFd, qint64 size, const FileOperations::BytesFunc &progress, bool inKernel)
+{
+#ifndef __NR_copy_file_range
+    if (inKernel)
+        return CopyUnsupported;
+#endif
+
+    QScopedPointer<char, QScopedPointerArrayDeleter<char> > buffer;
+    const size_t bufferLength = inKernel ? 0 : bufferSize(destFd);
+    if (!inKernel)
+        buffer.reset(new char[bufferLength]);
+
+    bool copied = false;
+    qint64 skipped = 0;
+    for (qint64 offset = 0; offset < size; ) {
+        off64_t data = lseek64(srcFd, offset, SEEK_DATA);
+        if (data < 0) {
+            // ENXIO when only a hole is left
+            if (errno != ENXIO)
+                return !copied && isUnsupported(errno) ? CopyUnsupported : CopyFailed;
+            data = size;
+        }
+        const off64_t hole = data < size ? lseek64(srcFd, data, SEEK_HOLE) : size;
+        if (hole < 0)
+            return CopyFailed;
+        const qint64 end = qMin<qint64>(hole, size);
+        skipped += data - offset;
+
+        for (qint64 position = data; position < end; ) {
+            const size_t wanted = size_t(qMin<qint64>(end - position, inKernel ? CopyChunkSize : bufferLength));
+            ssize_t length = 0;
+            if (inKernel) {
+#ifdef __NR_copy_file_range
+                loff_t in = position;
+                loff_t out = position;
+                length = ssize_t(syscall(__NR_copy_file_range, srcFd, &in, destFd, &out, wanted, 0));
+#endif
+            } else {
+                length = pread64(srcFd, buffer.data(), wanted, position);
+                for (ssize_t written = 0; length > 0 && written < length; ) {
+                    const ssize_t rv = pwrite64(destFd, buffer.data() + written, length - written, position + written);
+                    if (rv < 0 && errno != EINTR)
+                        return CopyFailed;
+                    written += qMax<ssize_t>(rv, 0);
+                }
+            }
+
+            if (length < 0) {
+                if (errno == EINTR)
+                    continue;
+                return !copied && isUnsupported(errno) ? CopyUnsupported : CopyFailed;
+            }
+            // the file was truncated meanwhile
+            if (length == 0)
+                break;
+
+            copied = true;
+            position += length;
+            if (progress)
+                progress(skipped + length);
+            skipped = 0;
+        }
+        offset = end;
+    }
+
+    // holes at the end of the file
+    if (ftruncate64(destFd, size) != 0)
+        return CopyFailed;
+    if (skipped > 0 && progress)
+        progress(skipped);
+    return CopyDone;
+}
+
+// keeps a large copy from pushing everything else out of the page cache: the written data is
+// flushed a window behind the copy, and once on the disk dropped from the cache of both files
+class WriteBehind
+{
+public:
+    WriteBehind(int srcFd, int destFd)
+        : m_srcFd(srcFd)
+        , m_destFd(destFd)
+        , m_written(lseek64(destFd, 0, SEEK_CUR))
+        , m_flushed(m_written)
+    {
+    }
+
+    void advance(qint64 bytes)
+    {
+        m_written += bytes;
+        while (m_written - m_flushed >= WriteBehindWindow) {
+            // start writing the newest window, and wait for the one before to be written
+            sync_file_range(m_destFd, m_flushed, WriteBehindWindow, SYNC_FILE_RANGE_WRITE);
+            if (m_flushed >= WriteBehindWindow) {
+                const qint64 previous = m_flushed - WriteBehindWindow;
+                sync_file_range(m_destFd, previous, WriteBehindWindow,
+                                SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+                posix_fadvise(m_destFd, previous, WriteBehindWindow, POSIX_FADV_DONTNEED);
+                posix_fadvise(m_srcFd, previous, WriteBehindWindow, POSIX_FADV_DONTNEED);
+            }
+            m_flushed += WriteBehindWindow;
+        }
+    }
+
+    // the tail is left to the normal writeback, only the source is dropped entirely
+    void finish()
+    {
+        sync_file_range(m_destFd, m_flushed, 0, SYNC_FILE_RANGE_WRITE);
+        posix_fadvise(m_srcFd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+private:
+    const int m_srcFd;
+    const int m_destFd;
+    qint64 m_written;
+    qint64 m_flushed;
+};
+
+// throttles the progress reports of an operation, and estimates the time remaining
+// reports from any thread, copied directories report from several at once
+class ProgressReporter
+{
+public:
+    explicit ProgressReporter(const FileOperations::ProgressFunc &report)
+        : m_report(report)
+        , m_scanner(nullptr)
+        , m_scannerBytes(true)
+        , m_bytesTotal(0)
+        , m_filesTotal(0)
+        , m_reportedTime(0)
+        , m_reportedBytes(0)
+        , m_rate(0)
+        , m_finished(false)
+    {
+        m_clock.start();
+    }
+
+    // the totals are taken from the scanner while it runs, added to any set, the bytes only if
+    // the operation goes by them
+    void setScanner(const TreeScanner *scanner, bool bytes = true)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_scanner = scanner;
+        m_scannerBytes = bytes;
+        report(true);
+    }
+
+    void setTotals(qint64 bytes, int files)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_bytesTotal = bytes;
+        m_filesTotal = files;
+        m_progress.bytesTotal = bytes;
+        m_progress.filesTotal = files;
+        report(true);
+    }
+
+    void setCurrentPath(const QString &path)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_progress.currentPath = path;
+        report(false);
+    }
+
+    void addBytes(qint64 bytes)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_progress.bytesDone += bytes;
+        report(false);
+    }
+
+    void addFiles(int files, qint64 bytes = 0)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_progress.filesDone += files;
+        m_progress.bytesDone += bytes;
+        report(false);
+    }
+
+    void finish()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_progress.currentPath.clear();
+        m_finished = true;
+        report(true);
+    }
+
+    qint64 bytesDone() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_progress.bytesDone;
+    }
+
+    FileOperations::BytesFunc bytesFunc()
+    {
+        return [this](qint64 bytes) { addBytes(bytes); };
+    }
+
+private:
+    void report(bool force)
+    {
+        if (!m_report)
+            return;
+
+        const qint64 now = m_clock.elapsed();
+        if (!force && now - m_reportedTime < ProgressInterval)
+            return;
+
+        bool estimated = true;
+        if (m_scanner) {
+            const TreeScanner::Totals totals = m_scanner->totals();
+            estimated = m_scanner->isFinished();
+            // the scan may lag behind the operation
+            m_progress.bytesTotal = qMax(m_bytesTotal + (m_scannerBytes ? totals.bytes : 0), m_progress.bytesDone);
+            m_progress.filesTotal = qMax(m_filesTotal + totals.files, m_progress.filesDone);
+        }
+
+        if (now > m_reportedTime) {
+            m_progress.bytesPerSecond = (m_progress.bytesDone - m_reportedBytes) * 1000 / (now - m_reportedTime);
+            // smoothed, so that the estimate doesn't jump between small and large files
+            m_rate = m_rate > 0 ? m_rate * 0.7 + m_progress.bytesPerSecond * 0.3 : m_progress.bytesPerSecond;
+        }
+        if (m_finished) {
+            m_progress.secondsRemaining = 0;
+        } else if (estimated && m_rate > 0) {
+            m_progress.secondsRemaining = qint64((m_progress.bytesTotal - m_progress.bytesDone) / m_rate);
+        } else {
+            m_progress.secondsRemaining = -1;
+        }
+
+        m_reportedTime = now;
+        m_reportedBytes = m_progress.bytesDone;
+        m_report(m_progress);
+    }
+
+    mutable QMutex m_mutex;
+    FileOperations::ProgressFunc m_report;
+    FileOperations::Progress m_progress;
+    const TreeScanner *m_scanner;
+    bool m_scannerBytes;
+    qint64 m_bytesTotal;
+    int m_filesTotal;
+    QElapsedTimer m_clock;
+    qint64 m_reportedTime;
+    qint64 m_reportedBytes;
+    double m_rate; // bytes per second
+    bool m_finished;
+};
+
+// whether the file system of the directory has room for the bytes
+bool hasSpace(const QString &directory, qint64 bytes)
+{
+    struct statvfs64 st;
+    if (statvfs64(QFile::encodeName(directory).constData(), &st) != 0)
+        return true;
+    return qint64(st.f_bavail) * qint64(st.f_frsize) >= bytes;
+}
+
+// goes on while continueOperation does and, once the scan is done, the destination has room
+FileOperations::ContinueFunc checkingSpace(const FileOperations::ContinueFunc &continueOperation,
+                                           const QString &destination, const TreeScanner &scanner,
+                                           const ProgressReporter &progress, bool *outOfSpace)
+{
+    bool checked = false;
+    return [=, &scanner, &progress]() mutable -> bool {
+        if (continueOperation && !continueOperation())
+            return false;
+        if (!checked && scanner.isFinished()) {
+            checked = true;
+            *outOfSpace = !hasSpace(destination, scanner.totals().bytes - progress.bytesDone());
+        }
+        return !*outOfSpace;
+    };
+}
+
+
+}
 
 
-bool FileOperations::deleteFile(const QString &path)
+bool FileOperations::deleteFile(const QString &path, PathResultFunc removed, ContinueFunc continueOperation)
 {
     QFileInfo info(path);
     if (!info.exists() && !info.isSymLink()) {
         return false;
     }
-    if (info.isDir() && info.isSymLink()) {
-        // only delete the link and do not remove recursively subfolders
-        QFile file(info.absoluteFilePath());
-        return file.remove();
-    } else if (info.isDir()) {
-        // this should be custom function to get better error reporting
-        return QDir(info.absoluteFilePath()).removeRecursively();
-    } else {
-        QFile file(info.absoluteFilePath());
-        return file.remove();
+    if (info.isDir() && !info.isSymLink()) {
+        if (UringEngine::isAvailable()) {
+            UringEngine engine;
+            if (engine.removeTree(info.absoluteFilePath(), removed, continueOperation))
+                return true;
+            if (continueOperation && !continueOperation())
+                return false;
+        }
+        // whatever the ring left
+        return TreeRemover(info.absoluteFilePath(), removed).run(continueOperation);
     }
-    return true;
+
+    // only delete the link and do not remove recursively subfolders
+    QFile file(info.absoluteFilePath());
+    const bool ok = file.remove();
+    if (removed)
+        removed(path, ok);
+    return ok;
 }
 
-bool FileOperations::copyOverwrite(const QString &src, const QString &dest)
+bool FileOperations::copyOverwrite(const QString &src, const QString &dest, CopyMethod *method, BytesFunc copied,
+                                   CopyMethod preferred)
 {
+    if (method)
+        *method = NoCopy;
+
     // delete destination if it exists
     QFile dfile(dest);
     if (dfile.exists() && !dfile.remove()) {
@@ -72,80 +559,145 @@ bool FileOperations::copyOverwrite(const QString &src, const QString &dest)
         return targetFile.link(dest);
     }
 
-    // normal file copy
-    QFile sfile(src);
-    return sfile.copy(dest);
-}
+    // normal file copy, the permissions are set once the data is in place
+    const QByteArray destName = QFile::encodeName(dest);
+    const int srcFd = open(QFile::encodeName(src).constData(), O_RDONLY | O_CLOEXEC);
+    if (srcFd < 0)
+        return false;
 
-bool FileOperations::copyDirRecursively(const QString &srcDirectory, const QString &destDirectory, ContinueFunc continueOperation)
-{
-    QFileInfo srcInfo(srcDirectory);
-    if (srcInfo.isSymLink()) {
-        // copy dir symlink by creating a new link
-        QFile targetFile(srcInfo.symLinkTarget());
-        if (!targetFile.link(destDirectory)) {
-            return false;
-        }
+    struct stat64 st;
+    int destFd = -1;
+    if (fstat64(srcFd, &st) == 0)
+        destFd = open(destName.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+
+    bool ok = destFd >= 0
+            && copyData(srcFd, destFd, method, preferred, copied)
+            && fchmod(destFd, st.st_mode & 07777) == 0;
+
+    if (destFd >= 0) {
+        if (close(destFd) != 0)
+            ok = false;
+        if (!ok)
+            unlink(destName.constData());
     }
+    close(srcFd);
+
+    return ok;
+}
 
-    QDir srcDir(srcDirectory);
-    if (!srcDir.exists()) {
+bool FileOperations::copyData(int srcFd, int destFd, CopyMethod *method, CopyMethod preferred, BytesFunc copied)
+{
+    struct stat64 st;
+    if (fstat64(srcFd, &st) != 0)
         return false;
-    }
 
-    QDir destDir(destDirectory);
-    if (!destDir.exists()) {
-        QDir d(destDir);
-        d.cdUp();
-        if (!d.mkdir(destDir.dirName())) {
-            return false;
+    posix_fadvise(srcFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // fewer blocks than the size takes, only the data is copied and the holes are recreated
+    const bool sparse = S_ISREG(st.st_mode) && st.st_blocks * 512 < st.st_size
+            && lseek64(srcFd, 0, SEEK_CUR) == 0 && lseek64(destFd, 0, SEEK_CUR) == 0;
+
+    if (preferred == DirectCopy) {
+        if (!sparse) {
+            if (method)
+                *method = DirectCopy;
+            const CopyResult result = readWrite(srcFd, destFd, copied, true);
+            if (result != CopyUnsupported)
+                return result == CopyDone;
         }
+        preferred = ReadWriteCopy;
     }
 
-    // copy files
-    QStringList names = srcDir.entryList(QDir::Files);
-    for (int i = 0 ; i < names.count() ; ++i) {
-        // stop if cancelled
-        if (continueOperation && !continueOperation()) {
-            return false;
+    // a clone shares the data, everything else goes through the page cache
+    QScopedPointer<WriteBehind> writeBehind;
+    BytesFunc progress = copied;
+    if (st.st_size >= LargeFileSize) {
+        writeBehind.reset(new WriteBehind(srcFd, destFd));
+        WriteBehind *behind = writeBehind.data();
+        progress = [behind, copied](qint64 bytes) {
+            behind->advance(bytes);
+            if (copied)
+                copied(bytes);
+        };
+    }
+
+    for (int i = qMax<int>(preferred, CloneCopy); i <= ReadWriteCopy; ++i) {
+        if (method)
+            *method = CopyMethod(i);
+
+        CopyResult result = CopyUnsupported;
+        switch (i) {
+        case CloneCopy:
+            result = cloneFile(srcFd, destFd);
+            if (result == CopyDone && copied)
+                copied(st.st_size);
+            break;
+        case CopyFileRange:
+            result = sparse ? copySparse(srcFd, destFd, st.st_size, progress, true)
+                            : copyFileRange(srcFd, destFd, st.st_size, progress);
+            break;
+        case SendFileCopy:
+            // sendfile() has no way to skip the holes
+            if (!sparse)
+                result = sendFile(srcFd, destFd, st.st_size, progress);
+            break;
+        case ReadWriteCopy:
+            result = sparse ? copySparse(srcFd, destFd, st.st_size, progress, false)
+                            : readWrite(srcFd, destFd, progress);
+            break;
         }
 
-        const QString fileName = names.at(i);
-        const QString spath = srcDir.absoluteFilePath(fileName);
-        const QString dpath = destDir.absoluteFilePath(fileName);
-        if (!copyOverwrite(spath, dpath)) {
-            return false;
+        if (result != CopyUnsupported) {
+            if (writeBehind && i != CloneCopy)
+                writeBehind->finish();
+            return result == CopyDone;
         }
     }
 
-    // copy dirs
-    names = srcDir.entryList(QDir::NoDotAndDotDot | QDir::AllDirs);
-    for (int i = 0 ; i < names.count() ; ++i) {
-        // stop if cancelled
-        if (continueOperation && !continueOperation()) {
-            return false;
-        }
+    return false;
+}
 
-        const QString fileName = names.at(i);
-        const QString spath = srcDir.absoluteFilePath(fileName);
-        const QString dpath = destDir.absoluteFilePath(fileName);
-        if (!copyDirRecursively(spath, dpath, continueOperation)) {
-            return false;
-        }
+namespace {
+
+bool copyTree(const QString &srcDirectory, const QString &destDirectory,
+              const FileOperations::ContinueFunc &continueOperation, ProgressReporter *progress,
+              bool move = false)
+{
+    CopyPipeline pipeline(srcDirectory, destDirectory);
+    pipeline.setRemoveSources(move);
+    if (progress) {
+        pipeline.setProgressFuncs([progress](const QString &path) { progress->setCurrentPath(path); },
+                                  progress->bytesFunc(),
+                                  [progress](const QString &) { progress->addFiles(1); });
     }
+    return pipeline.run(continueOperation);
+}
 
-    return true;
 }
 
-FileEngine::Error FileOperations::copyFiles(const QStringList &paths, const QString &destination, PathResultFunc pathResult, ContinueFunc continueOperation)
+bool FileOperations::copyDirRecursively(const QString &srcDirectory, const QString &destDirectory, ContinueFunc continueOperation)
+{
+    return copyTree(srcDirectory, destDirectory, continueOperation, nullptr);
+}
+
+FileEngine::Error FileOperations::copyFiles(const QStringList &paths, const QString &destination, PathResultFunc pathResult, ContinueFunc continueOperation, ProgressFunc progressFunc)
 {
     FileEngine::Error rv = FileEngine::NoError;
 
     QDir destDir(destination);
 
+    // the totals are counted while the copy already goes on
+    TreeScanner scanner(paths);
+    scanner.start();
+    ProgressReporter progress(progressFunc);
+    progress.setScanner(&scanner);
+
+    bool outOfSpace = false;
+    const ContinueFunc proceed = checkingSpace(continueOperation, destination, scanner, progress, &outOfSpace);
+
     QStringList::const_iterator it = paths.cbegin(), end = paths.cend();
     for ( ; it != end; ++it) {
-        if (!continueOperation || continueOperation()) {
+        if (proceed()) {
             const QString &path(*it);
 
             QFileInfo fileInfo(path);
@@ -154,20 +706,29 @@ FileEngine::Error FileOperations::copyFiles(const QStringList &paths, const QStr
             // move or copy and stop if errors
             QFile file(path);
             if (fileInfo.isDir()) {
-                if (!copyDirRecursively(path, newName, continueOperation)) {
-                    rv = FileEngine::ErrorFolderCopyFailed;
+                if (!copyTree(path, newName, proceed, &progress)) {
+                    rv = outOfSpace ? FileEngine::ErrorNotEnoughSpace : FileEngine::ErrorFolderCopyFailed;
                     break;
                 }
-            } else if (!copyOverwrite(path, newName)) {
-                rv = FileEngine::ErrorCopyFailed;
-                break;
+            } else {
+                progress.setCurrentPath(path);
+                if (!copyOverwrite(path, newName, nullptr, progress.bytesFunc())) {
+                    rv = FileEngine::ErrorCopyFailed;
+                    break;
+                }
+                progress.addFiles(1);
             }
 
             if (pathResult)
                 pathResult(path, true);
+        } else if (outOfSpace) {
+            rv = FileEngine::ErrorNotEnoughSpace;
+            break;
         }
     }
 
+    progress.finish();
+
     // Report any unprocessed paths as failed
     if (pathResult)
         std::for_each(it, end, [&pathResult](const QString &path) { pathResult(path, false); });
@@ -175,15 +736,39 @@ FileEngine::Error FileOperations::copyFiles(const QStringList &paths, const QStr
     return rv;
 }
 
-FileEngine::Error FileOperations::moveFiles(const QStringList &paths, const QString &destination, PathResultFunc pathResult, ContinueFunc continueOperation)
+FileEngine::Error FileOperations::moveFiles(const QStringList &paths, const QString &destination, PathResultFunc pathResult, ContinueFunc continueOperation, ProgressFunc progressFunc)
 {
     FileEngine::Error rv = FileEngine::NoError;
 
     QDir destDir(destination);
 
+    // the paths on another file system are copied, removing each file once its copy is complete
+    struct stat64 destStat;
+    const bool destFound = stat64(QFile::encodeName(destination).constData(), &destStat) == 0;
+    QVector<bool> crossDevice;
+    QStringList copiedPaths;
+    foreach (const QString &path, paths) {
+        struct stat64 st;
+        const bool copied = destFound && lstat64(QFile::encodeName(path).constData(), &st) == 0
+                && !S_ISLNK(st.st_mode) && st.st_dev != destStat.st_dev;
+        crossDevice.append(copied);
+        if (copied)
+            copiedPaths.append(path);
+    }
+
+    // renames are instant and count as one file, the copies by what they contain
+    TreeScanner scanner(copiedPaths, true);
+    scanner.start();
+    ProgressReporter progress(progressFunc);
+    progress.setTotals(0, paths.count() - copiedPaths.count());
+    progress.setScanner(&scanner);
+
+    bool outOfSpace = false;
+    const ContinueFunc proceed = checkingSpace(continueOperation, destination, scanner, progress, &outOfSpace);
+
     QStringList::const_iterator it = paths.cbegin(), end = paths.cend();
     for ( ; it != end; ++it) {
-        if (!continueOperation || continueOperation()) {
+        if (proceed()) {
             const QString &path(*it);
 
             QFileInfo fileInfo(path);
@@ -202,16 +787,40 @@ FileEngine::Error FileOperations::moveFiles(const QStringList &paths, const QStr
                     rv = FileEngine::ErrorMoveFailed;
                     break;
                 }
+                progress.setCurrentPath(path);
+                progress.addFiles(1);
+            } else if (crossDevice.at(it - paths.cbegin())) {
+                bool moved;
+                if (fileInfo.isDir()) {
+                    moved = copyTree(path, newName, proceed, &progress, true);
+                } else {
+                    progress.setCurrentPath(path);
+                    moved = copyOverwrite(path, newName, nullptr, progress.bytesFunc())
+                            && CopyPipeline::removeCopied(path, newName);
+                    progress.addFiles(1);
+                }
+                if (!moved) {
+                    rv = outOfSpace ? FileEngine::ErrorNotEnoughSpace : FileEngine::ErrorMoveFailed;
+                    break;
+                }
             } else if (!file.rename(newName)) {
                 rv = FileEngine::ErrorMoveFailed;
                 break;
+            } else {
+                progress.setCurrentPath(path);
+                progress.addFiles(1);
             }
 
             if (pathResult)
                 pathResult(path, true);
+        } else if (outOfSpace) {
+            rv = FileEngine::ErrorNotEnoughSpace;
+            break;
         }
     }
 
+    progress.finish();
+
     // Report any unprocessed paths as failed
     if (pathResult)
         std::for_each(it, end, [&pathResult](const QString &path) { pathResult(path, false); });
@@ -219,16 +828,60 @@ FileEngine::Error FileOperations::moveFiles(const QStringList &paths, const QStr
     return rv;
 }
 
-FileEngine::Error FileOperations::deleteFiles(const QStringList &paths, PathResultFunc pathResult, ContinueFunc continueOperation)
+FileEngine::Error FileOperations::deleteFiles(const QStringList &paths, PathResultFunc pathResult, ContinueFunc continueOperation, ProgressFunc progressFunc,
+                                              FileEngine::DeletePolicy policy)
 {
     FileEngine::Error rv = FileEngine::NoError;
+    const bool permanent = policy == FileEngine::DeletePermanently;
+
+    // the files are counted while they are removed, and there are no bytes to speak of
+    QScopedPointer<TreeScanner> scanner;
+    QScopedPointer<ProgressReporter> progress;
+    PathResultFunc removed;
+    if (progressFunc) {
+        progress.reset(new ProgressReporter(progressFunc));
+        if (permanent) {
+            scanner.reset(new TreeScanner(paths, true));
+            scanner->start();
+            progress->setScanner(scanner.data(), false);
+            ProgressReporter *reporter = progress.data();
+            removed = [reporter](const QString &, bool ok) {
+                if (ok)
+                    reporter->addFiles(1);
+            };
+        } else {
+            // a rename each, however many files there are within
+            progress->setTotals(0, paths.count());
+        }
+    }
 
+    QStringList trashed;
     QStringList::const_iterator it = paths.cbegin(), end = paths.cend();
     for ( ; it != end; ++it) {
         if (!continueOperation || continueOperation()) {
             // delete file and stop if errors
             const QString &path(*it);
-            if (deleteFile(path)) {
+            if (progress)
+                progress->setCurrentPath(path);
+
+            bool deleted;
+            if (permanent) {
+                deleted = deleteFile(path, removed, continueOperation);
+            } else {
+                const QString trashedPath = Trash::moveToTrash(path);
+                if (!trashedPath.isEmpty()) {
+                    if (policy == FileEngine::DeleteInBackground)
+                        trashed.append(trashedPath);
+                    deleted = true;
+                } else {
+                    // e.g. no trash could be made on its file system
+                    deleted = policy == FileEngine::DeleteInBackground && deleteFile(path, removed, continueOperation);
+                }
+                if (deleted && progress)
+                    progress->addFiles(1);
+            }
+
+            if (deleted) {
                 if (pathResult)
                     pathResult(path, true);
             } else {
@@ -238,6 +891,35 @@ FileEngine::Error FileOperations::deleteFiles(const QStringList &paths, PathResu
         }
     }
 
+    if (!trashed.isEmpty())
+        Trash::purge(trashed);
+
+    if (progress)
+        progress->finish();
+
+    // Report any unprocessed paths as failed
+    if (pathResult)
+        std::for_each(it, end, [&pathResult](const QString &path) { pathResult(path, false); });
+
+    return rv;
+}
+
+FileEngine::Error FileOperations::restoreFiles(const QStringList &paths, PathResultFunc pathResult)
+{
+    FileEngine::Error rv = FileEngine::NoError;
+
+    QStringList::const_iterator it = paths.cbegin(), end = paths.cend();
+    for ( ; it != end; ++it) {
+        const QString &path(*it);
+        const QString trashedPath = Trash::trashedPath(path);
+        if (trashedPath.isEmpty() || !Trash::restore(trashedPath)) {
+            rv = FileEngine::ErrorRestoreFailed;
+            break;
+        }
+        if (pathResult)
+            pathResult(path, true);
+    }
+
     // Report any unprocessed paths as failed
     if (pathResult)
         std::for_each(it, end, [&pathResult](const QString &path) { pathResult(path, false); });
@@ -34,6 +34,7 @@
 #define FILEOPERATIONS_H
 
 #include <QFileDevice>
+#include <QMetaType>
 #include <QString>
 #include <QStringList>
 
@@ -45,20 +46,65 @@ struct FileOperations
 {
     typedef std::function<bool()> ContinueFunc;
     typedef std::function<void(const QString &, bool)> PathResultFunc;
+    // the number of bytes copied since the previous call
+    typedef std::function<void(qint64)> BytesFunc;
+
+    struct Progress
+    {
+        Progress() : bytesDone(0), bytesTotal(0), filesDone(0), filesTotal(0), bytesPerSecond(0), secondsRemaining(-1) {}
+
+        qint64 bytesDone;
+        // the totals of a copy grow until the files to copy have been counted
+        qint64 bytesTotal;
+        int filesDone;
+        int filesTotal;
+        QString currentPath;
+        qint64 bytesPerSecond; // over the time since the previous report
+        qint64 secondsRemaining; // -1 until the totals are known
+    };
+    // called a few times a second at most, and once more when the operation ends
+    typedef std::function<void(const Progress &)> ProgressFunc;
+
+    // the ways of copying the data of a file, from the cheapest to the most expensive
+    enum CopyMethod {
+        NoCopy,
+        CloneCopy, // FICLONE, the copy shares the data until either file is modified
+        CopyFileRange, // copy_file_range(), which the file system or the storage may offload
+        SendFileCopy, // sendfile(), copies within the kernel
+        ReadWriteCopy, // through a userspace buffer
+        DirectCopy // read/write with O_DIRECT, bypassing the page cache, only tried when preferred
+    };
 
     FileOperations() = delete;
     FileOperations(const FileOperations &) = delete;
 
-    static bool deleteFile(const QString &path);
-    static bool copyOverwrite(const QString &src, const QString &dest);
+    // removed is called for every file within a directory as it goes, possibly from other threads
+    static bool deleteFile(const QString &path, PathResultFunc removed = PathResultFunc(),
+                           ContinueFunc continueOperation = ContinueFunc());
+    // the method that copied the data, or the last one tried, is returned in method
+    static bool copyOverwrite(const QString &src, const QString &dest, CopyMethod *method = nullptr,
+                              BytesFunc copied = BytesFunc(), CopyMethod preferred = CloneCopy);
+    // copies the data of a file opened for reading to an empty file opened for writing, trying the
+    // methods from preferred on until one works for the pair of files, DirectCopy falls back to
+    // ReadWriteCopy. Large files are flushed as they are copied and dropped from the page cache.
+    // Only the data of sparse files is copied, the holes are recreated in the destination.
+    static bool copyData(int srcFd, int destFd, CopyMethod *method = nullptr, CopyMethod preferred = CloneCopy,
+                         BytesFunc copied = BytesFunc());
     static bool copyDirRecursively(const QString &srcDirectory, const QString &destDirectory, ContinueFunc continueOperation = ContinueFunc());
 
-    static FileEngine::Error copyFiles(const QStringList &paths, const QString &destination, PathResultFunc pathResult = PathResultFunc(), ContinueFunc continueOperation = ContinueFunc());
-    static FileEngine::Error moveFiles(const QStringList &paths, const QString &destination, PathResultFunc pathResult = PathResultFunc(), ContinueFunc continueOperation = ContinueFunc());
-    static FileEngine::Error deleteFiles(const QStringList &paths, PathResultFunc pathResult = PathResultFunc(), ContinueFunc continueOperation = ContinueFunc());
+    static FileEngine::Error copyFiles(const QStringList &paths, const QString &destination, PathResultFunc pathResult = PathResultFunc(), ContinueFunc continueOperation = ContinueFunc(), ProgressFunc progress = ProgressFunc());
+    static FileEngine::Error moveFiles(const QStringList &paths, const QString &destination, PathResultFunc pathResult = PathResultFunc(), ContinueFunc continueOperation = ContinueFunc(), ProgressFunc progress = ProgressFunc());
+    // unless DeletePermanently the paths are renamed into the trash, and with DeleteInBackground
+    // purged from there after returning, or deleted on the spot where they can't be trashed
+    static FileEngine::Error deleteFiles(const QStringList &paths, PathResultFunc pathResult = PathResultFunc(), ContinueFunc continueOperation = ContinueFunc(), ProgressFunc progress = ProgressFunc(),
+                                         FileEngine::DeletePolicy policy = FileEngine::DeletePermanently);
+    // moves trashed files back to paths, the most recently trashed one for each
+    static FileEngine::Error restoreFiles(const QStringList &paths, PathResultFunc pathResult = PathResultFunc());
     static FileEngine::Error createDirectory(const QString &path, const QString &directory, PathResultFunc pathResult = PathResultFunc());
     static FileEngine::Error renameFile(const QString &path, const QString &newPath, PathResultFunc pathResult = PathResultFunc());
     static FileEngine::Error chmodFile(const QString &path, QFileDevice::Permissions perm, PathResultFunc pathResult = PathResultFunc());
 };
 
+Q_DECLARE_METATYPE(FileOperations::Progress)
+
 #endif
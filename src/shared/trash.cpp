@@ -0,0 +1,396 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+
+#include "trash.h"
+#include "treeremover.h"
+
+#include <QAtomicInt>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QUrl>
+#include <QtDebug>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+const QString InfoSuffix = QStringLiteral(".trashinfo");
+
+// RENAME_NOREPLACE, missing from older headers
+const unsigned RenameNoReplace = 1;
+
+struct Location
+{
+    QString trash;
+    // the top directory of the file system, which the paths in the trash information are
+    // relative to, empty for the home trash where they are absolute
+    QString top;
+};
+
+bool statPath(const QString &path, struct stat64 *st)
+{
+    return lstat64(QFile::encodeName(path).constData(), st) == 0;
+}
+
+QString parentPath(const QString &path)
+{
+    const int slash = path.lastIndexOf(QLatin1Char('/'));
+    return slash > 0 ? path.left(slash) : QStringLiteral("/");
+}
+
+QString childPath(const QString &directory, const QString &name)
+{
+    if (directory == QLatin1String("/"))
+        return QLatin1Char('/') + name;
+    return directory + QLatin1Char('/') + name;
+}
+
+// creates a directory only the user can enter, or takes the one there unless it's a symbolic link
+bool ensureDirectory(const QString &path)
+{
+    const QByteArray name = QFile::encodeName(path);
+    if (mkdir(name.constData(), S_IRWXU) == 0)
+        return true;
+
+    struct stat64 st;
+    return errno == EEXIST && lstat64(name.constData(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool ensureTrash(const QString &trash, dev_t device, bool create)
+{
+    struct stat64 st;
+    if (!create) {
+        return statPath(trash + QStringLiteral("/info"), &st) && S_ISDIR(st.st_mode)
+                && statPath(trash + QStringLiteral("/files"), &st) && S_ISDIR(st.st_mode)
+                && st.st_dev == device;
+    }
+    return ensureDirectory(trash)
+            && ensureDirectory(trash + QStringLiteral("/files"))
+            && ensureDirectory(trash + QStringLiteral("/info"))
+            && statPath(trash + QStringLiteral("/files"), &st) && st.st_dev == device;
+}
+
+// the highest directory above path that is still on its file system
+QString topDirectory(const QString &path, dev_t device)
+{
+    QString top = path;
+    struct stat64 st;
+    while (top != QLatin1String("/")) {
+        const QString parent = parentPath(top);
+        if (!statPath(parent, &st) || st.st_dev != device)
+            break;
+        top = parent;
+    }
+    return top;
+}
+
+QString homeTrash()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/Trash");
+}
+
+// the trash for the file system of path, which is absolute and clean, without create only
+// if it is there already
+Location locate(const QString &path, bool create = true)
+{
+    struct stat64 st;
+    if (!statPath(path, &st))
+        return Location();
+    const dev_t device = st.st_dev;
+
+    // the data directory may well be a link elsewhere
+    const QString home = homeTrash();
+    if (create)
+        QDir().mkpath(parentPath(home));
+    if (stat64(QFile::encodeName(parentPath(home)).constData(), &st) == 0 && st.st_dev == device) {
+        if (ensureTrash(home, device, create))
+            return Location { home, QString() };
+        return Location();
+    }
+
+    const QString top = topDirectory(path, device);
+    const QString user = QString::number(getuid());
+
+    // set up by the administrator, sticky so that the users can't remove each other's trash
+    const QString shared = childPath(top, QStringLiteral(".Trash"));
+    if (statPath(shared, &st) && S_ISDIR(st.st_mode) && (st.st_mode & S_ISVTX)) {
+        const QString trash = shared + QLatin1Char('/') + user;
+        if (ensureTrash(trash, device, create))
+            return Location { trash, top };
+    }
+
+    const QString trash = childPath(top, QStringLiteral(".Trash-") + user);
+    if (ensureTrash(trash, device, create))
+        return Location { trash, top };
+    return Location();
+}
+
+QString infoPath(const QString &trashedPath)
+{
+    const QString files = parentPath(trashedPath);
+    return parentPath(files) + QStringLiteral("/info/") + trashedPath.mid(files.length() + 1) + InfoSuffix;
+}
+
+// the top directory a trash that isn't the home trash belongs to
+QString trashTop(const QString &trash)
+{
+    const QString parent = parentPath(trash);
+    if (QFileInfo(trash).fileName().startsWith(QStringLiteral(".Trash-")))
+        return parent;
+    if (QFileInfo(parent).fileName() == QLatin1String(".Trash"))
+        return parentPath(parent);
+    return QString();
+}
+
+bool readInfo(const QString &info, QString *original, QByteArray *deletionDate)
+{
+    QFile file(info);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray path;
+    bool group = false;
+    for (const QByteArray &line : file.readAll().split('\n')) {
+        if (line.startsWith('[')) {
+            group = line == "[Trash Info]";
+        } else if (group && line.startsWith("Path=")) {
+            path = QByteArray::fromPercentEncoding(line.mid(5));
+        } else if (group && line.startsWith("DeletionDate=") && deletionDate) {
+            *deletionDate = line.mid(13);
+        }
+    }
+    if (path.isEmpty())
+        return false;
+
+    *original = QFile::decodeName(path);
+    if (!original->startsWith(QLatin1Char('/'))) {
+        const QString top = trashTop(parentPath(parentPath(info)));
+        if (top.isEmpty())
+            return false;
+        *original = childPath(top, *original);
+    }
+    return true;
+}
+
+class Purger : public QRunnable
+{
+public:
+    Purger(const QStringList &paths, const QAtomicInt *stopping) : m_paths(paths), m_stopping(stopping) {}
+
+    void run() override
+    {
+        // the pool is only used for purging
+        TreeRemover::setIdlePriority();
+
+        const QAtomicInt *stopping = m_stopping;
+        const FileOperations::ContinueFunc continueOperation = [stopping]() { return !stopping->loadAcquire(); };
+        for (const QString &path : m_paths) {
+            if (!continueOperation())
+                return;
+
+            // the data goes first, an interrupted purge leaves an entry that can be purged again
+            TreeRemover remover(path);
+            remover.setIdle(true);
+            struct stat64 st;
+            if (!remover.run(continueOperation) && statPath(path, &st)) {
+                if (continueOperation())
+                    qWarning() << "Trash: cannot purge" << path;
+                continue;
+            }
+
+            unlink(QFile::encodeName(infoPath(path)).constData());
+        }
+    }
+
+private:
+    const QStringList m_paths;
+    const QAtomicInt *m_stopping;
+};
+
+// lets an application quit without waiting for the purge, the files not reached stay in the trash
+struct PurgeQueue
+{
+    PurgeQueue() { pool.setMaxThreadCount(1); }
+    ~PurgeQueue()
+    {
+        stopping.storeRelease(1);
+        pool.waitForDone();
+    }
+
+    QThreadPool pool;
+    QAtomicInt stopping;
+};
+
+}
+
+Q_GLOBAL_STATIC(PurgeQueue, purgeQueue)
+
+QString Trash::location(const QString &path)
+{
+    return locate(QDir::cleanPath(QFileInfo(path).absoluteFilePath())).trash;
+}
+
+QString Trash::existingLocation(const QString &path)
+{
+    return locate(QDir::cleanPath(QFileInfo(path).absoluteFilePath()), false).trash;
+}
+
+QString Trash::moveToTrash(const QString &path)
+{
+    const QString absolutePath = QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+    const QString directory = parentPath(absolutePath);
+
+    // a mount point can't be renamed away
+    struct stat64 st, parent;
+    if (!statPath(absolutePath, &st) || !statPath(directory, &parent) || st.st_dev != parent.st_dev)
+        return QString();
+
+    const Location location = locate(directory);
+    if (location.trash.isEmpty() || absolutePath == location.trash
+            || absolutePath.startsWith(location.trash + QLatin1Char('/'))) {
+        return QString();
+    }
+
+    const QString original = location.top.isEmpty()
+            ? absolutePath : absolutePath.mid(location.top == QLatin1String("/") ? 1 : location.top.length() + 1);
+    const QByteArray info = "[Trash Info]\nPath=" + QUrl::toPercentEncoding(original, "/")
+            + "\nDeletionDate=" + QDateTime::currentDateTime().toString(QStringLiteral("yyyy-MM-dd'T'hh:mm:ss")).toLatin1()
+            + '\n';
+
+    // the information file is created exclusively to claim the name in the trash
+    const QString name = QFileInfo(absolutePath).fileName();
+    QString trashedPath;
+    QByteArray infoName;
+    int fd = -1;
+    for (int i = 1; fd < 0; ++i) {
+        const QString candidate = i == 1 ? name : QStringLiteral("%1.%2").arg(name).arg(i);
+        trashedPath = location.trash + QStringLiteral("/files/") + candidate;
+        infoName = QFile::encodeName(location.trash + QStringLiteral("/info/") + candidate + InfoSuffix);
+
+        fd = open(infoName.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
+        if (fd < 0 && errno != EEXIST)
+            return QString();
+
+        // left without information by someone else
+        if (fd >= 0 && statPath(trashedPath, &st)) {
+            close(fd);
+            unlink(infoName.constData());
+            fd = -1;
+        }
+    }
+
+    const bool written = write(fd, info.constData(), info.size()) == info.size();
+    if (close(fd) != 0 || !written
+            || rename(QFile::encodeName(absolutePath).constData(), QFile::encodeName(trashedPath).constData()) != 0) {
+        unlink(infoName.constData());
+        return QString();
+    }
+
+    return trashedPath;
+}
+
+QString Trash::originalPath(const QString &trashedPath)
+{
+    QString original;
+    return readInfo(infoPath(trashedPath), &original, nullptr) ? original : QString();
+}
+
+QString Trash::trashedPath(const QString &originalPath)
+{
+    const QString absolutePath = QDir::cleanPath(QFileInfo(originalPath).absoluteFilePath());
+    const QString trash = locate(parentPath(absolutePath)).trash;
+    if (trash.isEmpty())
+        return QString();
+
+    // the dates compare as strings
+    QString latest;
+    QByteArray latestDate;
+    const QDir info(trash + QStringLiteral("/info"));
+    for (const QString &entry : info.entryList(QStringList(QLatin1Char('*') + InfoSuffix), QDir::Files | QDir::Hidden)) {
+        QString original;
+        QByteArray deletionDate;
+        if (readInfo(info.filePath(entry), &original, &deletionDate) && original == absolutePath
+                && (latest.isEmpty() || deletionDate > latestDate)) {
+            latest = trash + QStringLiteral("/files/") + entry.left(entry.length() - InfoSuffix.length());
+            latestDate = deletionDate;
+        }
+    }
+    return latest;
+}
+
+bool Trash::restore(const QString &trashedPath)
+{
+    const QString original = originalPath(trashedPath);
+    struct stat64 st;
+    if (original.isEmpty() || statPath(original, &st) || !statPath(trashedPath, &st))
+        return false;
+
+    QDir().mkpath(parentPath(original));
+
+    // a file created at the original path meanwhile is not replaced
+    const QByteArray from = QFile::encodeName(trashedPath);
+    const QByteArray to = QFile::encodeName(original);
+    if (syscall(__NR_renameat2, AT_FDCWD, from.constData(), AT_FDCWD, to.constData(), RenameNoReplace) != 0) {
+        // only where the file system or the kernel can't refuse to replace, the check above has to do
+        if ((errno != EINVAL && errno != ENOSYS) || rename(from.constData(), to.constData()) != 0)
+            return false;
+    }
+
+    unlink(QFile::encodeName(infoPath(trashedPath)).constData());
+    return true;
+}
+
+void Trash::purge(const QStringList &trashedPaths)
+{
+    PurgeQueue *queue = purgeQueue();
+    queue->pool.start(new Purger(trashedPaths, &queue->stopping));
+}
+
+bool Trash::isPurging()
+{
+    return purgeQueue()->pool.activeThreadCount() > 0;
+}
+
+bool Trash::waitForPurged(int msecs)
+{
+    return purgeQueue()->pool.waitForDone(msecs);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef TRASH_H
+#define TRASH_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief The Trash class moves files to the trash of their own file system as described by the
+ * freedesktop.org trash specification, so that trashing is a rename however large the file. The
+ * file system of the home directory uses $XDG_DATA_HOME/Trash, others $topdir/.Trash/$uid when
+ * the administrator has set it up, $topdir/.Trash-$uid otherwise.
+ *
+ * Trashed files can be restored, or purged by a thread of idle priority while the caller goes on.
+ */
+class Trash
+{
+public:
+    Trash() = delete;
+
+    // the trash for the file system of path, created if need be, empty if there can be none
+    static QString location(const QString &path);
+    // the same when it has been set up already, nothing is created
+    static QString existingLocation(const QString &path);
+
+    // renames path into the trash, returns the path it got there or an empty string
+    static QString moveToTrash(const QString &path);
+    // where a trashed file was before, empty if that isn't known
+    static QString originalPath(const QString &trashedPath);
+    // the most recently trashed file that was at path, or an empty string
+    static QString trashedPath(const QString &originalPath);
+    // renames a trashed file back to where it was, fails if something else is there by now
+    static bool restore(const QString &trashedPath);
+
+    // removes trashed files in the background, from the first to the last, at idle priority.
+    // Their trash information goes first, so they can no longer be restored from then on.
+    static void purge(const QStringList &trashedPaths);
+    static bool isPurging();
+    // false if the purges didn't finish within msecs, waits for good if negative
+    static bool waitForPurged(int msecs = -1);
+};
+
+#endif // TRASH_H
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "treeremover.h"
+#include "directoryreader.h"
+
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// enough to keep the storage busy, more would only contend for the same directories
+const int MaximumWalkers = 4;
+
+// how often run() asks whether to go on
+const int WaitInterval = 100;
+
+// ioprio_set() has no wrapper in glibc
+const int IoprioWhoProcess = 1;
+const int IoprioClassIdle = 3;
+const int IoprioClassShift = 13;
+
+}
+
+class TreeRemover::Walker : public QRunnable
+{
+public:
+    explicit Walker(TreeRemover *remover) : m_remover(remover) {}
+
+    void run() override
+    {
+        // the pool and its threads belong to the remover, so the priority needn't be restored
+        if (m_remover->m_idle)
+            setIdlePriority();
+        m_remover->walk();
+    }
+
+private:
+    TreeRemover *m_remover;
+};
+
+TreeRemover::TreeRemover(const QString &path, const FileOperations::PathResultFunc &removed)
+    : m_path(path)
+    , m_removed(removed)
+    , m_busy(0)
+    , m_cancelled(false)
+    , m_idle(false)
+{
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), MaximumWalkers));
+}
+
+TreeRemover::~TreeRemover()
+{
+    cancel();
+    m_pool.waitForDone();
+    qDeleteAll(m_nodes);
+}
+
+bool TreeRemover::run(const FileOperations::ContinueFunc &continueOperation)
+{
+    const QByteArray path = QFile::encodeName(m_path);
+    struct stat64 st;
+    if (lstat64(path.constData(), &st) != 0)
+        return false;
+
+    if (!S_ISDIR(st.st_mode)) {
+        const bool removed = unlink(path.constData()) == 0;
+        report(path, removed);
+        return removed;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_nodes.append(new Node(path, nullptr));
+        m_pending.push(m_nodes.last());
+    }
+
+    for (int i = 0; i < m_pool.maxThreadCount(); ++i)
+        m_pool.start(new Walker(this));
+
+    while (!m_pool.waitForDone(WaitInterval)) {
+        if (continueOperation && !continueOperation())
+            cancel();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    return !m_cancelled && !m_failed.load() && lstat64(path.constData(), &st) != 0;
+}
+
+void TreeRemover::setIdlePriority()
+{
+    // SCHED_IDLE on Linux
+    QThread::currentThread()->setPriority(QThread::IdlePriority);
+    // with which = 0 the calling thread, not the whole process
+    syscall(SYS_ioprio_set, IoprioWhoProcess, 0, IoprioClassIdle << IoprioClassShift);
+}
+
+void TreeRemover::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cancelled = true;
+    m_available.wakeAll();
+}
+
+void TreeRemover::walk()
+{
+    for (;;) {
+        Node *node;
+        {
+            QMutexLocker locker(&m_mutex);
+            // the others may still find more to do
+            while (m_pending.isEmpty() && m_busy > 0 && !m_cancelled)
+                m_available.wait(&m_mutex);
+            if (m_pending.isEmpty() || m_cancelled)
+                return;
+
+            node = m_pending.pop();
+            ++m_busy;
+        }
+
+        QVector<Node *> subdirectories;
+        removeFiles(node, &subdirectories);
+        // counted before any of them can be removed
+        node->pending.fetchAndAddOrdered(subdirectories.count());
+
+        {
+            QMutexLocker locker(&m_mutex);
+            for (Node *subdirectory : subdirectories) {
+                m_nodes.append(subdirectory);
+                m_pending.push(subdirectory);
+            }
+            m_available.wakeAll();
+        }
+
+        release(node);
+
+        QMutexLocker locker(&m_mutex);
+        --m_busy;
+        m_available.wakeAll();
+    }
+}
+
+void TreeRemover::removeFiles(Node *node, QVector<Node *> *subdirectories)
+{
+    DirectoryReader reader(QFile::decodeName(node->path));
+    if (!reader.isValid()) {
+        m_failed.storeRelease(1);
+        return;
+    }
+
+    while (const struct dirent64 *entry = reader.next()) {
+        if (DirectoryReader::entryType(reader.fd(), entry) == DT_DIR) {
+            subdirectories->append(new Node(node->path + '/' + entry->d_name, node));
+        } else {
+            // removed by someone else meanwhile is fine
+            const bool removed = unlinkat(reader.fd(), entry->d_name, 0) == 0 || errno == ENOENT;
+            // the path is only put together when wanted
+            if (!removed || m_removed)
+                report(node->path + '/' + entry->d_name, removed);
+        }
+    }
+}
+
+// the directories emptied by the node are removed, up the tree as far as it goes
+void TreeRemover::release(Node *node)
+{
+    while (node && !node->pending.deref()) {
+        if (rmdir(node->path.constData()) != 0 && errno != ENOENT)
+            m_failed.storeRelease(1);
+        node = node->parent;
+    }
+}
+
+void TreeRemover::report(const QByteArray &path, bool removed)
+{
+    if (!removed)
+        m_failed.storeRelease(1);
+    if (m_removed)
+        m_removed(QFile::decodeName(path), removed);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef TREEREMOVER_H
+#define TREEREMOVER_H
+
+#include "fileoperations.h"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMutex>
+#include <QStack>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+/**
+ * @brief The TreeRemover class removes a directory tree with a few threads, each emptying
+ * different directories. Files are unlinked relative to their open directory, and a directory
+ * is removed as soon as the last of its subdirectories is. Symbolic links are removed and not
+ * followed.
+ */
+class TreeRemover
+{
+public:
+    // removed is called from the removing threads for every file, but not the directories
+    explicit TreeRemover(const QString &path,
+                         const FileOperations::PathResultFunc &removed = FileOperations::PathResultFunc());
+    // cancels the removal and waits for the threads
+    ~TreeRemover();
+
+    // false if anything is left, continueOperation is called from the calling thread a few
+    // times a second
+    bool run(const FileOperations::ContinueFunc &continueOperation = FileOperations::ContinueFunc());
+
+    // the removing threads run at idle CPU and I/O priority, for removals nobody waits for
+    void setIdle(bool idle) { m_idle = idle; }
+
+    // lowers the CPU and I/O priority of the calling thread to idle for the rest of its life
+    static void setIdlePriority();
+
+private:
+    Q_DISABLE_COPY(TreeRemover)
+
+    class Walker;
+
+    struct Node
+    {
+        Node(const QByteArray &path, Node *parent) : path(path), parent(parent), pending(1) {}
+
+        QByteArray path;
+        Node *parent;
+        // the subdirectories not yet removed, and one while the directory is being emptied
+        QAtomicInt pending;
+    };
+
+    void cancel();
+    void walk();
+    void removeFiles(Node *node, QVector<Node *> *subdirectories);
+    void release(Node *node);
+    void report(const QByteArray &path, bool removed);
+
+    const QString m_path;
+    const FileOperations::PathResultFunc m_removed;
+    QAtomicInt m_failed;
+    QMutex m_mutex;
+    QWaitCondition m_available;
+    QStack<Node *> m_pending;
+    QVector<Node *> m_nodes;
+    int m_busy;
+    bool m_cancelled;
+    bool m_idle;
+    QThreadPool m_pool;
+};
+
+#endif // TREEREMOVER_H
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "treescanner.h"
+#include "directoryreader.h"
+
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace {
+
+// enough to keep the storage busy, more would only contend for it
+const int MaximumWalkers = 4;
+
+// how often waitForFinished() asks whether to go on
+const unsigned long WaitInterval = 100;
+
+}
+
+class TreeScanner::Walker : public QRunnable
+{
+public:
+    explicit Walker(TreeScanner *scanner) : m_scanner(scanner) {}
+
+    void run() override { m_scanner->walk(); }
+
+private:
+    TreeScanner *m_scanner;
+};
+
+TreeScanner::TreeScanner(const QStringList &paths, bool hidden)
+    : m_paths(paths)
+    , m_hidden(hidden)
+    , m_busy(0)
+    , m_started(false)
+    , m_finished(false)
+    , m_cancelled(false)
+{
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), MaximumWalkers));
+}
+
+TreeScanner::~TreeScanner()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void TreeScanner::start()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_started)
+        return;
+    m_started = true;
+
+    // the top level is cheap, the directories are left to the walkers
+    foreach (const QString &path, m_paths) {
+        const QByteArray fileName = QFile::encodeName(path);
+        struct stat64 st;
+        if (lstat64(fileName.constData(), &st) != 0)
+            continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            ++m_totals.directories;
+            m_pending.push(fileName);
+        } else {
+            ++m_totals.files;
+            m_totals.bytes += S_ISREG(st.st_mode) ? st.st_size : 0;
+        }
+    }
+
+    if (m_pending.isEmpty()) {
+        m_finished = true;
+        return;
+    }
+
+    for (int i = 0; i < m_pool.maxThreadCount(); ++i)
+        m_pool.start(new Walker(this));
+}
+
+void TreeScanner::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cancelled = true;
+    m_available.wakeAll();
+}
+
+bool TreeScanner::isFinished() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_finished;
+}
+
+TreeScanner::Totals TreeScanner::totals() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_totals;
+}
+
+bool TreeScanner::waitForFinished(const std::function<bool()> &continueOperation)
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_finished && !m_cancelled) {
+        m_available.wait(&m_mutex, WaitInterval);
+
+        if (continueOperation) {
+            locker.unlock();
+            const bool proceed = continueOperation();
+            locker.relock();
+            if (!proceed)
+                return false;
+        }
+    }
+    return m_finished;
+}
+
+void TreeScanner::walk()
+{
+    for (;;) {
+        QByteArray directory;
+        {
+            QMutexLocker locker(&m_mutex);
+            // the others may still find more to do
+            while (m_pending.isEmpty() && m_busy > 0 && !m_cancelled)
+                m_available.wait(&m_mutex);
+            if (m_pending.isEmpty() || m_cancelled)
+                return;
+
+            directory = m_pending.pop();
+            ++m_busy;
+        }
+
+        Totals totals;
+        QList<QByteArray> subdirectories;
+        scanDirectory(directory, &totals, &subdirectories);
+
+        QMutexLocker locker(&m_mutex);
+        m_totals.bytes += totals.bytes;
+        m_totals.files += totals.files;
+        m_totals.directories += totals.directories;
+        foreach (const QByteArray &subdirectory, subdirectories)
+            m_pending.push(subdirectory);
+
+        if (--m_busy == 0 && m_pending.isEmpty())
+            m_finished = true;
+        m_available.wakeAll();
+    }
+}
+
+void TreeScanner::scanDirectory(const QByteArray &path, Totals *totals, QList<QByteArray> *subdirectories) const
+{
+    DirectoryReader reader(QFile::decodeName(path));
+    if (!reader.isValid())
+        return;
+
+    while (const struct dirent64 *entry = reader.next()) {
+        if (!m_hidden && entry->d_name[0] == '.')
+            continue;
+
+        // only the files need to be stat'ed, if the file system reports the types
+        unsigned char type = entry->d_type;
+        qint64 size = 0;
+        if (type == DT_UNKNOWN || type == DT_REG) {
+            struct stat64 st;
+            if (fstatat64(reader.fd(), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                continue;
+            type = S_ISDIR(st.st_mode) ? DT_DIR
+                 : S_ISREG(st.st_mode) ? DT_REG
+                 : S_ISLNK(st.st_mode) ? DT_LNK
+                 : DT_UNKNOWN;
+            size = S_ISREG(st.st_mode) ? st.st_size : 0;
+        }
+
+        if (type == DT_DIR) {
+            ++totals->directories;
+            subdirectories->append(path + '/' + entry->d_name);
+        } else if (type == DT_REG || type == DT_LNK) {
+            // what the copy transfers, the special files are skipped
+            ++totals->files;
+            totals->bytes += size;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef TREESCANNER_H
+#define TREESCANNER_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QStack>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <functional>
+
+/**
+ * @brief The TreeScanner class totals the files of directory trees in the background, with a few
+ * threads walking the directories in parallel. The totals can be read while the scan goes on,
+ * so that an operation can start before the scan ends. Symbolic links are counted as files
+ * and not followed.
+ */
+class TreeScanner
+{
+public:
+    struct Totals
+    {
+        Totals() : bytes(0), files(0), directories(0) {}
+
+        qint64 bytes;
+        int files;
+        int directories;
+    };
+
+    // hidden files within the directories are skipped unless asked for
+    explicit TreeScanner(const QStringList &paths, bool hidden = false);
+    // cancels the scan and waits for the threads
+    ~TreeScanner();
+
+    void start();
+    void cancel();
+
+    bool isFinished() const;
+    // so far, or in full once finished
+    Totals totals() const;
+
+    // returns false if cancelled before the scan finished, continueOperation is called
+    // from the waiting thread a few times a second
+    bool waitForFinished(const std::function<bool()> &continueOperation = std::function<bool()>());
+
+private:
+    Q_DISABLE_COPY(TreeScanner)
+
+    class Walker;
+
+    void walk();
+    void scanDirectory(const QByteArray &path, Totals *totals, QList<QByteArray> *subdirectories) const;
+
+    const QStringList m_paths;
+    const bool m_hidden;
+    mutable QMutex m_mutex;
+    QWaitCondition m_available;
+    QStack<QByteArray> m_pending;
+    Totals m_totals;
+    int m_busy;
+    bool m_started;
+    bool m_finished;
+    bool m_cancelled;
+    QThreadPool m_pool;
+};
+
+#endif // TREESCANNER_H
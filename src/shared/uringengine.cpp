@@ -0,0 +1,535 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "uringengine.h"
+
+#ifdef HAS_LIBURING
+
+#include "directoryreader.h"
+
+#include <QFile>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const unsigned RingEntries = 256;
+// the files copied at once, each has at most four operations in flight
+const int SlotCount = 32;
+const int SlotBufferSize = 128 * 1024;
+// larger files are left to copyOverwrite(), which can clone them or copy them within the kernel
+const qint64 LargeFileSize = 1024 * 1024;
+
+// kept in the low bits of the user data, next to the slot
+enum Operation {
+    StatSource,
+    OpenSource,
+    UnlinkTarget,
+    OpenTarget,
+    ReadSource,
+    WriteTarget,
+    CloseFile
+};
+const quintptr OperationMask = 7;
+
+bool isRetry(int rv)
+{
+    return rv == -EINTR || rv == -EAGAIN || rv == -EBUSY;
+}
+
+// the files of a tree, and its directories by depth, continueOperation is asked for every directory
+bool collectTree(const QByteArray &path, int depth, QVector<QByteArray> *files,
+                 QVector<QVector<QByteArray> > *directories,
+                 const FileOperations::ContinueFunc &continueOperation)
+{
+    if (continueOperation && !continueOperation())
+        return false;
+
+    DirectoryReader reader(QFile::decodeName(path));
+    if (!reader.isValid())
+        return false;
+
+    while (const struct dirent64 *entry = reader.next()) {
+        const QByteArray entryPath = path + '/' + entry->d_name;
+        if (DirectoryReader::entryType(reader.fd(), entry) == DT_DIR) {
+            if (!collectTree(entryPath, depth + 1, files, directories, continueOperation))
+                return false;
+        } else {
+            files->append(entryPath);
+        }
+    }
+
+    if (directories->count() <= depth)
+        directories->resize(depth + 1);
+    (*directories)[depth].append(path);
+    return true;
+}
+
+}
+
+struct UringEngine::Slot
+{
+    enum State {
+        Idle,
+        Opening,
+        Copying,
+        Closing
+    };
+
+    Slot() : state(Idle), srcFd(-1), destFd(-1), offset(0), length(0), written(0), inFlight(0)
+      , failed(false), created(false), delegated(false) {}
+
+    State state;
+    QString source;
+    QByteArray sourceName;
+    QByteArray targetName;
+    struct statx stat;
+    int srcFd;
+    int destFd;
+    qint64 offset; // of the data in the buffer
+    int length; // of the data in the buffer
+    int written; // of the data in the buffer
+    int inFlight;
+    bool failed;
+    bool created;
+    bool delegated;
+    QByteArray buffer;
+};
+
+UringEngine::UringEngine()
+    : m_valid(isAvailable() && io_uring_queue_init(RingEntries, &m_ring, 0) == 0)
+{
+}
+
+UringEngine::~UringEngine()
+{
+    if (m_valid)
+        io_uring_queue_exit(&m_ring);
+}
+
+bool UringEngine::isValid() const
+{
+    return m_valid;
+}
+
+bool UringEngine::isAvailable()
+{
+    static const bool available = []() -> bool {
+        // also fails where io_uring is disabled or filtered out
+        struct io_uring_probe *probe = io_uring_get_probe();
+        if (!probe)
+            return false;
+
+        const int operations[] = {
+            IORING_OP_STATX, IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE,
+            IORING_OP_UNLINKAT
+        };
+        bool supported = true;
+        for (int operation : operations)
+            supported = supported && io_uring_opcode_supported(probe, operation);
+        io_uring_free_probe(probe);
+        return supported;
+    }();
+    return available;
+}
+
+bool UringEngine::copyFiles(const QVector<File> &files, const FileFunc &fileStarted,
+                            const FileOperations::BytesFunc &copied, const FileFunc &fileCopied,
+                            const FileOperations::ContinueFunc &continueOperation)
+{
+    if (!m_valid)
+        return false;
+
+    QVector<Slot> fileSlots(SlotCount);
+    int next = 0;
+    int active = 0;
+    bool ok = true;
+
+    for (;;) {
+        if (ok && continueOperation && !continueOperation())
+            ok = false;
+
+        // the files in flight are completed after a failure, but no new ones are started
+        for (int i = 0; ok && next < files.count() && i < fileSlots.count(); ++i) {
+            if (fileSlots[i].state == Slot::Idle) {
+                start(&fileSlots[i], files.at(next++), fileStarted);
+                ++active;
+            }
+        }
+
+        if (active == 0)
+            break;
+
+        const int rv = io_uring_submit_and_wait(&m_ring, 1);
+        if (rv < 0 && !isRetry(rv)) {
+            abandon(fileSlots);
+            return false;
+        }
+
+        struct io_uring_cqe *cqe;
+        unsigned head;
+        unsigned count = 0;
+        io_uring_for_each_cqe(&m_ring, head, cqe) {
+            const quintptr data = reinterpret_cast<quintptr>(io_uring_cqe_get_data(cqe));
+            complete(reinterpret_cast<Slot *>(data & ~OperationMask), int(data & OperationMask), cqe->res, copied);
+            ++count;
+        }
+        io_uring_cq_advance(&m_ring, count);
+
+        for (Slot &slot : fileSlots) {
+            if (slot.state == Slot::Closing && slot.inFlight == 0) {
+                finish(&slot, copied, fileCopied);
+                ok = ok && !slot.failed;
+                --active;
+            }
+        }
+    }
+
+    return ok;
+}
+
+bool UringEngine::removeTree(const QString &path, const FileOperations::PathResultFunc &removed,
+                             const FileOperations::ContinueFunc &continueOperation)
+{
+    if (!m_valid)
+        return false;
+
+    QVector<QByteArray> files;
+    QVector<QVector<QByteArray> > directories;
+    if (!collectTree(QFile::encodeName(path), 0, &files, &directories, continueOperation)
+            || !unlinkAll(files, 0, removed, continueOperation)) {
+        return false;
+    }
+
+    // the directories empty from the deepest up
+    for (int depth = directories.count() - 1; depth >= 0; --depth) {
+        if (!unlinkAll(directories.at(depth), AT_REMOVEDIR, FileOperations::PathResultFunc(), continueOperation))
+            return false;
+    }
+    return true;
+}
+
+struct io_uring_sqe *UringEngine::sqe()
+{
+    struct io_uring_sqe *entry = io_uring_get_sqe(&m_ring);
+    if (!entry) {
+        io_uring_submit(&m_ring);
+        entry = io_uring_get_sqe(&m_ring);
+    }
+    return entry;
+}
+
+void UringEngine::submit(Slot *slot, int op, struct io_uring_sqe *entry)
+{
+    io_uring_sqe_set_data(entry, reinterpret_cast<void *>(reinterpret_cast<quintptr>(slot) | quintptr(op)));
+    ++slot->inFlight;
+}
+
+void UringEngine::start(Slot *slot, const File &file, const FileFunc &fileStarted)
+{
+    slot->state = Slot::Opening;
+    slot->source = file.source;
+    slot->sourceName = QFile::encodeName(file.source);
+    slot->targetName = QFile::encodeName(file.target);
+    slot->srcFd = -1;
+    slot->destFd = -1;
+    slot->offset = 0;
+    slot->length = 0;
+    slot->written = 0;
+    slot->failed = false;
+    slot->created = false;
+    slot->delegated = false;
+
+    if (fileStarted)
+        fileStarted(file.source);
+
+    struct io_uring_sqe *entry = sqe();
+    io_uring_prep_statx(entry, AT_FDCWD, slot->sourceName.constData(), 0, STATX_MODE | STATX_SIZE | STATX_BLOCKS, &slot->stat);
+    submit(slot, StatSource, entry);
+
+    entry = sqe();
+    io_uring_prep_openat(entry, AT_FDCWD, slot->sourceName.constData(), O_RDONLY | O_CLOEXEC, 0);
+    submit(slot, OpenSource, entry);
+
+    // an existing target is replaced, the open goes ahead whether there was one or not
+    entry = sqe();
+    io_uring_prep_unlinkat(entry, AT_FDCWD, slot->targetName.constData(), 0);
+    io_uring_sqe_set_flags(entry, IOSQE_IO_HARDLINK);
+    submit(slot, UnlinkTarget, entry);
+
+    entry = sqe();
+    io_uring_prep_openat(entry, AT_FDCWD, slot->targetName.constData(),
+                         O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    submit(slot, OpenTarget, entry);
+}
+
+void UringEngine::complete(Slot *slot, int op, int result, const FileOperations::BytesFunc &copied)
+{
+    --slot->inFlight;
+
+    switch (op) {
+    case StatSource:
+    case CloseFile:
+        slot->failed = slot->failed || result < 0;
+        break;
+    case OpenSource:
+        if (result >= 0)
+            slot->srcFd = result;
+        slot->failed = slot->failed || result < 0;
+        break;
+    case UnlinkTarget:
+        // there usually is none
+        break;
+    case OpenTarget:
+        if (result >= 0) {
+            slot->destFd = result;
+            slot->created = true;
+        }
+        slot->failed = slot->failed || result < 0;
+        break;
+    case ReadSource:
+        if (result > 0) {
+            slot->length = result;
+            slot->written = 0;
+            write(slot);
+            return;
+        }
+        // the end of the file
+        slot->failed = slot->failed || result < 0;
+        break;
+    case WriteTarget:
+        if (result > 0) {
+            slot->written += result;
+            if (slot->written < slot->length) {
+                write(slot);
+            } else {
+                if (copied)
+                    copied(slot->length);
+                slot->offset += slot->length;
+                read(slot);
+            }
+            return;
+        }
+        slot->failed = true;
+        break;
+    }
+
+    if (slot->inFlight > 0)
+        return;
+
+    if (slot->state == Slot::Opening && !slot->failed) {
+        // as are sparse files, whose holes a plain copy would fill
+        if (qint64(slot->stat.stx_size) >= LargeFileSize
+                || qint64(slot->stat.stx_blocks) * 512 < qint64(slot->stat.stx_size)) {
+            slot->delegated = true;
+        } else {
+            slot->state = Slot::Copying;
+            if (slot->buffer.isEmpty())
+                slot->buffer = QByteArray(SlotBufferSize, Qt::Uninitialized);
+            read(slot);
+            return;
+        }
+    } else if (slot->state == Slot::Copying && !slot->failed) {
+        // the permissions are set once the data is in place
+        slot->failed = fchmod(slot->destFd, slot->stat.stx_mode & 07777) != 0;
+    }
+
+    if (slot->state != Slot::Closing)
+        close(slot);
+}
+
+void UringEngine::read(Slot *slot)
+{
+    struct io_uring_sqe *entry = sqe();
+    io_uring_prep_read(entry, slot->srcFd, slot->buffer.data(), SlotBufferSize, slot->offset);
+    submit(slot, ReadSource, entry);
+}
+
+void UringEngine::write(Slot *slot)
+{
+    struct io_uring_sqe *entry = sqe();
+    io_uring_prep_write(entry, slot->destFd, slot->buffer.constData() + slot->written,
+                        slot->length - slot->written, slot->offset + slot->written);
+    submit(slot, WriteTarget, entry);
+}
+
+void UringEngine::close(Slot *slot)
+{
+    slot->state = Slot::Closing;
+    const int fds[] = { slot->srcFd, slot->destFd };
+    for (int fd : fds) {
+        if (fd >= 0) {
+            struct io_uring_sqe *entry = sqe();
+            io_uring_prep_close(entry, fd);
+            submit(slot, CloseFile, entry);
+        }
+    }
+    slot->srcFd = -1;
+    slot->destFd = -1;
+}
+
+void UringEngine::finish(Slot *slot, const FileOperations::BytesFunc &copied, const FileFunc &fileCopied)
+{
+    slot->state = Slot::Idle;
+
+    if (slot->delegated && !slot->failed)
+        slot->failed = !FileOperations::copyOverwrite(slot->source, QFile::decodeName(slot->targetName), nullptr, copied);
+    else if (slot->failed && slot->created)
+        unlink(slot->targetName.constData());
+
+    if (!slot->failed && fileCopied)
+        fileCopied(slot->source);
+}
+
+void UringEngine::abandon(QVector<Slot> &fileSlots)
+{
+    // the completions already posted may carry descriptors opened and targets created
+    struct io_uring_cqe *cqe;
+    unsigned head;
+    unsigned count = 0;
+    io_uring_for_each_cqe(&m_ring, head, cqe) {
+        const quintptr data = reinterpret_cast<quintptr>(io_uring_cqe_get_data(cqe));
+        Slot *slot = reinterpret_cast<Slot *>(data & ~OperationMask);
+        const int op = int(data & OperationMask);
+        if (cqe->res >= 0 && op == OpenSource) {
+            slot->srcFd = cqe->res;
+        } else if (cqe->res >= 0 && op == OpenTarget) {
+            slot->destFd = cqe->res;
+            slot->created = true;
+        }
+        ++count;
+    }
+    io_uring_cq_advance(&m_ring, count);
+
+    // the kernel cancels what is left when the ring goes
+    io_uring_queue_exit(&m_ring);
+    m_valid = false;
+
+    // the files not finished were not reported copied, leave nothing of them behind
+    for (Slot &slot : fileSlots) {
+        if (slot.state == Slot::Idle)
+            continue;
+        if (slot.srcFd >= 0)
+            ::close(slot.srcFd);
+        if (slot.destFd >= 0)
+            ::close(slot.destFd);
+        if (slot.created)
+            unlink(slot.targetName.constData());
+        slot.srcFd = -1;
+        slot.destFd = -1;
+        slot.state = Slot::Idle;
+    }
+}
+
+bool UringEngine::unlinkAll(const QVector<QByteArray> &paths, int flags, const FileOperations::PathResultFunc &removed,
+                            const FileOperations::ContinueFunc &continueOperation)
+{
+    int next = 0;
+    int inFlight = 0;
+    bool ok = true;
+
+    while (next < paths.count() || inFlight > 0) {
+        if (ok && continueOperation && !continueOperation())
+            ok = false;
+
+        // the removals in flight are completed after a failure, but no new ones are started
+        for (; ok && next < paths.count() && inFlight < int(RingEntries); ++next, ++inFlight) {
+            struct io_uring_sqe *entry = sqe();
+            io_uring_prep_unlinkat(entry, AT_FDCWD, paths.at(next).constData(), flags);
+            io_uring_sqe_set_data(entry, reinterpret_cast<void *>(quintptr(next)));
+        }
+
+        if (inFlight == 0)
+            break;
+
+        const int rv = io_uring_submit_and_wait(&m_ring, 1);
+        if (rv < 0 && !isRetry(rv)) {
+            io_uring_queue_exit(&m_ring);
+            m_valid = false;
+            return false;
+        }
+
+        struct io_uring_cqe *cqe;
+        unsigned head;
+        unsigned count = 0;
+        io_uring_for_each_cqe(&m_ring, head, cqe) {
+            // removed by someone else meanwhile is fine
+            const bool unlinked = cqe->res >= 0 || cqe->res == -ENOENT;
+            if (removed)
+                removed(QFile::decodeName(paths.at(int(reinterpret_cast<quintptr>(io_uring_cqe_get_data(cqe))))), unlinked);
+            ok = ok && unlinked;
+            ++count;
+        }
+        io_uring_cq_advance(&m_ring, count);
+        inFlight -= count;
+    }
+
+    return ok;
+}
+
+#else
+
+UringEngine::UringEngine()
+    : m_valid(false)
+{
+}
+
+UringEngine::~UringEngine()
+{
+}
+
+bool UringEngine::isValid() const
+{
+    return false;
+}
+
+bool UringEngine::isAvailable()
+{
+    return false;
+}
+
+bool UringEngine::copyFiles(const QVector<File> &, const FileFunc &, const FileOperations::BytesFunc &,
+                            const FileFunc &, const FileOperations::ContinueFunc &)
+{
+    return false;
+}
+
+bool UringEngine::removeTree(const QString &, const FileOperations::PathResultFunc &,
+                             const FileOperations::ContinueFunc &)
+{
+    return false;
+}
+
+#endif
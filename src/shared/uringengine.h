@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef URINGENGINE_H
+#define URINGENGINE_H
+
+#include "fileoperations.h"
+
+#include <QVector>
+
+#ifdef HAS_LIBURING
+#include <liburing.h>
+#endif
+
+/**
+ * @brief The UringEngine class copies and deletes many files from one thread through an io_uring
+ * submission queue, keeping the device busy without a thread per file.
+ *
+ * Built only with liburing, and used only when the kernel supports the operations, the threaded
+ * paths are taken otherwise.
+ */
+class UringEngine
+{
+public:
+    struct File
+    {
+        QString source;
+        QString target;
+    };
+
+    typedef std::function<void(const QString &)> FileFunc;
+
+    UringEngine();
+    ~UringEngine();
+
+    bool isValid() const;
+
+    // whether liburing is built in and the kernel has every operation used, checked once
+    static bool isAvailable();
+
+    // copies regular files, the callbacks get the source paths, and continueOperation is asked
+    // between completions
+    bool copyFiles(const QVector<File> &files, const FileFunc &fileStarted,
+                   const FileOperations::BytesFunc &copied, const FileFunc &fileCopied,
+                   const FileOperations::ContinueFunc &continueOperation);
+
+    // removes a directory and everything in it, without following symbolic links, removed is
+    // called for every file but not the directories, and continueOperation is asked for every
+    // directory while collecting the tree and between completions
+    bool removeTree(const QString &path,
+                    const FileOperations::PathResultFunc &removed = FileOperations::PathResultFunc(),
+                    const FileOperations::ContinueFunc &continueOperation = FileOperations::ContinueFunc());
+
+private:
+    Q_DISABLE_COPY(UringEngine)
+
+#ifdef HAS_LIBURING
+    struct Slot;
+
+    struct io_uring_sqe *sqe();
+    void submit(Slot *slot, int op, struct io_uring_sqe *entry);
+    void start(Slot *slot, const File &file, const FileFunc &fileStarted);
+    void complete(Slot *slot, int op, int result, const FileOperations::BytesFunc &copied);
+    void read(Slot *slot);
+    void write(Slot *slot);
+    void close(Slot *slot);
+    void finish(Slot *slot, const FileOperations::BytesFunc &copied, const FileFunc &fileCopied);
+    void abandon(QVector<Slot> &fileSlots);
+    bool unlinkAll(const QVector<QByteArray> &paths, int flags, const FileOperations::PathResultFunc &removed,
+                   const FileOperations::ContinueFunc &continueOperation);
+
+    struct io_uring m_ring;
+#endif
+    bool m_valid;
+};
+
+#endif // URINGENGINE_H
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+import QtTest 1.0
+import QtQuick 2.0
+import Nemo.FileManager 1.0
+
+Item {
+    FileInfo {
+        id: syncInfo
+    }
+
+    FileInfo {
+        id: asyncInfo
+        asynchronous: true
+    }
+
+    resources: TestCase {
+        name: "FileInfo"
+
+        function cleanup() {
+            syncInfo.file = ""
+            asyncInfo.file = ""
+        }
+
+        function test_synchronous() {
+            compare(syncInfo.status, FileInfo.Null)
+
+            syncInfo.file = "folder/b"
+            compare(syncInfo.status, FileInfo.Ready)
+            compare(syncInfo.fileName, "b")
+            compare(syncInfo.size, 2)
+            compare(syncInfo.exists, true)
+        }
+
+        function test_asynchronous() {
+            compare(asyncInfo.status, FileInfo.Null)
+
+            asyncInfo.file = "folder/c"
+            compare(asyncInfo.status, FileInfo.Loading)
+            tryCompare(asyncInfo, "status", FileInfo.Ready)
+            compare(asyncInfo.fileName, "c")
+            compare(asyncInfo.size, 4)
+            compare(asyncInfo.mimeType, "text/plain")
+
+            // only the latest of the requests made in a row is applied
+            asyncInfo.file = "folder/a"
+            asyncInfo.file = "folder/subfolder"
+            compare(asyncInfo.status, FileInfo.Loading)
+            tryCompare(asyncInfo, "status", FileInfo.Ready)
+            compare(asyncInfo.fileName, "subfolder")
+            compare(asyncInfo.isDir, true)
+
+            asyncInfo.file = "folder/missing"
+            tryCompare(asyncInfo, "status", FileInfo.Ready)
+            compare(asyncInfo.exists, false)
+
+            asyncInfo.file = ""
+            compare(asyncInfo.status, FileInfo.Null)
+        }
+    }
+}
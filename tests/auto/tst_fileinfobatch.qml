@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+import QtTest 1.0
+import QtQuick 2.0
+import Nemo.FileManager 1.0
+
+Item {
+    FileInfoBatch {
+        id: batch
+    }
+
+    resources: TestCase {
+        name: "FileInfoBatch"
+
+        function test_query() {
+            var results = null
+            batch.query(["folder/subfolder/d", "folder/c", "folder/missing", "folder/subfolder", "folder/b"],
+                        function(infos) { results = infos })
+            compare(batch.working, true)
+            tryCompare(batch, "working", false)
+
+            verify(results !== null)
+            compare(results.length, 5)
+
+            // results are in the order of the request
+            compare(results[0].fileName, "d")
+            compare(results[0].exists, true)
+            compare(results[0].size, 0)
+            compare(results[0].mimeType, "application/x-zerosize")
+
+            compare(results[1].fileName, "c")
+            compare(results[1].size, 4)
+            compare(results[1].mimeType, "text/plain")
+            compare(results[1].isDir, false)
+
+            compare(results[2].fileName, "missing")
+            compare(results[2].exists, false)
+
+            compare(results[3].fileName, "subfolder")
+            compare(results[3].isDir, true)
+            compare(results[3].mimeType, "inode/directory")
+
+            compare(results[4].path, "folder/b")
+            compare(results[4].size, 2)
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+import QtTest 1.0
+import QtQuick 2.0
+import Nemo.FileManager 1.0
+
+Item {
+    FileListWatcher {
+        id: watcher
+        fileNames: [ "folder/b", "folder/listdirectory", "folder/c", "folder/missing", "folder/b" ]
+    }
+
+    FileListWatcher {
+        id: nestedWatcher
+        fileNames: [ "folder/b", "folder/listrearm/file" ]
+    }
+
+    SignalSpy {
+        id: nestedSpy
+        target: nestedWatcher
+        signalName: "fileAdded"
+    }
+
+    SignalSpy {
+        id: addedSpy
+        target: watcher
+        signalName: "fileAdded"
+    }
+
+    SignalSpy {
+        id: removedSpy
+        target: watcher
+        signalName: "fileRemoved"
+    }
+
+    resources: TestCase {
+        name: "FileListWatcher"
+
+        function test_existingFiles() {
+            // duplicates are dropped
+            compare(watcher.fileNames.length, 4)
+            compare(watcher.existingFiles, [ "folder/b", "folder/c" ])
+            verify(watcher.exists("folder/b"))
+            verify(!watcher.exists("folder/missing"))
+
+            verify(FileEngine.mkdir("folder", "listdirectory"))
+            tryCompare(addedSpy, "count", 1)
+            compare(addedSpy.signalArguments[0][0], "folder/listdirectory")
+            compare(watcher.existingFiles, [ "folder/b", "folder/listdirectory", "folder/c" ])
+
+            FileEngine.deleteFiles([ "folder/listdirectory" ])
+            tryCompare(removedSpy, "count", 1)
+            compare(removedSpy.signalArguments[0][0], "folder/listdirectory")
+            compare(watcher.existingFiles, [ "folder/b", "folder/c" ])
+        }
+
+        function test_missingDirectory() {
+            compare(nestedWatcher.existingFiles, [ "folder/b" ])
+
+            // watched once the directory is there
+            verify(FileEngine.mkdir("folder", "listrearm"))
+            wait(6000)
+            verify(FileEngine.mkdir("folder/listrearm", "file"))
+            tryCompare(nestedSpy, "count", 1, 1000)
+            compare(nestedWatcher.existingFiles, [ "folder/b", "folder/listrearm/file" ])
+
+            // and again once it has been removed and created anew
+            FileEngine.deleteFiles([ "folder/listrearm" ])
+            tryCompare(nestedWatcher, "existingFiles", [ "folder/b" ])
+            verify(FileEngine.mkdir("folder", "listrearm"))
+            wait(6000)
+            verify(FileEngine.mkdir("folder/listrearm", "file"))
+            tryCompare(nestedSpy, "count", 2, 1000)
+
+            FileEngine.deleteFiles([ "folder/listrearm" ])
+            tryCompare(nestedWatcher, "existingFiles", [ "folder/b" ])
+        }
+
+        function test_fileNames() {
+            watcher.fileNames = [ "folder/c", "folder/missing" ]
+            compare(watcher.existingFiles, [ "folder/c" ])
+
+            watcher.fileNames = []
+            compare(watcher.existingFiles, [])
+        }
+    }
+}
@@ -51,6 +51,8 @@ Item {
             property string mimeType: model.mimeType
             property int size: model.size
             property bool isDir: model.isDir
+            property var directorySize: model.directorySize
+            property var childCount: model.childCount
         }
     }
 
@@ -171,6 +173,29 @@ Item {
             compare(repeater.itemAt(0).fileName, "a")
         }
 
+        function test_directorySize() {
+            fileModel.sortBy = FileModel.SortByName
+            fileModel.sortOrder = Qt.AscendingOrder
+            fileModel.includeDirectories = true
+            fileModel.directorySort = FileModel.SortDirectoriesWithFiles
+            fileModel.nameFilters = []
+            wait(0)
+            compare(fileModel.count, 4)
+
+            var directory = repeater.itemAt(3)
+            compare(directory.fileName, "subfolder")
+            compare(directory.directorySize, undefined)
+
+            fileModel.calculateDirectorySizes = true
+            tryCompare(directory, "childCount", 1)
+            compare(directory.directorySize, 0)
+            compare(repeater.itemAt(0).directorySize, undefined)
+
+            fileModel.calculateDirectorySizes = false
+            compare(directory.directorySize, undefined)
+            compare(directory.childCount, undefined)
+        }
+
         function test_errors() {
             compare(fileModel.errorType, FileModel.NoError)
 
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+import QtTest 1.0
+import QtQuick 2.0
+import Nemo.FileManager 1.0
+
+Item {
+    FileSearchModel {
+        id: searchModel
+        path: "folder"
+        active: true
+    }
+
+    Repeater {
+        id: repeater
+        model: searchModel
+        Item {
+            property string fileName: model.fileName
+            property string absolutePath: model.absolutePath
+            property int size: model.size
+            property bool isDir: model.isDir
+            property string mimeType: model.mimeType
+        }
+    }
+
+    resources: TestCase {
+        name: "FileSearchModel"
+
+        function init() {
+            searchModel.pattern = ""
+            searchModel.patternSyntax = FileSearchModel.FixedString
+            searchModel.caseSensitivity = Qt.CaseInsensitive
+            searchModel.maximumDepth = -1
+            searchModel.minimumSize = -1
+            searchModel.maximumSize = -1
+            searchModel.includeDirectories = true
+            searchModel.includeHiddenFiles = false
+            searchModel.active = true
+            wait(0)
+        }
+
+        function search(pattern) {
+            searchModel.pattern = pattern
+            wait(0)
+            tryCompare(searchModel, "searching", false)
+
+            var names = []
+            for (var i = 0; i < repeater.count; i++) {
+                names.push(repeater.itemAt(i).fileName)
+            }
+            return names.sort()
+        }
+
+        function test_fixedString() {
+            compare(search("d"), ["d", "subfolder"])
+            compare(searchModel.count, 2)
+
+            searchModel.includeDirectories = false
+            compare(search("d"), ["d"])
+
+            searchModel.caseSensitivity = Qt.CaseSensitive
+            compare(search("D"), [])
+        }
+
+        function test_wildcard() {
+            searchModel.patternSyntax = FileSearchModel.Wildcard
+            compare(search("[ab]"), ["a", "b"])
+
+            searchModel.includeHiddenFiles = true
+            compare(search("*.xml"), [".hidden.xml"])
+        }
+
+        function test_regExp() {
+            searchModel.patternSyntax = FileSearchModel.RegExp
+            compare(search("^[cd]$"), ["c", "d"])
+        }
+
+        function test_predicates() {
+            searchModel.patternSyntax = FileSearchModel.Wildcard
+
+            searchModel.maximumDepth = 1
+            compare(search("*"), ["a", "b", "c", "subfolder"])
+
+            searchModel.maximumDepth = -1
+            searchModel.minimumSize = 1
+            compare(search("*"), ["b", "c"])
+
+            searchModel.maximumSize = 2
+            compare(search("*"), ["b"])
+        }
+
+        function test_mimeType() {
+            searchModel.includeHiddenFiles = true
+            compare(search(".hidden.xml"), [".hidden.xml"])
+            // by the name, the files found are not opened
+            compare(repeater.itemAt(0).mimeType, "application/xml")
+
+            compare(search("subfolder"), ["subfolder"])
+            compare(repeater.itemAt(0).mimeType, "inode/directory")
+        }
+
+        function test_inactive() {
+            searchModel.active = false
+            searchModel.pattern = "a"
+            wait(0)
+            compare(searchModel.searching, false)
+            compare(searchModel.count, 0)
+
+            searchModel.active = true
+            tryCompare(searchModel, "count", 1)
+            compare(repeater.itemAt(0).fileName, "a")
+        }
+    }
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+import QtTest 1.0
+import QtQuick 2.0
+import Nemo.FileManager 1.0
+
+Item {
+    FileWatcher {
+        id: watcher
+        fileName: "folder/watcherdirectory"
+    }
+
+    FileWatcher {
+        id: otherWatcher
+        fileName: "folder/otherdirectory"
+    }
+
+    FileWatcher {
+        id: existingWatcher
+        fileName: "folder/b"
+    }
+
+    FileWatcher {
+        id: typedWatcher
+        fileName: "folder/typeddirectory"
+    }
+
+    FileWatcher {
+        id: nestedWatcher
+        fileName: "folder/rearmdirectory/file"
+    }
+
+    SignalSpy {
+        id: nestedSpy
+        target: nestedWatcher
+        signalName: "created"
+    }
+
+    SignalSpy {
+        id: createdSpy
+        target: typedWatcher
+        signalName: "created"
+    }
+
+    SignalSpy {
+        id: movedSpy
+        target: typedWatcher
+        signalName: "moved"
+    }
+
+    SignalSpy {
+        id: otherSpy
+        target: otherWatcher
+        signalName: "existsChanged"
+    }
+
+    resources: TestCase {
+        name: "FileWatcher"
+
+        function test_exists() {
+            compare(existingWatcher.exists, true)
+            compare(watcher.exists, false)
+            compare(otherWatcher.exists, false)
+
+            verify(FileEngine.mkdir("folder", "watcherdirectory"))
+            tryCompare(watcher, "exists", true)
+
+            FileEngine.deleteFiles([ "folder/watcherdirectory" ])
+            tryCompare(watcher, "exists", false)
+
+            // watchers of other files in the same directory are not affected
+            compare(otherSpy.count, 0)
+            compare(existingWatcher.exists, true)
+        }
+
+        function test_changes() {
+            verify(FileEngine.mkdir("folder", "typeddirectory"))
+            tryCompare(createdSpy, "count", 1)
+            compare(typedWatcher.exists, true)
+
+            // renames are reported with both ends of the move
+            verify(FileEngine.rename("folder/typeddirectory", "renameddirectory"))
+            tryCompare(movedSpy, "count", 1)
+            compare(movedSpy.signalArguments[0][0], "folder/typeddirectory")
+            verify(movedSpy.signalArguments[0][1].indexOf("/folder/renameddirectory") > 0)
+            compare(typedWatcher.exists, false)
+
+            FileEngine.deleteFiles([ "folder/renameddirectory" ])
+        }
+
+        function test_missingDirectory() {
+            compare(nestedWatcher.exists, false)
+
+            // watched once the directory is there
+            verify(FileEngine.mkdir("folder", "rearmdirectory"))
+            wait(6000)
+            verify(FileEngine.mkdir("folder/rearmdirectory", "file"))
+            tryCompare(nestedSpy, "count", 1, 1000)
+            compare(nestedWatcher.exists, true)
+
+            // and again once it has been removed and created anew
+            FileEngine.deleteFiles([ "folder/rearmdirectory" ])
+            tryCompare(nestedWatcher, "exists", false)
+            verify(FileEngine.mkdir("folder", "rearmdirectory"))
+            wait(6000)
+            verify(FileEngine.mkdir("folder/rearmdirectory", "file"))
+            tryCompare(nestedSpy, "count", 2, 1000)
+
+            FileEngine.deleteFiles([ "folder/rearmdirectory" ])
+            tryCompare(nestedWatcher, "exists", false)
+        }
+
+        function test_fileName() {
+            watcher.fileName = "folder/c"
+            compare(watcher.exists, true)
+
+            watcher.fileName = ""
+            compare(watcher.exists, false)
+        }
+    }
+}
@@ -2,7 +2,9 @@ include(common.pri)
 
 TEMPLATE = subdirs
 SUBDIRS = auto \
-    ut_diskusage
+    ut_diskusage \
+    ut_filemodel \
+    ut_fileoperations
 
 OTHER_FILES += tests.xml.template
 
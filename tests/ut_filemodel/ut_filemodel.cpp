@@ -0,0 +1,528 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "directoryindex.h"
+#include "directorypoller.h"
+#include "filemodel.h"
+#include "inotifywatcher.h"
+#include "statcache.h"
+#include "treewatcher.h"
+
+#include "ut_filemodel.h"
+
+#include <QtTest>
+#include <QFile>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Counts heap allocations, QString and friends allocate with malloc() rather than operator new.
+ * Overriding malloc() relies on the glibc entry points, the counts are not available elsewhere. */
+static bool g_count_allocations = false;
+static int g_allocations = 0;
+
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+extern "C" void *malloc(size_t size) __THROW
+{
+    if (g_count_allocations)
+        ++g_allocations;
+    return __libc_malloc(size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) __THROW
+{
+    if (g_count_allocations)
+        ++g_allocations;
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+static const int FileCount = 1000;
+
+static QList<int> statFileInfoRoles()
+{
+    // The creation and access times are left out. Unlike the modification time they are not
+    // kept converted for every entry, each call builds a QDateTime, whose private data is
+    // allocated; they are rarely shown, so not worth the memory. They are not recorded in the
+    // directory index or the snapshot of an evicted model either.
+    QList<int> roles;
+    for (int role = StatFileInfo::FileNameRole; role <= StatFileInfo::UrlRole; ++role) {
+        if (role != StatFileInfo::CreatedRole && role != StatFileInfo::LastAccessedRole)
+            roles.append(role);
+    }
+    return roles;
+}
+
+void Ut_FileModel::initTestCase()
+{
+    // keep the directory index out of the user's cache
+    QStandardPaths::setTestModeEnabled(true);
+
+    QVERIFY(m_directory.isValid());
+
+    for (int i = 0; i < FileCount; ++i) {
+        QFile file(m_directory.path() + QStringLiteral("/file%1.txt").arg(i));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("content");
+    }
+    QVERIFY(QFile::link(m_directory.path() + QStringLiteral("/file0.txt"),
+                        m_directory.path() + QStringLiteral("/link")));
+}
+
+void Ut_FileModel::populate(FileModel *model)
+{
+    model->setPath(m_directory.path());
+    model->setActive(true);
+    QTRY_VERIFY(model->populated());
+    QCOMPARE(model->count(), FileCount + 1);
+
+    // let the background work settle, so that it doesn't show up in the allocation counts
+    QThreadPool::globalInstance()->waitForDone();
+    QCoreApplication::processEvents();
+    QThreadPool::globalInstance()->waitForDone();
+}
+
+void Ut_FileModel::testDataAllocations()
+{
+#ifndef __GLIBC__
+    QSKIP("Counting allocations needs glibc");
+#endif
+
+    FileModel model;
+    populate(&model);
+    if (QTest::currentTestFailed())
+        return;
+
+    const QList<int> roles = statFileInfoRoles();
+
+    // the first access may build memoised values
+    for (int row = 0; row < model.count(); ++row) {
+        foreach (int role, roles)
+            model.data(model.index(row), role);
+    }
+
+    g_allocations = 0;
+    g_count_allocations = true;
+    for (int row = 0; row < model.count(); ++row) {
+        foreach (int role, roles)
+            model.data(model.index(row), role);
+    }
+    g_count_allocations = false;
+
+    QCOMPARE(g_allocations, 0);
+}
+
+void Ut_FileModel::testInactiveEviction()
+{
+    FileModel model;
+    populate(&model);
+    if (QTest::currentTestFailed())
+        return;
+
+    const QList<int> roles = statFileInfoRoles();
+    const int count = model.count();
+    QList<QVariantList> data;
+    for (int row = 0; row < count; ++row) {
+        QVariantList values;
+        foreach (int role, roles)
+            values.append(model.data(model.index(row), role));
+        data.append(values);
+    }
+
+    // an inactive model beyond the budget lets go of its entries
+    const int limit = FileModel::inactiveEntryLimit();
+    FileModel::setInactiveEntryLimit(count - 1);
+    model.setActive(false);
+    QTRY_COMPARE(model.count(), 0);
+
+    // and gets them back from the snapshot when activated again
+    model.setActive(true);
+    QCOMPARE(model.count(), count);
+    for (int row = 0; row < count; ++row) {
+        for (int i = 0; i < roles.count(); ++i)
+            QCOMPARE(model.data(model.index(row), roles.at(i)), data.at(row).at(i));
+    }
+    QTRY_VERIFY(model.populated());
+    QCOMPARE(model.count(), count);
+
+    FileModel::setInactiveEntryLimit(limit);
+}
+
+void Ut_FileModel::testStatCache()
+{
+    StatCache *cache = StatCache::instance();
+    cache->clear();
+
+    FileModel first;
+    populate(&first);
+    if (QTest::currentTestFailed())
+        return;
+
+    // a second model on the same directory is served from the cache, possibly
+    // while reconciling a listing restored from the directory index
+    const quint64 hits = cache->hits();
+    FileModel second;
+    second.setPath(m_directory.path());
+    second.setActive(true);
+    QTRY_VERIFY(second.populated());
+    QTRY_VERIFY(cache->hits() >= hits + FileCount);
+
+    // changes are picked up through the directory watches
+    const QString fileName = m_directory.path() + QStringLiteral("/new.txt");
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    QTRY_COMPARE(first.count(), FileCount + 2);
+    QTRY_COMPARE(second.count(), FileCount + 2);
+    QVERIFY(cache->fileInfo(fileName).exists());
+
+    QVERIFY(file.remove());
+    QTRY_COMPARE(first.count(), FileCount + 1);
+    QTRY_VERIFY(!cache->fileInfo(fileName).exists());
+
+    // the cached information is complete
+    const QString cachedName = m_directory.path() + QStringLiteral("/file1.txt");
+    StatFileInfo cached;
+    QVERIFY(cache->lookup(cachedName, false, &cached));
+    QVERIFY(cached.statFields() & StatFileInfo::FullStats);
+    QCOMPARE(uint(cached.statData().st_uid), uint(getuid()));
+    QCOMPARE(uint(cached.statData().st_gid), uint(getgid()));
+    QVERIFY(cached.statData().st_ctim.tv_sec > 0);
+    QVERIFY(cached.lastAccessedNs() > 0);
+    QCOMPARE(cached.size(), qint64(7));
+
+    // writing to a cached file is noticed when it is closed
+    QFile cachedFile(cachedName);
+    QVERIFY(cachedFile.open(QIODevice::WriteOnly | QIODevice::Append));
+    cachedFile.write("changed");
+    cachedFile.close();
+    QTRY_COMPARE(cache->fileInfo(cachedName).size(), qint64(14));
+
+    QVERIFY(cachedFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    cachedFile.write("content");
+    cachedFile.close();
+    QTRY_COMPARE(cache->fileInfo(cachedName).size(), qint64(7));
+
+    // information that was read before a change is not cached after the change was handled
+    quint64 generation = 0;
+    QVERIFY(cache->watch(m_directory.path(), &generation));
+    const StatFileInfo stale(cachedName);
+    QVERIFY(cachedFile.open(QIODevice::WriteOnly | QIODevice::Append));
+    cachedFile.write("changed");
+    cachedFile.close();
+    quint64 current = generation;
+    QTRY_VERIFY(cache->watch(m_directory.path(), &current) && current != generation);
+    QCOMPARE(stale.size(), qint64(7));
+    cache->insert(stale, generation, false);
+    QCOMPARE(cache->fileInfo(cachedName, false).size(), qint64(14));
+    // as the information read under the current generation is
+    cache->insert(StatFileInfo(cachedName), current);
+    QVERIFY(cache->lookup(cachedName, true, &cached));
+    QCOMPARE(cached.size(), qint64(14));
+
+    QVERIFY(cachedFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    cachedFile.write("content");
+    cachedFile.close();
+    QTRY_COMPARE(cache->fileInfo(cachedName).size(), qint64(7));
+
+    // the least recently used directories are let go of beyond the capacity
+    QTemporaryDir other;
+    QVERIFY(other.isValid());
+    const int capacity = cache->capacity();
+    cache->setCapacity(10);
+    QVERIFY(!cache->lookup(cachedName, false, &cached));
+    const int watches = cache->watchCount();
+    QVERIFY(!cache->fileInfo(other.path() + QStringLiteral("/missing"), false).exists());
+    QVERIFY(cache->lookup(other.path() + QStringLiteral("/missing"), false, &cached));
+    QVERIFY(cache->watchCount() <= watches + 1);
+    cache->setCapacity(capacity);
+}
+
+void Ut_FileModel::testStatData()
+{
+    const QString fileName = m_directory.path() + QStringLiteral("/times.txt");
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    struct timespec times[2];
+    times[0].tv_sec = 1500000000;
+    times[0].tv_nsec = 123456789;
+    times[1].tv_sec = 1600000000;
+    times[1].tv_nsec = 987654321;
+    QVERIFY(utimensat(AT_FDCWD, QFile::encodeName(fileName).constData(), times, 0) == 0);
+
+    const StatFileInfo info(fileName);
+    QVERIFY(info.exists());
+    QVERIFY(info.statFields() & StatFileInfo::FullStats);
+    QCOMPARE(info.lastAccessedNs(), Q_INT64_C(1500000000123456789));
+    QCOMPARE(info.lastModifiedNs(), Q_INT64_C(1600000000987654321));
+    QCOMPARE(info.lastModified(), QDateTime::fromMSecsSinceEpoch(Q_INT64_C(1600000000987)));
+    if (info.statFields() & StatFileInfo::BirthTime)
+        QVERIFY(info.birthTimeNs() > 0);
+    QVERIFY(info.created().isValid());
+
+    // a change that a millisecond timestamp would not show
+    times[1].tv_nsec = 987654322;
+    QVERIFY(utimensat(AT_FDCWD, QFile::encodeName(fileName).constData(), times, 0) == 0);
+    QVERIFY(StatFileInfo(fileName) != info);
+
+    // restored information compares equal to freshly read information
+    const StatFileInfo current(fileName);
+    QVERIFY(StatFileInfo(fileName, current.lstatData(), current.statData(), QMimeType()) == current);
+
+    QVERIFY(file.remove());
+}
+
+void Ut_FileModel::testDirectoryIndex()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QDir dir(directory.path());
+
+    for (int i = 0; i < DirectoryIndex::MinimumEntries + 10; ++i) {
+        QFile file(dir.filePath(QStringLiteral("file%1.txt").arg(i)));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray(i, 'x'));
+    }
+
+    const DirectoryIndex::Stamp stamp = DirectoryIndex::stamp(dir.absolutePath());
+    QVERIFY(stamp.isValid());
+    QVector<StatFileInfo> entries;
+    foreach (const QString &name, dir.entryList(QDir::Files))
+        entries.append(StatFileInfo(dir.filePath(name)));
+
+    // the listing reads back as it was saved
+    QVERIFY(DirectoryIndex::save(dir, stamp, entries).result());
+    QVector<StatFileInfo> loaded;
+    QVERIFY(DirectoryIndex::load(dir, &loaded));
+    QCOMPARE(loaded.count(), entries.count());
+    for (int i = 0; i < entries.count(); ++i) {
+        QCOMPARE(loaded.at(i).fileName(), entries.at(i).fileName());
+        QCOMPARE(loaded.at(i).size(), entries.at(i).size());
+        QCOMPARE(loaded.at(i).mimeType(), entries.at(i).mimeType());
+        QVERIFY(loaded.at(i) == entries.at(i));
+    }
+
+    // an unchanged listing is not written again, a changed one is
+    QVERIFY(!DirectoryIndex::save(dir, stamp, entries).result());
+    entries.removeLast();
+    QVERIFY(DirectoryIndex::save(dir, stamp, entries).result());
+    QVERIFY(DirectoryIndex::load(dir, &loaded));
+    QCOMPARE(loaded.count(), entries.count());
+
+    // the index of another state of the directory is rejected
+    const QByteArray data = DirectoryIndex::serialize(dir, stamp, entries);
+    DirectoryIndex::Stamp stale = stamp;
+    stale.modified += 1;
+    QVERIFY(!DirectoryIndex::deserialize(data, dir, stale, &loaded));
+    QVERIFY(DirectoryIndex::deserialize(data, dir, stamp, &loaded));
+
+    struct timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = 1000000000;
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    QVERIFY(utimensat(AT_FDCWD, QFile::encodeName(dir.absolutePath()).constData(), times, 0) == 0);
+    QVERIFY(!DirectoryIndex::load(dir, &loaded));
+
+    // and removed, it isn't there when the directory is back in the state it was saved in
+    times[1].tv_sec = stamp.modified / 1000000000;
+    times[1].tv_nsec = stamp.modified % 1000000000;
+    QVERIFY(utimensat(AT_FDCWD, QFile::encodeName(dir.absolutePath()).constData(), times, 0) == 0);
+    QCOMPARE(DirectoryIndex::stamp(dir.absolutePath()).modified, stamp.modified);
+    QVERIFY(!DirectoryIndex::load(dir, &loaded));
+
+    // beyond the maximum, the least recently used indexes are removed
+    QList<QSharedPointer<QTemporaryDir> > others;
+    for (int i = 0; i < DirectoryIndex::MaximumIndexes; ++i) {
+        others.append(QSharedPointer<QTemporaryDir>(new QTemporaryDir));
+        const QDir other(others.last()->path());
+        QVERIFY(DirectoryIndex::save(other, DirectoryIndex::stamp(other.absolutePath()), entries).result());
+    }
+    const QDir indexes(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                       + QStringLiteral("/directoryindex"));
+    QCOMPARE(indexes.entryList(QStringList() << QStringLiteral("*.idx"), QDir::Files).count(),
+             int(DirectoryIndex::MaximumIndexes));
+}
+
+void Ut_FileModel::testTreeWatcher()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QDir root(directory.path());
+    QVERIFY(root.mkpath(QStringLiteral("a/b/c")));
+    QVERIFY(root.mkpath(QStringLiteral("d")));
+    QFile file(root.filePath(QStringLiteral("a/b/file")));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    TreeWatcher watcher;
+    watcher.setEvents(InotifyWatcher::ChangeEvents);
+    QSignalSpy spy(&watcher, &TreeWatcher::directoryChanged);
+    watcher.addPath(directory.path());
+    QTRY_COMPARE(watcher.watchCount(), 5);
+
+    // writes to the files are reported when asked for
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("content");
+    file.close();
+    QTRY_VERIFY(spy.contains(QVariantList() << root.filePath(QStringLiteral("a/b"))));
+
+    // changes deep in the tree are reported, and new directories are watched
+    QVERIFY(root.mkdir(QStringLiteral("a/b/c/e")));
+    QTRY_VERIFY(spy.contains(QVariantList() << root.filePath(QStringLiteral("a/b/c"))));
+    QTRY_COMPARE(watcher.watchCount(), 6);
+
+    // out of budget, the least active subtree is polled instead
+    TreeWatcher::setWatchBudget(InotifyWatcher::instance()->watchCount());
+    watcher.setPollInterval(100);
+    QVERIFY(root.mkdir(QStringLiteral("d/f")));
+    QTRY_COMPARE(watcher.polledCount(), 1);
+    QCOMPARE(watcher.watchCount(), 3);
+
+    // let the first poll record the state of the subtree
+    QTest::qWait(500);
+    spy.clear();
+    QVERIFY(root.mkdir(QStringLiteral("a/b/g")));
+    QTRY_VERIFY(spy.contains(QVariantList() << root.filePath(QStringLiteral("a"))));
+
+    TreeWatcher::setWatchBudget(-1);
+}
+
+void Ut_FileModel::testDirectoryPoller()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    DirectoryPoller poller;
+    QSignalSpy spy(&poller, &DirectoryPoller::directoryChanged);
+    poller.setActive(true);
+    poller.setPath(directory.path());
+
+    // the interval backs off once the first signature has been taken
+    QTRY_VERIFY(poller.interval() > 1000);
+    QVERIFY(spy.isEmpty());
+
+    QVERIFY(QDir(directory.path()).mkdir(QStringLiteral("a")));
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().first().toString(), directory.path());
+    QCOMPARE(poller.interval(), 1000);
+
+    // nothing is polled while inactive, the changes are picked up on resume
+    poller.setActive(false);
+    QVERIFY(QDir(directory.path()).rmdir(QStringLiteral("a")));
+    QTest::qWait(1500);
+    QCOMPARE(spy.count(), 1);
+    poller.setActive(true);
+    QTRY_COMPARE(spy.count(), 2);
+
+    poller.setPath(QString());
+    QVERIFY(QDir(directory.path()).mkdir(QStringLiteral("b")));
+    QTest::qWait(1500);
+    QCOMPARE(spy.count(), 2);
+}
+
+void Ut_FileModel::testSuspendedWatchers()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QDir dir(directory.path());
+
+    FileModel model;
+    model.setPath(directory.path());
+    model.setActive(true);
+    QTRY_VERIFY(model.populated());
+    QCOMPARE(model.count(), 0);
+
+    // the cache watches through the same watcher
+    StatCache *cache = StatCache::instance();
+    const QString cachedName = dir.filePath(QStringLiteral("file0"));
+    QVERIFY(!cache->fileInfo(cachedName, false).exists());
+
+    InotifyWatcher *watcher = InotifyWatcher::instance();
+    watcher->setSuspended(true);
+    const int wakeups = watcher->wakeupCount();
+
+    // the changes wake nobody up while suspended
+    for (int i = 0; i < 10; ++i) {
+        QFile file(dir.filePath(QStringLiteral("file%1").arg(i)));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("content");
+    }
+    QVERIFY(dir.mkdir(QStringLiteral("directory")));
+    QTest::qWait(500);
+    QCOMPARE(watcher->wakeupCount(), wakeups);
+    QCOMPARE(model.count(), 0);
+    // nor does the cache answer for the files it hasn't heard about
+    StatFileInfo cached;
+    QVERIFY(!cache->lookup(cachedName, false, &cached));
+    QVERIFY(cache->fileInfo(cachedName, false).exists());
+
+    // and are caught up with at once on resume
+    watcher->setSuspended(false);
+    QCOMPARE(watcher->wakeupCount(), wakeups + 1);
+    QTRY_COMPARE(model.count(), 11);
+    QVERIFY(cache->fileInfo(cachedName, false).exists());
+}
+
+void Ut_FileModel::benchmarkData()
+{
+    FileModel model;
+    populate(&model);
+    if (QTest::currentTestFailed())
+        return;
+
+    const QList<int> roles = statFileInfoRoles();
+    int calls = 0;
+    int allocations = 0;
+
+    QBENCHMARK {
+        g_allocations = 0;
+        g_count_allocations = true;
+        for (int row = 0; row < model.count(); ++row) {
+            foreach (int role, roles)
+                model.data(model.index(row), role);
+        }
+        g_count_allocations = false;
+
+        calls = model.count() * roles.count();
+        allocations = g_allocations;
+    }
+
+    qDebug() << calls << "data() calls per iteration," << double(allocations) / calls << "allocations per call";
+}
+
+QTEST_MAIN(Ut_FileModel)
@@ -0,0 +1,58 @@
+include (../common.pri)
+
+QT += testlib qml concurrent
+QT -= gui
+
+TEMPLATE = app
+TARGET = ut_filemodel
+
+target.path = /opt/tests/$${PACKAGENAME}
+
+contains(cov, true) {
+    message("Coverage options enabled")
+    QMAKE_CXXFLAGS += --coverage
+    QMAKE_LFLAGS += --coverage
+}
+
+CONFIG += link_prl
+DEFINES += UNIT_TEST
+QMAKE_EXTRA_TARGETS = check
+
+check.depends = $$TARGET
+check.commands = LD_LIBRARY_PATH=../../../$$[QT_INSTALL_LIBS] ./$$TARGET
+
+INCLUDEPATH += ../../src/plugin/ ../../src/shared/
+
+SOURCES += ut_filemodel.cpp
+HEADERS += ut_filemodel.h
+
+SOURCES += ../../src/plugin/archiveinfo.cpp \
+    ../../src/plugin/directoryindex.cpp \
+    ../../src/plugin/directorypoller.cpp \
+    ../../src/plugin/directorysize.cpp \
+    ../../src/plugin/fileinfobatch.cpp \
+    ../../src/plugin/fileinforesolver.cpp \
+    ../../src/plugin/filemodel.cpp \
+    ../../src/plugin/inotifywatcher.cpp \
+    ../../src/plugin/statcache.cpp \
+    ../../src/plugin/statfileinfo.cpp \
+    ../../src/plugin/treewatcher.cpp \
+    ../../src/shared/directoryreader.cpp \
+    ../../src/shared/trash.cpp \
+    ../../src/shared/treeremover.cpp
+HEADERS += ../../src/plugin/archiveinfo.h \
+    ../../src/plugin/directoryindex.h \
+    ../../src/plugin/directorypoller.h \
+    ../../src/plugin/directorysize.h \
+    ../../src/plugin/fileinfobatch.h \
+    ../../src/plugin/fileinforesolver.h \
+    ../../src/plugin/filemodel.h \
+    ../../src/plugin/inotifywatcher.h \
+    ../../src/plugin/statcache.h \
+    ../../src/plugin/statfileinfo.h \
+    ../../src/plugin/treewatcher.h \
+    ../../src/shared/directoryreader.h \
+    ../../src/shared/trash.h \
+    ../../src/shared/treeremover.h
+
+INSTALLS += target
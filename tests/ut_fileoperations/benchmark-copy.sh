@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# Runs the copy benchmarks of ut_fileoperations on tmpfs, and on ext4 and btrfs loop images.
+# Needs root for mounting, and mkfs.ext4 and mkfs.btrfs for the images.
+
+set -e
+
+TEST=$(dirname "$0")/ut_fileoperations
+WORK=$(mktemp -d /tmp/ut_fileoperations.XXXXXX)
+SIZE=1G
+
+cleanup() {
+    for mount in "$WORK"/mnt-*; do
+        umount "$mount" 2>/dev/null || true
+    done
+    rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+run() {
+    echo "== $1"
+    UT_FILEOPERATIONS_DIR="$2" "$TEST" benchmarkCopy
+    UT_FILEOPERATIONS_DIR="$2" "$TEST" benchmarkCopyLatency
+}
+
+mkdir "$WORK/mnt-tmpfs"
+mount -t tmpfs -o size=$SIZE tmpfs "$WORK/mnt-tmpfs"
+run tmpfs "$WORK/mnt-tmpfs"
+
+for fs in ext4 btrfs; do
+    if ! command -v mkfs.$fs >/dev/null; then
+        echo "== $fs: mkfs.$fs not available, skipped"
+        continue
+    fi
+    truncate -s $SIZE "$WORK/$fs.img"
+    mkfs.$fs -q "$WORK/$fs.img" >/dev/null
+    mkdir "$WORK/mnt-$fs"
+    mount -o loop "$WORK/$fs.img" "$WORK/mnt-$fs"
+    run $fs "$WORK/mnt-$fs"
+done
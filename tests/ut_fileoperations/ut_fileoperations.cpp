@@ -0,0 +1,923 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "copypipeline.h"
+#include "fileoperations.h"
+#include "trash.h"
+#include "treeremover.h"
+#include "treescanner.h"
+#include "uringengine.h"
+
+#include "ut_fileoperations.h"
+
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QUrl>
+#include <QVector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Q_DECLARE_METATYPE(FileOperations::CopyMethod)
+Q_DECLARE_METATYPE(CopyPipeline::Backend)
+
+static const qint64 BenchmarkSize = 256 * 1024 * 1024;
+
+static QByteArray testData(qint64 size)
+{
+    QByteArray rv(int(size), Qt::Uninitialized);
+    char *data = rv.data();
+    for (qint64 i = 0; i < size; ++i)
+        data[i] = char((i * 7 + i / 4096) & 0xff);
+    return rv;
+}
+
+static bool writeFile(const QString &fileName, const QByteArray &data)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+static QByteArray readFile(const QString &fileName)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+static bool writeLargeFile(const QString &fileName, qint64 size)
+{
+    if (QFileInfo(fileName).size() == size)
+        return true;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    const QByteArray data = testData(4 * 1024 * 1024);
+    for (qint64 written = 0; written < size; written += data.size()) {
+        if (file.write(data) != data.size())
+            return false;
+    }
+    return true;
+}
+
+// reads a page of a cached file every few milliseconds, as an application would while a copy runs
+class LatencyProbe : public QThread
+{
+public:
+    static const int Interval = 10; // ms
+
+    explicit LatencyProbe(const QString &fileName)
+        : m_fileName(fileName), m_maximum(0), m_total(0), m_count(0) {}
+
+    void stop() { m_stopped.storeRelease(1); }
+
+    // the delay over the interval, in microseconds
+    qint64 maximum() const { return m_maximum; }
+    qint64 mean() const { return m_count > 0 ? m_total / m_count : 0; }
+
+protected:
+    void run() override
+    {
+        const int fd = open(QFile::encodeName(m_fileName).constData(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < 4096)
+            return;
+
+        char page[4096];
+        const qint64 pages = st.st_size / 4096;
+        while (!m_stopped.loadAcquire()) {
+            QElapsedTimer timer;
+            timer.start();
+            usleep(Interval * 1000);
+            if (pread(fd, page, sizeof(page), (m_count * 7919 % pages) * 4096) < 0)
+                break;
+            const qint64 delay = qMax<qint64>(0, timer.nsecsElapsed() / 1000 - Interval * 1000);
+            m_maximum = qMax(m_maximum, delay);
+            m_total += delay;
+            ++m_count;
+        }
+        close(fd);
+    }
+
+private:
+    const QString m_fileName;
+    QAtomicInt m_stopped;
+    qint64 m_maximum;
+    qint64 m_total;
+    qint64 m_count;
+};
+
+// the share of a file in the page cache
+static double cachedShare(const QString &fileName)
+{
+    const int fd = open(QFile::encodeName(fileName).constData(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        if (fd >= 0)
+            close(fd);
+        return 0;
+    }
+
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return 0;
+
+    const qint64 pages = (st.st_size + 4095) / 4096;
+    QVector<unsigned char> residency(int(pages));
+    qint64 cached = 0;
+    if (mincore(map, st.st_size, residency.data()) == 0) {
+        for (unsigned char page : residency)
+            cached += page & 1;
+    }
+    munmap(map, st.st_size);
+    return double(cached) / pages;
+}
+
+void Ut_FileOperations::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+}
+
+// set UT_FILEOPERATIONS_DIR to benchmark another file system, see benchmark-copy.sh
+QString Ut_FileOperations::directory() const
+{
+    const QString path = QString::fromLocal8Bit(qgetenv("UT_FILEOPERATIONS_DIR"));
+    return path.isEmpty() ? m_directory.path() : path;
+}
+
+void Ut_FileOperations::testCopyData_data()
+{
+    QTest::addColumn<FileOperations::CopyMethod>("preferred");
+    QTest::addColumn<int>("size");
+
+    const char *names[] = { "clone", "copy_file_range", "sendfile", "read/write", "direct" };
+    const FileOperations::CopyMethod methods[] = {
+        FileOperations::CloneCopy,
+        FileOperations::CopyFileRange,
+        FileOperations::SendFileCopy,
+        FileOperations::ReadWriteCopy,
+        FileOperations::DirectCopy
+    };
+
+    // empty, smaller than and not a multiple of the read/write buffer, and large enough to be
+    // flushed behind the copy
+    const int sizes[] = { 0, 1, 3 * 1024 * 1024 + 7, 33 * 1024 * 1024 + 7 };
+
+    for (int i = 0; i < 5; ++i) {
+        for (int size : sizes) {
+            const QByteArray name = QByteArray(names[i]) + ' ' + QByteArray::number(size);
+            QTest::newRow(name.constData()) << methods[i] << size;
+        }
+    }
+}
+
+void Ut_FileOperations::testCopyData()
+{
+    QFETCH(FileOperations::CopyMethod, preferred);
+    QFETCH(int, size);
+
+    const QByteArray data = testData(size);
+    const QString source = m_directory.path() + QStringLiteral("/source");
+    const QString target = m_directory.path() + QStringLiteral("/target");
+    QVERIFY(writeFile(source, data));
+    QFile::remove(target);
+
+    const int srcFd = open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+    QVERIFY(srcFd >= 0);
+    const int destFd = open(QFile::encodeName(target).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    QVERIFY(destFd >= 0);
+
+    FileOperations::CopyMethod method = FileOperations::NoCopy;
+    const bool ok = FileOperations::copyData(srcFd, destFd, &method, preferred);
+    close(destFd);
+    close(srcFd);
+
+    QVERIFY(ok);
+    // a method is skipped only if it doesn't work for the files
+    QVERIFY(method >= preferred
+            || (preferred == FileOperations::DirectCopy && method == FileOperations::ReadWriteCopy));
+    QCOMPARE(readFile(target), data);
+}
+
+void Ut_FileOperations::testCopyOverwrite()
+{
+    const QByteArray data = testData(100000);
+    const QString source = m_directory.path() + QStringLiteral("/overwrite-source");
+    const QString target = m_directory.path() + QStringLiteral("/overwrite-target");
+    QVERIFY(writeFile(source, data));
+    QVERIFY(chmod(QFile::encodeName(source).constData(), 0640) == 0);
+    QVERIFY(writeFile(target, QByteArray("previous content, longer than nothing")));
+
+    FileOperations::CopyMethod method = FileOperations::NoCopy;
+    QVERIFY(FileOperations::copyOverwrite(source, target, &method));
+    QVERIFY(method != FileOperations::NoCopy);
+    QCOMPARE(readFile(target), data);
+    QCOMPARE(QFileInfo(target).permissions(), QFileInfo(source).permissions());
+
+    // missing sources leave nothing behind
+    QVERIFY(!FileOperations::copyOverwrite(m_directory.path() + QStringLiteral("/missing"), target));
+    QVERIFY(!QFile::exists(target));
+}
+
+void Ut_FileOperations::testCopySparse_data()
+{
+    QTest::addColumn<FileOperations::CopyMethod>("preferred");
+
+    QTest::newRow("clone") << FileOperations::CloneCopy;
+    QTest::newRow("copy_file_range") << FileOperations::CopyFileRange;
+    QTest::newRow("sendfile") << FileOperations::SendFileCopy;
+    QTest::newRow("read/write") << FileOperations::ReadWriteCopy;
+    QTest::newRow("direct") << FileOperations::DirectCopy;
+}
+
+void Ut_FileOperations::testCopySparse()
+{
+    QFETCH(FileOperations::CopyMethod, preferred);
+
+    // data at the start, unaligned in the middle, and a hole at the end
+    const qint64 size = 40 * 1024 * 1024 + 5;
+    const QString source = m_directory.path() + QStringLiteral("/sparse-source");
+    const QString target = m_directory.path() + QStringLiteral("/sparse-target");
+    QFile::remove(source);
+    QFile::remove(target);
+    {
+        QFile file(source);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QVERIFY(file.write(testData(1000)) == 1000);
+        QVERIFY(file.seek(3 * 1024 * 1024 + 7));
+        QVERIFY(file.write(testData(300000)) == 300000);
+        QVERIFY(file.seek(36 * 1024 * 1024));
+        QVERIFY(file.write(testData(4096)) == 4096);
+        QVERIFY(file.resize(size));
+    }
+
+    struct stat64 sourceStat;
+    QVERIFY(stat64(QFile::encodeName(source).constData(), &sourceStat) == 0);
+    if (sourceStat.st_blocks * 512 >= size)
+        QSKIP("No holes on this file system");
+
+    const int srcFd = open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+    QVERIFY(srcFd >= 0);
+    const int destFd = open(QFile::encodeName(target).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    QVERIFY(destFd >= 0);
+
+    qint64 bytes = 0;
+    const bool ok = FileOperations::copyData(srcFd, destFd, nullptr, preferred, [&bytes](qint64 length) { bytes += length; });
+    close(destFd);
+    close(srcFd);
+
+    QVERIFY(ok);
+    // the holes count as copied
+    QCOMPARE(bytes, size);
+    QCOMPARE(readFile(target), readFile(source));
+
+    // no more allocated than the data takes, give or take the blocks it starts and ends in
+    struct stat64 targetStat;
+    QVERIFY(stat64(QFile::encodeName(target).constData(), &targetStat) == 0);
+    QCOMPARE(qint64(targetStat.st_size), size);
+    QVERIFY2(targetStat.st_blocks <= sourceStat.st_blocks + 6 * 4096 / 512,
+             qPrintable(QStringLiteral("%1 blocks for %2").arg(targetStat.st_blocks).arg(sourceStat.st_blocks)));
+}
+
+void Ut_FileOperations::testProgress()
+{
+    QDir root(m_directory.path());
+    QVERIFY(root.mkpath(QStringLiteral("progress/tree/sub")));
+    QVERIFY(root.mkpath(QStringLiteral("progress/target")));
+    const QString tree = root.filePath(QStringLiteral("progress/tree"));
+    const QByteArray data = testData(2 * 1024 * 1024);
+    for (int i = 0; i < 20; ++i)
+        QVERIFY(writeFile(tree + (i % 2 ? QStringLiteral("/sub/file%1") : QStringLiteral("/file%1")).arg(i), data));
+    const QString single = root.filePath(QStringLiteral("progress/single"));
+    QVERIFY(writeFile(single, data));
+
+    QList<FileOperations::Progress> reports;
+    const FileOperations::ProgressFunc progress = [&reports](const FileOperations::Progress &progress) {
+        reports.append(progress);
+    };
+
+    const QStringList paths = QStringList() << tree << single;
+    const QString target = root.filePath(QStringLiteral("progress/target"));
+    QCOMPARE(FileOperations::copyFiles(paths, target, FileOperations::PathResultFunc(),
+                                       FileOperations::ContinueFunc(), progress),
+             FileEngine::NoError);
+
+    // progress never goes back, and the totals are known by the end
+    QVERIFY(reports.count() >= 2);
+    QCOMPARE(reports.first().bytesDone, qint64(0));
+    for (int i = 1; i < reports.count(); ++i) {
+        QVERIFY(reports.at(i).bytesDone >= reports.at(i - 1).bytesDone);
+        QVERIFY(reports.at(i).filesDone >= reports.at(i - 1).filesDone);
+        QVERIFY(reports.at(i).bytesTotal >= reports.at(i).bytesDone);
+    }
+    QCOMPARE(reports.last().bytesTotal, qint64(21) * data.size());
+    QCOMPARE(reports.last().filesTotal, 21);
+    QCOMPARE(reports.last().bytesDone, reports.last().bytesTotal);
+    QCOMPARE(reports.last().filesDone, reports.last().filesTotal);
+    QVERIFY(reports.last().currentPath.isEmpty());
+    QCOMPARE(reports.last().secondsRemaining, qint64(0));
+
+    // deleting counts the files in the trees
+    reports.clear();
+    QCOMPARE(FileOperations::deleteFiles(QStringList() << target, FileOperations::PathResultFunc(),
+                                         FileOperations::ContinueFunc(), progress),
+             FileEngine::NoError);
+    QCOMPARE(reports.last().filesDone, 21);
+    QCOMPARE(reports.last().filesTotal, 21);
+}
+
+void Ut_FileOperations::testTreeScanner()
+{
+    QDir root(m_directory.path());
+    QVERIFY(root.mkpath(QStringLiteral("scan/a/b/c")));
+    QVERIFY(root.mkpath(QStringLiteral("scan/d/.hidden")));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("scan/a/file")), QByteArray(1000, 'a')));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("scan/a/b/c/file")), QByteArray(2000, 'c')));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("scan/d/.hidden/file")), QByteArray(4000, 'h')));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("scan/d/.file")), QByteArray(8000, 'h')));
+    QVERIFY(QFile::link(root.filePath(QStringLiteral("scan/a")), root.filePath(QStringLiteral("scan/d/link"))));
+    // not copied, so not counted
+    QVERIFY(mkfifo(QFile::encodeName(root.filePath(QStringLiteral("scan/a/fifo"))).constData(), 0600) == 0);
+    const QString single = root.filePath(QStringLiteral("scan-single"));
+    QVERIFY(writeFile(single, QByteArray(16000, 's')));
+
+    const QStringList paths = QStringList() << root.filePath(QStringLiteral("scan")) << single;
+
+    // the link is counted as a file and not followed
+    TreeScanner scanner(paths);
+    scanner.start();
+    QVERIFY(scanner.waitForFinished());
+    QVERIFY(scanner.isFinished());
+    QCOMPARE(scanner.totals().bytes, qint64(19000));
+    QCOMPARE(scanner.totals().files, 4);
+    QCOMPARE(scanner.totals().directories, 5);
+
+    TreeScanner hidden(paths, true);
+    hidden.start();
+    QVERIFY(hidden.waitForFinished());
+    QCOMPARE(hidden.totals().bytes, qint64(31000));
+    QCOMPARE(hidden.totals().files, 6);
+    QCOMPARE(hidden.totals().directories, 6);
+
+    // cancelled through the continue function, and destroyed while the walkers may still run
+    TreeScanner cancelled(QStringList() << QStringLiteral("/usr"));
+    cancelled.start();
+    cancelled.waitForFinished([]() { return false; });
+}
+
+void Ut_FileOperations::testCopyPipeline()
+{
+    QDir root(m_directory.path());
+    QVERIFY(root.mkpath(QStringLiteral("pipeline/a/b")));
+    QVERIFY(root.mkpath(QStringLiteral("pipeline/readonly")));
+    QVERIFY(root.mkpath(QStringLiteral("pipeline/.hidden")));
+    for (int i = 0; i < 100; ++i) {
+        const QByteArray data = testData(i * 100);
+        QVERIFY(writeFile(root.filePath(QStringLiteral("pipeline/a/b/file%1").arg(i)), data));
+    }
+    QVERIFY(writeFile(root.filePath(QStringLiteral("pipeline/readonly/file")), QByteArray(1000, 'r')));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("pipeline/.file")), QByteArray(1000, 'h')));
+    QVERIFY(QFile::link(root.filePath(QStringLiteral("pipeline/a")), root.filePath(QStringLiteral("pipeline/link"))));
+    const QByteArray readOnly = QFile::encodeName(root.filePath(QStringLiteral("pipeline/readonly")));
+    QCOMPARE(chmod(readOnly.constData(), 0555), 0);
+
+    QAtomicInt started;
+    QAtomicInt copied;
+    CopyPipeline pipeline(root.filePath(QStringLiteral("pipeline")), root.filePath(QStringLiteral("pipeline-copy")));
+    pipeline.setConcurrency(4);
+    pipeline.setProgressFuncs([&started](const QString &) { started.ref(); },
+                              FileOperations::BytesFunc(),
+                              [&copied](const QString &) { copied.ref(); });
+    QVERIFY(pipeline.run());
+    QCOMPARE(started.load(), 102);
+    QCOMPARE(copied.load(), 102);
+
+    for (int i = 0; i < 100; ++i)
+        QCOMPARE(readFile(root.filePath(QStringLiteral("pipeline-copy/a/b/file%1").arg(i))), testData(i * 100));
+    QCOMPARE(readFile(root.filePath(QStringLiteral("pipeline-copy/readonly/file"))), QByteArray(1000, 'r'));
+
+    // the permissions of the directories are applied once they are filled
+    const QByteArray copiedReadOnly = QFile::encodeName(root.filePath(QStringLiteral("pipeline-copy/readonly")));
+    struct stat st;
+    QCOMPARE(stat(copiedReadOnly.constData(), &st), 0);
+    QCOMPARE(int(st.st_mode & 0777), 0555);
+    chmod(copiedReadOnly.constData(), 0755);
+    chmod(readOnly.constData(), 0755);
+
+    // links are copied as links and hidden files are skipped
+    QVERIFY(QFileInfo(root.filePath(QStringLiteral("pipeline-copy/link"))).isSymLink());
+    QVERIFY(!QFileInfo::exists(root.filePath(QStringLiteral("pipeline-copy/.file"))));
+    QVERIFY(!QFileInfo::exists(root.filePath(QStringLiteral("pipeline-copy/.hidden"))));
+
+    // cancelled before the first file
+    CopyPipeline cancelled(root.filePath(QStringLiteral("pipeline")), root.filePath(QStringLiteral("pipeline-cancelled")));
+    QVERIFY(!cancelled.run([]() { return false; }));
+    QVERIFY(!QFileInfo::exists(root.filePath(QStringLiteral("pipeline-cancelled/a/b/file0"))));
+}
+
+void Ut_FileOperations::testMovePipeline()
+{
+    QDir root(m_directory.path());
+    QVERIFY(root.mkpath(QStringLiteral("move/a/b")));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("move/file")), testData(5000)));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("move/.hidden")), testData(100)));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("move/a/b/file")), testData(7000)));
+
+    // on the same file system the subtrees are renamed, only the files at the top are copied
+    int copied = 0;
+    CopyPipeline pipeline(root.filePath(QStringLiteral("move")), root.filePath(QStringLiteral("move-target")));
+    pipeline.setConcurrency(1);
+    pipeline.setRemoveSources(true);
+    pipeline.setProgressFuncs(CopyPipeline::FileFunc(), FileOperations::BytesFunc(),
+                              [&copied](const QString &) { ++copied; });
+    QVERIFY(pipeline.run());
+    QCOMPARE(copied, 2);
+
+    QVERIFY(!QFileInfo::exists(root.filePath(QStringLiteral("move"))));
+    QCOMPARE(readFile(root.filePath(QStringLiteral("move-target/file"))), testData(5000));
+    QCOMPARE(readFile(root.filePath(QStringLiteral("move-target/.hidden"))), testData(100));
+    QCOMPARE(readFile(root.filePath(QStringLiteral("move-target/a/b/file"))), testData(7000));
+
+    // a source is only removed once its copy is complete
+    QVERIFY(writeFile(root.filePath(QStringLiteral("move-source")), testData(100)));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("move-partial")), testData(50)));
+    QVERIFY(!CopyPipeline::removeCopied(root.filePath(QStringLiteral("move-source")),
+                                        root.filePath(QStringLiteral("move-partial"))));
+    QVERIFY(QFileInfo::exists(root.filePath(QStringLiteral("move-source"))));
+}
+
+void Ut_FileOperations::testMoveAcrossDevices()
+{
+    QTemporaryDir other(QStringLiteral("/dev/shm/ut_fileoperations-XXXXXX"));
+    struct stat here;
+    struct stat there;
+    if (!other.isValid() || stat(QFile::encodeName(m_directory.path()).constData(), &here) != 0
+            || stat(QFile::encodeName(other.path()).constData(), &there) != 0 || here.st_dev == there.st_dev) {
+        QSKIP("No second file system to move to");
+    }
+
+    QDir root(m_directory.path());
+    QVERIFY(root.mkpath(QStringLiteral("cross/a/.b")));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("cross/a/.b/file")), testData(9000)));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("cross-file")), testData(3000)));
+
+    const QStringList paths = QStringList() << root.filePath(QStringLiteral("cross"))
+                                            << root.filePath(QStringLiteral("cross-file"));
+    QList<FileOperations::Progress> reports;
+    QCOMPARE(FileOperations::moveFiles(paths, other.path(), FileOperations::PathResultFunc(),
+                                       FileOperations::ContinueFunc(),
+                                       [&reports](const FileOperations::Progress &progress) { reports.append(progress); }),
+             FileEngine::NoError);
+
+    QVERIFY(!QFileInfo::exists(paths.at(0)));
+    QVERIFY(!QFileInfo::exists(paths.at(1)));
+    QCOMPARE(readFile(other.path() + QStringLiteral("/cross/a/.b/file")), testData(9000));
+    QCOMPARE(readFile(other.path() + QStringLiteral("/cross-file")), testData(3000));
+    QCOMPARE(reports.last().bytesDone, qint64(12000));
+    QCOMPARE(reports.last().filesDone, 2);
+
+    // the sources that could not be copied stay where they were, a directory is in the way
+    QVERIFY(root.mkpath(QStringLiteral("cross-tree")));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("cross-tree/file")), testData(4000)));
+    QVERIFY(QDir(other.path()).mkpath(QStringLiteral("cross-tree/file/occupied")));
+    QCOMPARE(FileOperations::moveFiles(QStringList() << root.filePath(QStringLiteral("cross-tree")), other.path()),
+             FileEngine::ErrorMoveFailed);
+    QCOMPARE(readFile(root.filePath(QStringLiteral("cross-tree/file"))), testData(4000));
+
+    QVERIFY(writeFile(root.filePath(QStringLiteral("cross-kept")), testData(2000)));
+    QVERIFY(QDir(other.path()).mkpath(QStringLiteral("cross-kept/occupied")));
+    QCOMPARE(FileOperations::moveFiles(QStringList() << root.filePath(QStringLiteral("cross-kept")), other.path()),
+             FileEngine::ErrorMoveFailed);
+    QCOMPARE(readFile(root.filePath(QStringLiteral("cross-kept"))), testData(2000));
+}
+
+void Ut_FileOperations::testTreeRemover()
+{
+    QDir root(m_directory.path());
+    QVERIFY(root.mkpath(QStringLiteral("remove/a/b/c")));
+    QVERIFY(root.mkpath(QStringLiteral("remove/.d/e")));
+    QVERIFY(root.mkpath(QStringLiteral("remove-kept")));
+    for (int i = 0; i < 50; ++i) {
+        QVERIFY(writeFile(root.filePath(QStringLiteral("remove/a/b/c/file%1").arg(i)), QByteArray(10, 'c')));
+        QVERIFY(writeFile(root.filePath(QStringLiteral("remove/.d/e/.file%1").arg(i)), QByteArray(10, 'e')));
+    }
+    QVERIFY(writeFile(root.filePath(QStringLiteral("remove-kept/file")), QByteArray(10, 'k')));
+    QVERIFY(QFile::link(root.filePath(QStringLiteral("remove-kept")), root.filePath(QStringLiteral("remove/a/link"))));
+
+    QAtomicInt removed;
+    TreeRemover remover(root.filePath(QStringLiteral("remove")), [&removed](const QString &, bool ok) {
+        if (ok)
+            removed.ref();
+    });
+    QVERIFY(remover.run());
+    QCOMPARE(removed.load(), 101);
+    QVERIFY(!QFileInfo::exists(root.filePath(QStringLiteral("remove"))));
+    // the link was removed, not followed
+    QVERIFY(QFileInfo::exists(root.filePath(QStringLiteral("remove-kept/file"))));
+
+    // a single file
+    TreeRemover file(root.filePath(QStringLiteral("remove-kept/file")));
+    QVERIFY(file.run());
+    QVERIFY(!TreeRemover(root.filePath(QStringLiteral("remove-kept/file"))).run());
+}
+
+// the files to trash are made here, so that they are on the file system of the home trash
+static QString dataLocation()
+{
+    // not the user's own trash
+    QStandardPaths::setTestModeEnabled(true);
+    const QString location = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
+    return QDir().mkpath(location) ? location : QString();
+}
+
+void Ut_FileOperations::testTrash()
+{
+    const QString data = dataLocation();
+    QTemporaryDir home(data + QStringLiteral("/ut_fileoperations-XXXXXX"));
+    QVERIFY(home.isValid());
+    const QString trash = data + QStringLiteral("/Trash");
+
+    QDir root(home.path());
+    QVERIFY(root.mkpath(QStringLiteral("trash/a")));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("trash/a/file")), testData(100)));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("trash file%")), testData(200)));
+
+    // only set up when something is trashed, looking for it creates nothing
+    QVERIFY(QDir(trash).removeRecursively());
+    QVERIFY(Trash::existingLocation(root.path()).isEmpty());
+    QVERIFY(!QFileInfo::exists(trash));
+    QCOMPARE(Trash::location(root.path()), trash);
+    QCOMPARE(Trash::existingLocation(root.path()), trash);
+
+    const QString directory = root.filePath(QStringLiteral("trash"));
+    const QString trashedDirectory = Trash::moveToTrash(directory);
+    QVERIFY(trashedDirectory.startsWith(trash + QStringLiteral("/files/")));
+    QVERIFY(!QFileInfo::exists(directory));
+    QCOMPARE(readFile(trashedDirectory + QStringLiteral("/a/file")), testData(100));
+    QCOMPARE(Trash::originalPath(trashedDirectory), directory);
+
+    // the same name again, and a name that needs percent-encoding
+    QVERIFY(root.mkpath(QStringLiteral("trash")));
+    const QString again = Trash::moveToTrash(directory);
+    QVERIFY(!again.isEmpty());
+    QVERIFY(again != trashedDirectory);
+    QCOMPARE(Trash::originalPath(again), directory);
+
+    const QString file = root.filePath(QStringLiteral("trash file%"));
+    const QString trashedFile = Trash::moveToTrash(file);
+    QVERIFY(!trashedFile.isEmpty());
+    QCOMPARE(Trash::originalPath(trashedFile), file);
+    const QByteArray info = readFile(trash + QStringLiteral("/info/") + QFileInfo(trashedFile).fileName() + QStringLiteral(".trashinfo"));
+    QVERIFY(info.startsWith("[Trash Info]\n"));
+    QVERIFY(info.contains("\nPath=" + QUrl::toPercentEncoding(file, "/") + '\n'));
+    QVERIFY(info.contains("\nDeletionDate="));
+
+    // restored where it was, unless something else is there by now
+    QCOMPARE(Trash::trashedPath(file), trashedFile);
+    QVERIFY(writeFile(file, testData(1)));
+    QVERIFY(!Trash::restore(trashedFile));
+    QVERIFY(QFile::remove(file));
+    QVERIFY(Trash::restore(trashedFile));
+    QCOMPARE(readFile(file), testData(200));
+    QVERIFY(!QFileInfo::exists(trashedFile));
+    QVERIFY(Trash::trashedPath(file).isEmpty());
+
+    QCOMPARE(FileOperations::deleteFiles(QStringList() << file, FileOperations::PathResultFunc(),
+                                         FileOperations::ContinueFunc(), FileOperations::ProgressFunc(),
+                                         FileEngine::MoveToTrash),
+             FileEngine::NoError);
+    QVERIFY(!QFileInfo::exists(file));
+    QCOMPARE(FileOperations::restoreFiles(QStringList() << file), FileEngine::NoError);
+    QCOMPARE(readFile(file), testData(200));
+    QCOMPARE(FileOperations::restoreFiles(QStringList() << file), FileEngine::ErrorRestoreFailed);
+
+    for (const QString &path : QStringList() << trashedDirectory << again) {
+        QVERIFY(QDir(path).removeRecursively());
+        QVERIFY(QFile::remove(trash + QStringLiteral("/info/") + QFileInfo(path).fileName() + QStringLiteral(".trashinfo")));
+    }
+}
+
+void Ut_FileOperations::testDeleteInBackground()
+{
+    const QString data = dataLocation();
+    QTemporaryDir home(data + QStringLiteral("/ut_fileoperations-XXXXXX"));
+    QVERIFY(home.isValid());
+    const QString trash = data + QStringLiteral("/Trash");
+
+    QDir root(home.path());
+    QVERIFY(root.mkpath(QStringLiteral("purge/a/b")));
+    for (int i = 0; i < 200; ++i)
+        QVERIFY(writeFile(root.filePath(QStringLiteral("purge/a/b/file%1").arg(i)), QByteArray(10, 'p')));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("purge-file")), testData(100)));
+
+    const QStringList paths = QStringList() << root.filePath(QStringLiteral("purge"))
+                                            << root.filePath(QStringLiteral("purge-file"));
+    QList<FileOperations::Progress> reports;
+    QCOMPARE(FileOperations::deleteFiles(paths, FileOperations::PathResultFunc(), FileOperations::ContinueFunc(),
+                                         [&reports](const FileOperations::Progress &progress) { reports.append(progress); },
+                                         FileEngine::DeleteInBackground),
+             FileEngine::NoError);
+    QVERIFY(!QFileInfo::exists(paths.at(0)));
+    QVERIFY(!QFileInfo::exists(paths.at(1)));
+    QCOMPARE(reports.last().filesDone, 2);
+    QCOMPARE(reports.last().filesTotal, 2);
+
+    // gone from the trash as well once purged, and never restorable
+    QVERIFY(Trash::waitForPurged(30000));
+    QVERIFY(!Trash::isPurging());
+    const QStringList names(QStringLiteral("purge*"));
+    QVERIFY(QDir(trash + QStringLiteral("/files")).entryList(names, QDir::AllEntries | QDir::System).isEmpty());
+    QVERIFY(QDir(trash + QStringLiteral("/info")).entryList(names, QDir::AllEntries | QDir::System).isEmpty());
+    QCOMPARE(FileOperations::restoreFiles(paths), FileEngine::ErrorRestoreFailed);
+}
+
+void Ut_FileOperations::testUringEngine()
+{
+    if (!UringEngine::isAvailable())
+        QSKIP("io_uring not available");
+
+    QDir root(m_directory.path());
+    QVERIFY(root.mkpath(QStringLiteral("uring/a/b")));
+    QVERIFY(root.mkpath(QStringLiteral("uring-copy")));
+
+    // more files than are copied at once, and one left to the kernel copy
+    QVector<UringEngine::File> files;
+    for (int i = 0; i < 100; ++i) {
+        const UringEngine::File file = {
+            root.filePath(QStringLiteral("uring/a/b/file%1").arg(i)),
+            root.filePath(QStringLiteral("uring-copy/file%1").arg(i))
+        };
+        QVERIFY(writeFile(file.source, testData(i == 99 ? 3 * 1024 * 1024 + 7 : i * 4000)));
+        files.append(file);
+    }
+    // replaced
+    QVERIFY(writeFile(files.first().target, QByteArray(100, 'x')));
+
+    UringEngine engine;
+    QVERIFY(engine.isValid());
+
+    qint64 bytes = 0;
+    int copied = 0;
+    QVERIFY(engine.copyFiles(files, UringEngine::FileFunc(), [&bytes](qint64 length) { bytes += length; },
+                             [&copied](const QString &) { ++copied; }, FileOperations::ContinueFunc()));
+    QCOMPARE(copied, 100);
+    QCOMPARE(bytes, qint64(99 * 98 / 2 * 4000 + 3 * 1024 * 1024 + 7));
+    for (int i = 0; i < 100; ++i)
+        QCOMPARE(readFile(files.at(i).target), testData(i == 99 ? 3 * 1024 * 1024 + 7 : i * 4000));
+
+    // a missing source fails without leaving a target behind
+    const UringEngine::File missing = {
+        root.filePath(QStringLiteral("uring/missing")), root.filePath(QStringLiteral("uring-copy/missing"))
+    };
+    QVERIFY(!engine.copyFiles(QVector<UringEngine::File>() << missing, UringEngine::FileFunc(),
+                              FileOperations::BytesFunc(), UringEngine::FileFunc(), FileOperations::ContinueFunc()));
+    QVERIFY(!QFileInfo::exists(missing.target));
+
+    QVERIFY(QFile::link(root.filePath(QStringLiteral("uring-copy")), root.filePath(QStringLiteral("uring/link"))));
+
+    // a cancelled removal stops while collecting the tree, and so does the delete that uses it
+    const FileOperations::ContinueFunc cancelled = []() { return false; };
+    QVERIFY(!engine.removeTree(root.filePath(QStringLiteral("uring")), FileOperations::PathResultFunc(), cancelled));
+    QVERIFY(QFileInfo::exists(files.first().source));
+    QVERIFY(!FileOperations::deleteFile(root.filePath(QStringLiteral("uring")), FileOperations::PathResultFunc(), cancelled));
+    QVERIFY(QFileInfo::exists(files.first().source));
+
+    QVERIFY(engine.removeTree(root.filePath(QStringLiteral("uring"))));
+    QVERIFY(!QFileInfo::exists(root.filePath(QStringLiteral("uring"))));
+    // the link was removed, not followed
+    QVERIFY(QFileInfo::exists(files.last().target));
+}
+
+void Ut_FileOperations::benchmarkCopy_data()
+{
+    testCopyData_data();
+}
+
+void Ut_FileOperations::benchmarkCopy()
+{
+    QFETCH(FileOperations::CopyMethod, preferred);
+    QFETCH(int, size);
+    // the rows of the test are reused, only the largest files are interesting here
+    if (size < 32 * 1024 * 1024)
+        QSKIP("Too small to measure");
+
+    const QString source = directory() + QStringLiteral("/benchmark-source");
+    const QString target = directory() + QStringLiteral("/benchmark-target");
+    QVERIFY(writeLargeFile(source, BenchmarkSize));
+
+    FileOperations::CopyMethod method = FileOperations::NoCopy;
+    qint64 elapsed = 0;
+    int iterations = 0;
+
+    QBENCHMARK {
+        QFile::remove(target);
+        sync();
+
+        QElapsedTimer timer;
+        timer.start();
+        const int srcFd = open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+        const int destFd = open(QFile::encodeName(target).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        const bool ok = FileOperations::copyData(srcFd, destFd, &method, preferred);
+        // include writing the data back, the page cache would hide the cost otherwise
+        fsync(destFd);
+        close(destFd);
+        close(srcFd);
+        elapsed += timer.nsecsElapsed();
+        ++iterations;
+
+        QVERIFY(ok);
+    }
+
+    QFile::remove(target);
+    QFile::remove(source);
+
+    qDebug() << "copied with method" << method << "at"
+             << (elapsed > 0 ? double(BenchmarkSize) * iterations / elapsed * 1000 : 0.0) << "MB/s";
+}
+
+void Ut_FileOperations::benchmarkCopyLatency_data()
+{
+    testCopyData_data();
+}
+
+void Ut_FileOperations::benchmarkCopyLatency()
+{
+    QFETCH(FileOperations::CopyMethod, preferred);
+    QFETCH(int, size);
+    if (size < 32 * 1024 * 1024)
+        QSKIP("Too small to measure");
+
+    const QString source = directory() + QStringLiteral("/benchmark-source");
+    const QString target = directory() + QStringLiteral("/benchmark-target");
+    const QString workingSet = directory() + QStringLiteral("/benchmark-working-set");
+    QVERIFY(writeLargeFile(source, BenchmarkSize));
+    QVERIFY(writeLargeFile(workingSet, 64 * 1024 * 1024));
+    QFile::remove(target);
+    sync();
+    // the application has its files in the cache when the copy starts
+    QVERIFY(readFile(workingSet).size() == 64 * 1024 * 1024);
+
+    LatencyProbe probe(workingSet);
+    probe.start();
+
+    FileOperations::CopyMethod method = FileOperations::NoCopy;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        QVERIFY(FileOperations::copyOverwrite(source, target, &method, FileOperations::BytesFunc(), preferred));
+        sync();
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    probe.stop();
+    probe.wait();
+
+    qDebug() << "copied with method" << method << "at"
+             << (elapsed > 0 ? double(BenchmarkSize) / elapsed * 1000 : 0.0) << "MB/s,"
+             << "application delays" << probe.mean() << "us mean" << probe.maximum() << "us maximum,"
+             << int(cachedShare(workingSet) * 100) << "% of its files still cached,"
+             << int(cachedShare(target) * 100) << "% of the copy cached";
+
+    QFile::remove(target);
+    QFile::remove(source);
+    QFile::remove(workingSet);
+}
+
+void Ut_FileOperations::benchmarkDelete_data()
+{
+    QTest::addColumn<QString>("engine");
+
+    QTest::newRow("QDir") << QStringLiteral("QDir");
+    QTest::newRow("TreeRemover") << QStringLiteral("TreeRemover");
+    QTest::newRow("io_uring") << QStringLiteral("io_uring");
+}
+
+void Ut_FileOperations::benchmarkDelete()
+{
+    QFETCH(QString, engine);
+    if (engine == QStringLiteral("io_uring") && !UringEngine::isAvailable())
+        QSKIP("io_uring not available");
+
+    // a cache directory of 100k small files
+    const QString tree = directory() + QStringLiteral("/delete");
+    for (int i = 0; i < 100; ++i) {
+        const QByteArray path = QFile::encodeName(tree + QStringLiteral("/%1").arg(i));
+        QVERIFY(QDir().mkpath(QFile::decodeName(path)));
+        for (int j = 0; j < 1000; ++j) {
+            const int fd = open((path + '/' + QByteArray::number(j)).constData(),
+                                O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+            QVERIFY(fd >= 0 && ::write(fd, "cache", 5) == 5);
+            close(fd);
+        }
+    }
+    sync();
+
+    QBENCHMARK_ONCE {
+        if (engine == QStringLiteral("QDir")) {
+            QVERIFY(QDir(tree).removeRecursively());
+        } else if (engine == QStringLiteral("TreeRemover")) {
+            QVERIFY(TreeRemover(tree).run());
+        } else {
+            UringEngine uring;
+            QVERIFY(uring.removeTree(tree));
+        }
+    }
+
+    QVERIFY(!QFileInfo::exists(tree));
+}
+
+void Ut_FileOperations::benchmarkCopyPipeline_data()
+{
+    QTest::addColumn<int>("concurrency");
+    QTest::addColumn<CopyPipeline::Backend>("backend");
+    QTest::addColumn<int>("fileSize");
+
+    const int concurrency = CopyPipeline::defaultConcurrency(CopyPipeline::deviceType(directory()));
+    const int sizes[] = { 4096, 16 * 1024 * 1024 };
+    for (int size : sizes) {
+        const QByteArray suffix = size > 4096 ? " large" : " small";
+        QTest::newRow("sequential" + suffix) << 1 << CopyPipeline::ThreadedBackend << size;
+        QTest::newRow("default" + suffix) << concurrency << CopyPipeline::ThreadedBackend << size;
+        QTest::newRow("8" + suffix) << 8 << CopyPipeline::ThreadedBackend << size;
+        QTest::newRow("io_uring" + suffix) << 1 << CopyPipeline::UringBackend << size;
+    }
+}
+
+void Ut_FileOperations::benchmarkCopyPipeline()
+{
+    QFETCH(int, concurrency);
+    QFETCH(CopyPipeline::Backend, backend);
+    if (backend == CopyPipeline::UringBackend && !UringEngine::isAvailable())
+        QSKIP("io_uring not available");
+    QFETCH(int, fileSize);
+
+    // 10k small files, or 16 large ones
+    const int directories = fileSize > 4096 ? 4 : 100;
+    const int files = directories;
+    const QString source = directory() + QStringLiteral("/pipeline-source");
+    const QString target = directory() + QStringLiteral("/pipeline-target");
+    if (!QFileInfo::exists(source)) {
+        const QByteArray data = testData(fileSize);
+        for (int i = 0; i < directories; ++i) {
+            const QString path = source + QStringLiteral("/%1").arg(i);
+            QVERIFY(QDir().mkpath(path));
+            for (int j = 0; j < files; ++j)
+                QVERIFY(writeFile(path + QStringLiteral("/%1").arg(j), data));
+        }
+    }
+
+    QBENCHMARK {
+        QDir(target).removeRecursively();
+        sync();
+
+        CopyPipeline pipeline(source, target);
+        pipeline.setConcurrency(concurrency);
+        pipeline.setBackend(backend);
+        QVERIFY(pipeline.run());
+        // include writing the files back, the page cache would hide the cost otherwise
+        sync();
+    }
+
+    const QString last = QStringLiteral("/%1/%2").arg(directories - 1).arg(files - 1);
+    QCOMPARE(readFile(target + last), testData(fileSize));
+
+    QDir(target).removeRecursively();
+    QDir(source).removeRecursively();
+}
+
+QTEST_MAIN(Ut_FileOperations)
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Jolla Ltd. nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef UT_FILEOPERATIONS_H
+#define UT_FILEOPERATIONS_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class Ut_FileOperations : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testCopyData_data();
+    void testCopyData();
+    void testCopyOverwrite();
+    void testCopySparse_data();
+    void testCopySparse();
+    void testProgress();
+    void testTreeScanner();
+    void testCopyPipeline();
+    void testMovePipeline();
+    void testMoveAcrossDevices();
+    void testTreeRemover();
+    void testTrash();
+    void testDeleteInBackground();
+    void testUringEngine();
+    void benchmarkCopy_data();
+    void benchmarkCopy();
+    void benchmarkCopyLatency_data();
+    void benchmarkCopyLatency();
+    void benchmarkDelete_data();
+    void benchmarkDelete();
+    void benchmarkCopyPipeline_data();
+    void benchmarkCopyPipeline();
+
+private:
+    QString directory() const;
+
+    QTemporaryDir m_directory;
+};
+
+#endif /* UT_FILEOPERATIONS_H */
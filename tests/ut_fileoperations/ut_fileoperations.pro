@@ -0,0 +1,53 @@
+include (../common.pri)
+
+QT += testlib
+QT -= gui
+
+TEMPLATE = app
+TARGET = ut_fileoperations
+
+target.path = /opt/tests/$${PACKAGENAME}
+
+contains(cov, true) {
+    message("Coverage options enabled")
+    QMAKE_CXXFLAGS += --coverage
+    QMAKE_LFLAGS += --coverage
+}
+
+CONFIG += link_pkgconfig link_prl
+
+packagesExist(liburing) {
+    DEFINES += HAS_LIBURING
+    PKGCONFIG += liburing
+}
+DEFINES += UNIT_TEST
+QMAKE_EXTRA_TARGETS = check
+
+check.depends = $$TARGET
+check.commands = LD_LIBRARY_PATH=../../../$$[QT_INSTALL_LIBS] ./$$TARGET
+
+INCLUDEPATH += ../../src/plugin/ ../../src/shared/
+
+SOURCES += ut_fileoperations.cpp
+HEADERS += ut_fileoperations.h
+
+SOURCES += ../../src/shared/copypipeline.cpp \
+    ../../src/shared/directoryreader.cpp \
+    ../../src/shared/fileoperations.cpp \
+    ../../src/shared/trash.cpp \
+    ../../src/shared/treeremover.cpp \
+    ../../src/shared/treescanner.cpp \
+    ../../src/shared/uringengine.cpp
+HEADERS += ../../src/shared/copypipeline.h \
+    ../../src/shared/directoryreader.h \
+    ../../src/shared/fileoperations.h \
+    ../../src/shared/trash.h \
+    ../../src/shared/treeremover.h \
+    ../../src/shared/treescanner.h \
+    ../../src/shared/uringengine.h
+
+benchmark.files = benchmark-copy.sh
+benchmark.path = /opt/tests/$${PACKAGENAME}
+OTHER_FILES += benchmark-copy.sh
+
+INSTALLS += target benchmark